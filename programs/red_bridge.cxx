@@ -1,10 +1,17 @@
 // Standard library:
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <iostream>
 #include <exception>
 #include <stdexcept>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Third party:
@@ -26,19 +33,97 @@
 // - SNFEE:
 #include <snfee/snfee.h>
 #include <snfee/snfee_version.h>
-#include <snfee/io/multifile_data_reader.h>
 #include <snfee/data/raw_event_data.h>
 #include <snfee/data/time.h>
 
-// global variables
-bool no_waveform = false;
-double run_sync_time = 0;
-double run_end_time = 86400*365.24;
-snemo::datamodel::timestamp previous_eh_timestamp;
-datatools::logger::priority logging = datatools::logger::PRIO_WARNING;
-
-bool do_red_to_udd_conversion(const snfee::data::raw_event_data,
-                              datatools::things &);
+// - SNREDBridge:
+#include <snredbridge/bounded_queue.h>
+#include <snredbridge/conversion_context.h>
+#include <snredbridge/event_digest.h>
+#include <snredbridge/event_selection.h>
+#include <snredbridge/file_utils.h>
+#include <snredbridge/hit_columns.h>
+#include <snredbridge/hit_pool.h>
+#include <snredbridge/red_index.h>
+#include <snredbridge/red_reader.h>
+#include <snredbridge/red_to_udd_conversion.h>
+#include <snredbridge/rtd2red_stream.h>
+#include <snredbridge/run_manifest.h>
+#include <snredbridge/red_udd_comparison.h>
+#include <snredbridge/run_metrics.h>
+#include <snredbridge/udd_writer.h>
+
+/// Configuration of the multithreaded conversion
+struct parallel_config
+{
+  std::size_t nworkers   = 1;  ///< Number of conversion workers
+  std::size_t batch_size = 16; ///< Number of events per work batch
+  std::size_t queue_size = 64; ///< Max number of batches in flight
+  bool recycle = false;        ///< Reuse the batches, event records and hits
+  bool validate = false;       ///< Compare each event record with its RED event
+  snredbridge::digest_file_writer * red_digests = nullptr; ///< RED event digests (optional)
+  snredbridge::digest_file_writer * udd_digests = nullptr; ///< Event record digests (optional)
+  snredbridge::run_metrics * metrics = nullptr;            ///< Stage timers and counters
+  snredbridge::progress_reporter * progress = nullptr;     ///< Periodic progress (optional)
+  snredbridge::hit_columns_writer * columns = nullptr;     ///< Columnar hit export (optional)
+  snredbridge::event_selection * selection = nullptr;      ///< Pre-conversion event selection (optional)
+};
+
+/// Configuration of the batch mode, shared by all the runs of a manifest
+struct batch_config
+{
+  std::size_t njobs = 1;                            ///< Max number of runs converted concurrently
+  snredbridge::conversion_context context;          ///< Conversion settings (sync and end times are set per run)
+  snredbridge::event_selection selection;           ///< Pre-conversion event selection
+  snredbridge::udd_writer::config_type writer_cfg;  ///< Output settings (the file name is set per run)
+  std::string output_codec;                         ///< Output codec (empty: from the UDD file extension)
+  uint64_t read_ahead_bytes = 0;                    ///< Size of the decompression ring of gzipped RED files
+  std::size_t data_count = 100000000;               ///< Max number of RED events per run
+  bool recycle = false;                             ///< Reuse the RED objects, event records and hits
+  bool validate = false;                            ///< Compare each event record with its RED event
+  bool write_digests = false;                       ///< Write the per-event digests next to each UDD file
+  double progress_period = 10.0;                    ///< Period of the per-run progress reports (0: none)
+  std::size_t expected_events = 0;                  ///< Expected number of RED events per run (0: unknown)
+};
+
+/// Result of a run of a batch
+struct batch_run_result
+{
+  bool ok = false;                    ///< The run was converted without error
+  std::string error;                  ///< Error message of a failed run
+  std::size_t red_counter = 0;        ///< Processed RED records
+  std::size_t udd_counter = 0;        ///< Stored event records
+  std::size_t rejected_counter = 0;   ///< RED events rejected by the selection
+  std::size_t non_equal_counter = 0;  ///< Event records not equivalent to their RED event (--validate)
+  std::size_t output_files = 0;       ///< Number of UDD output files
+  double seconds = 0;                 ///< Wall time
+};
+
+int run_batch(const std::string &, const batch_config &);
+
+void write_event_digests(const snredbridge::conversion_context &,
+                         const snfee::data::raw_event_data &,
+                         const datatools::things &,
+                         snredbridge::digest_file_writer &,
+                         snredbridge::digest_file_writer &);
+
+void run_sequential_conversion(snredbridge::red_reader &,
+                               snredbridge::udd_writer &,
+                               snredbridge::conversion_context &,
+                               const parallel_config &,
+                               const std::size_t,
+                               std::size_t &,
+                               std::size_t &,
+                               snredbridge::validation_summary &);
+
+void run_parallel_conversion(snredbridge::red_reader &,
+                             snredbridge::udd_writer &,
+                             snredbridge::conversion_context &,
+                             const parallel_config &,
+                             const std::size_t,
+                             std::size_t &,
+                             std::size_t &,
+                             snredbridge::validation_summary &);
 
 //----------------------------------------------------------------------
 // MAIN PROGRAM
@@ -46,11 +131,33 @@ bool do_red_to_udd_conversion(const snfee::data::raw_event_data,
 
 int main (int argc, char *argv[])
 {
+  datatools::logger::priority logging = datatools::logger::PRIO_WARNING;
   int error_code = EXIT_SUCCESS;
   try {
-  std::string input_filename = "";
+  std::vector<std::string> input_filenames;
   std::string output_filename = "";
+  snredbridge::udd_writer::config_type writer_cfg;
   size_t data_count = 100000000;
+  bool max_events_set = false;
+  snredbridge::conversion_context context;
+  snredbridge::event_selection selection;
+  int64_t first_event = -1;
+  int64_t last_event = -1;
+  std::string index_dir = "";
+  bool build_index_only = false;
+  std::size_t nthreads = 1;
+  bool recycle = false;
+  bool validate = false;
+  bool write_digests = false;
+  double progress_period = 10.0;
+  std::string report_filename = "";
+  std::string output_codec = "";
+  uint64_t read_ahead_bytes = 0;
+  std::string columns_prefix = "";
+  snredbridge::rtd2red_stream::config_type rtd2red_cfg;
+  std::string batch_filename = "";
+  std::size_t njobs = 0;
+  parallel_config par_cfg;
 
   for (int iarg=1; iarg<argc; ++iarg)
     {
@@ -64,22 +171,112 @@ int main (int argc, char *argv[])
             logging = datatools::logger::PRIO_INFORMATION;
 
           else if ((arg=="-i") || (arg=="--input"))
-            input_filename = std::string(argv[++iarg]);
+            input_filenames.push_back(std::string(argv[++iarg]));
+
+          else if (arg == "--rtd2red")
+            rtd2red_cfg.config_file = std::string(argv[++iarg]);
+
+          else if (arg == "--rtd2red-program")
+            rtd2red_cfg.program = std::string(argv[++iarg]);
+
+          else if (arg == "--red-copy")
+            rtd2red_cfg.red_copy = std::string(argv[++iarg]);
+
+          else if (arg == "--batch")
+            batch_filename = std::string(argv[++iarg]);
+
+          else if (arg == "--jobs")
+            njobs = std::strtoul(argv[++iarg], NULL, 10);
 
           else if ((arg=="-o") || (arg=="--output"))
             output_filename = std::string(argv[++iarg]);
 
           else if ((arg == "-n") || (arg == "--max-events"))
-            data_count = std::strtol(argv[++iarg], NULL, 10);
+            {
+              data_count = std::strtol(argv[++iarg], NULL, 10);
+              max_events_set = true;
+            }
+
+          else if (arg == "--first-event")
+            first_event = std::strtoll(argv[++iarg], NULL, 10);
+
+          else if (arg == "--last-event")
+            last_event = std::strtoll(argv[++iarg], NULL, 10);
+
+          else if (arg == "--index-dir")
+            index_dir = std::string(argv[++iarg]);
+
+          else if (arg == "--build-index")
+            build_index_only = true;
+
+          else if (arg == "--max-events-per-file")
+            writer_cfg.max_events_per_file = std::strtoul(argv[++iarg], NULL, 10);
+
+          else if (arg == "--max-size-per-file")
+            writer_cfg.max_bytes_per_file = snredbridge::parse_byte_size(argv[++iarg]);
+
+          else if (arg == "--codec")
+            output_codec = std::string(argv[++iarg]);
+
+          else if (arg == "--compression-level")
+            writer_cfg.compression_level = std::strtol(argv[++iarg], NULL, 10);
+
+          else if (arg == "--compression-threads")
+            writer_cfg.compression_threads = std::strtoul(argv[++iarg], NULL, 10);
+
+          else if (arg == "--write-index")
+            writer_cfg.write_index = true;
+
+          else if (arg == "--read-ahead")
+            read_ahead_bytes = snredbridge::parse_byte_size(argv[++iarg]);
 
           else if ((arg == "-no-wf") || (arg == "--no-waveform"))
-            no_waveform = true;
+            context.no_waveform = true;
+
+          else if (arg == "--waveform-roi")
+            snredbridge::parse_waveform_roi(argv[++iarg], context.waveform_roi);
+
+          else if (arg == "--waveform-delta")
+            context.waveform_roi.delta = true;
+
+          else if (arg == "--select")
+            selection.add_cut(argv[++iarg]);
 
           else if ((arg == "--sync-time") || (arg == "-s"))
-	    run_sync_time = std::strtod(argv[++iarg], NULL);
+	    context.run_sync_time = std::strtod(argv[++iarg], NULL);
+
+          else if (arg == "--start-time")
+            context.run_start_time = std::strtod(argv[++iarg], NULL);
 
           else if ((arg == "--end-time") || (arg == "-e"))
-	    run_end_time = std::strtod(argv[++iarg], NULL);
+	    context.run_end_time = std::strtod(argv[++iarg], NULL);
+
+          else if ((arg == "-t") || (arg == "--threads"))
+            nthreads = std::strtoul(argv[++iarg], NULL, 10);
+
+          else if (arg == "--recycle")
+            recycle = true;
+
+          else if (arg == "--validate")
+            validate = true;
+
+          else if (arg == "--write-digests")
+            write_digests = true;
+
+          else if (arg == "--columns")
+            columns_prefix = std::string(argv[++iarg]);
+
+          else if (arg == "--progress")
+            progress_period = std::strtod(argv[++iarg], NULL);
+
+          else if (arg == "--report")
+            report_filename = std::string(argv[++iarg]);
+
+          else if (arg == "--batch-size")
+            par_cfg.batch_size = std::strtoul(argv[++iarg], NULL, 10);
+
+          else if (arg == "--queue-size")
+            par_cfg.queue_size = std::strtoul(argv[++iarg], NULL, 10);
 
           else if (arg=="-h" || arg=="--help")
             {
@@ -87,10 +284,54 @@ int main (int argc, char *argv[])
               std::cout << "Usage:   " << argv[0] << " [options]" << std::endl;
               std::cout << std::endl;
               std::cout << "Options:   -h / --help" << std::endl;
-              std::cout << "           -i / --input       RED_FILE" << std::endl;
+              std::cout << "           -i / --input       RED_FILE (repeatable, accepts wildcards, or @LIST_FILE with one file per line)" << std::endl;
+              std::cout << "           --rtd2red CONFIG   Convert the RED events built by snfee-rtd2red -c CONFIG as they come, without" << std::endl;
+              std::cout << "                              an intermediate RED file (replaces -i; CONFIG uses @RED_FILE@ as RED output file)" << std::endl;
+              std::cout << "           --rtd2red-program PATH  RTD to RED builder program (default: snfee-rtd2red)" << std::endl;
+              std::cout << "           --red-copy FILE    With --rtd2red, also save the RED stream to FILE (.gz: parallel gzip)" << std::endl;
               std::cout << "           -o / --output      UDD_FILE" << std::endl;
+              std::cout << "           --batch MANIFEST   Convert the runs listed in MANIFEST in this process, one per line:" << std::endl;
+              std::cout << "                              INPUT OUTPUT SYNC_TIME [END_TIME] (replaces -i, -o, -s and -e)" << std::endl;
+              std::cout << "           --jobs N           With --batch, max number of runs converted concurrently" << std::endl;
+              std::cout << "                              (default: number of cores)" << std::endl;
               std::cout << "           -n / --max-events  Max number of events" << std::endl;
+              std::cout << "           -s / --sync-time   UNIX time (s) of the run TDC=0 reference" << std::endl;
+              std::cout << "           --start-time T     Skip the events before T seconds from the sync time (uses the RED index files)" << std::endl;
+              std::cout << "           -e / --end-time T  Stop at the first event after T seconds from the sync time" << std::endl;
+              std::cout << "           --first-event ID   First event ID to convert (uses the RED index files)" << std::endl;
+              std::cout << "           --last-event ID    Last event ID to convert (uses the RED index files)" << std::endl;
+              std::cout << "           --index-dir DIR    Directory of the RED index files (default: next to the RED files)" << std::endl;
+              std::cout << "           --build-index      Only build (or refresh) the RED index files and exit" << std::endl;
+              std::cout << "           --max-events-per-file N  Split the output into UDD_FILE stem_NNNN.ext files of N events" << std::endl;
+              std::cout << "           --max-size-per-file SIZE Split the output into files of about SIZE bytes (k/M/G suffix allowed)" << std::endl;
+              std::cout << "           --codec NAME       Output format/compression: brio, none (.data), gzip (.data.gz) or bzip2 (.data.bz2)" << std::endl;
+              std::cout << "                              (default: from the UDD_FILE extension)" << std::endl;
+              std::cout << "           --compression-level N   Gzip level (0-9) of gzip outputs" << std::endl;
+              std::cout << "           --compression-threads N Number of threads compressing gzip outputs (default: 1)" << std::endl;
+              std::cout << "           --write-index      Write the index of the event records of each output file to UDD_FILE.idx" << std::endl;
+              std::cout << "                              (run/event IDs, timestamps and record ranks, for random access)" << std::endl;
+              std::cout << "           --read-ahead SIZE  Decompress the gzipped RED files on a dedicated thread, up to SIZE bytes" << std::endl;
+              std::cout << "                              ahead of the reader (k/M/G suffix allowed, e.g. 64M)" << std::endl;
               std::cout << "           -no-wf / --no-waveform Do not save the waveform from RED to UDD" << std::endl;
+              std::cout << "           --waveform-roi PRE:POST Only save the waveform samples from PRE samples before the rising" << std::endl;
+              std::cout << "                              cell to POST samples after the falling cell (e.g. 32:96)" << std::endl;
+              std::cout << "           --waveform-delta   Save the waveform samples as differences with the previous sample" << std::endl;
+              std::cout << "           --select CUT       Only convert the RED events passing a cut (repeatable, all cuts must pass):" << std::endl;
+              std::cout << "                              calo_hits=MIN:MAX, tracker_hits=MIN:MAX, trigger_decision=D1,D2...," << std::endl;
+              std::cout << "                              om=LIST, cell=LIST (e.g. 0-259,520) or time=MIN:MAX (s from TDC=0)" << std::endl;
+              std::cout << "           -t / --threads     Number of threads (>=2 runs read, conversion and write in a pipeline," << std::endl;
+              std::cout << "                              with N-2 conversion workers when N>=3)" << std::endl;
+              std::cout << "           --write-digests    Write the per-event digests of the RED events and of the event records" << std::endl;
+              std::cout << "                              to UDD_FILE.red.digest and UDD_FILE.udd.digest (the event record" << std::endl;
+              std::cout << "                              digests are taken before writing: they do not check the stored file)" << std::endl;
+              std::cout << "           --columns PREFIX   Also write the calo hits and tracker GG times as memory-mappable" << std::endl;
+              std::cout << "                              column files PREFIX.calo.cols and PREFIX.tracker.cols" << std::endl;
+              std::cout << "           --progress SECONDS Period of the progress reports (default: 10, 0 disables them)" << std::endl;
+              std::cout << "           --report FILE      Write the stage timings and counters to FILE (JSON)" << std::endl;
+              std::cout << "           --batch-size       Number of events per conversion batch (default: 16)" << std::endl;
+              std::cout << "           --queue-size       Max number of batches in flight (default: 64)" << std::endl;
+              std::cout << "           --recycle          Reuse RED objects, event records and UDD hits from one event to the next" << std::endl;
+              std::cout << "           --validate         Compare each produced event record with its RED event (as red_bridge_validation)" << std::endl;
               std::cout << "           -v / --verbose     More logs" << std::endl;
               std::cout << "           -d / --debug       Debug logs" << std::endl;
               std::cout << std::endl;
@@ -102,16 +343,67 @@ int main (int argc, char *argv[])
         }
     }
 
-  if (input_filename.empty())
+  if (!batch_filename.empty())
+    {
+      // The run settings come from the manifest, the other options apply
+      // to all the runs
+      if (!input_filenames.empty() || !output_filename.empty() || !rtd2red_cfg.config_file.empty()
+          || build_index_only || first_event >= 0 || last_event >= 0 || context.run_start_time > 0
+          || nthreads >= 2 || !columns_prefix.empty() || !report_filename.empty())
+        {
+          std::cerr << "*** ERROR: --batch cannot be used with -i, -o, --rtd2red, --build-index, --first-event,"
+                    << " --last-event, --start-time, -t, --columns or --report !" << std::endl;
+          return 1;
+        }
+      batch_config batch_cfg;
+      batch_cfg.njobs = (njobs > 0) ? njobs : std::max(1U, std::thread::hardware_concurrency());
+      context.logging = logging;
+      batch_cfg.context = context;
+      batch_cfg.selection = selection;
+      batch_cfg.writer_cfg = writer_cfg;
+      batch_cfg.output_codec = output_codec;
+      batch_cfg.read_ahead_bytes = read_ahead_bytes;
+      batch_cfg.data_count = data_count;
+      batch_cfg.recycle = recycle;
+      batch_cfg.validate = validate;
+      batch_cfg.write_digests = write_digests;
+      batch_cfg.progress_period = progress_period;
+      if (max_events_set) batch_cfg.expected_events = data_count;
+      // SNFEE, Bayeux and Falaise are initialized once for all the runs
+      snfee::initialize();
+      error_code = run_batch(batch_filename, batch_cfg);
+      snfee::terminate();
+      return error_code;
+    }
+
+  const bool rtd2red = !rtd2red_cfg.config_file.empty();
+  if (input_filenames.empty() && !rtd2red)
     {
       std::cerr << "*** ERROR: missing input filename !" << std::endl;
       return 1;
     }
 
-  if (run_sync_time == 0)
+  if (rtd2red && (!input_filenames.empty() || build_index_only || first_event >= 0 || last_event >= 0
+                  || context.run_start_time > 0))
+    {
+      // The RED stream is neither a file on disk nor indexed
+      std::cerr << "*** ERROR: --rtd2red cannot be used with -i, --build-index, --first-event, --last-event"
+                << " or --start-time !" << std::endl;
+      return 1;
+    }
+  if (!rtd2red && !rtd2red_cfg.red_copy.empty())
+    {
+      std::cerr << "*** ERROR: --red-copy needs --rtd2red !" << std::endl;
+      return 1;
+    }
+
+  context.logging = logging;
+  rtd2red_cfg.logging = logging;
+
+  if (context.run_sync_time == 0 && !build_index_only)
     {
       // call the DB to find run SYNC time
-      std::cerr << "*** ERROR: missing start time (-s/--start-time UNIX.TIME)!" << std::endl;
+      std::cerr << "*** ERROR: missing sync time (-s/--sync-time UNIX.TIME)!" << std::endl;
       return 1;
     }
 
@@ -121,23 +413,70 @@ int main (int argc, char *argv[])
   snfee::initialize();
 
   /// Configuration for raw data reader
-  snfee::io::multifile_data_reader::config_type reader_cfg;
-  reader_cfg.filenames.push_back(input_filename);
+  const std::vector<std::string> red_filenames = snredbridge::expand_filenames(input_filenames);
+  for (const auto & red_filename : red_filenames)
+    DT_LOG_INFORMATION(logging, "RED input file : '" << red_filename << "'");
+
+  if (build_index_only)
+    {
+      for (const auto & red_filename : red_filenames)
+        {
+          const snredbridge::red_index index = snredbridge::red_index::fetch(red_filename, index_dir, logging);
+          std::cout << red_filename << " : " << index.size() << " records" << std::endl;
+        }
+      snfee::terminate();
+      return 0;
+    }
+
+  // The RTD to RED builder streams its RED output through a named pipe,
+  // read as a single RED file
+  std::unique_ptr<snredbridge::rtd2red_stream> rtd2red_source;
+  if (rtd2red)
+    {
+      rtd2red_cfg.copy_compression_level = (writer_cfg.compression_level >= 0) ? writer_cfg.compression_level : 6;
+      rtd2red_cfg.copy_compression_threads = writer_cfg.compression_threads;
+      rtd2red_source.reset(new snredbridge::rtd2red_stream(rtd2red_cfg));
+      DT_LOG_INFORMATION(logging, "RED input stream : '" << rtd2red_source->get_filename() << "' from '"
+                         << rtd2red_cfg.program << " -c " << rtd2red_cfg.config_file << "'");
+    }
+
+  snredbridge::red_reader::config_type reader_cfg;
+  if (rtd2red)
+    reader_cfg.filenames.push_back(rtd2red_source->get_filename());
+  else if (first_event >= 0 || last_event >= 0 || context.run_start_time > 0)
+    {
+      // Use the RED index files to only read the requested event range and
+      // time window: the files out of them are not opened and the records
+      // before them are skipped without being converted
+      reader_cfg = snredbridge::red_reader::select_records(red_filenames, first_event, last_event,
+                                                           context.run_start_time, context.run_end_time,
+                                                           index_dir, logging);
+      if (reader_cfg.has_previous_reference_time)
+        context.previous_eh_timestamp = snredbridge::make_event_timestamp(context, reader_cfg.previous_reference_time);
+    }
+  else
+    reader_cfg.filenames = red_filenames;
+  reader_cfg.read_ahead_bytes = read_ahead_bytes;
+  // The reading stops at the first RED event after the end time
+  if (context.run_start_time > 0) reader_cfg.start_time = context.run_start_time;
+  reader_cfg.end_time = context.run_end_time;
 
   // Declare the reader
   DT_LOG_DEBUG(logging, "Instantiate the RED reader");
-  snfee::io::multifile_data_reader red_source(reader_cfg);
+  snredbridge::red_reader red_source(reader_cfg);
 
   // Declare the writer
-  DT_LOG_DEBUG(logging, "Instantiate the DPP writer output module");
-
-  // The output module:
-  dpp::output_module writer;
-  writer.set_logging_priority(datatools::logger::PRIO_FATAL);
-  writer.set_name("Writer output module");
-  writer.set_description("Output module for the datatools::things event_record");
-  writer.set_preserve_existing_output(false); // Allowed to erase existing output file
-  writer.set_single_output_file(output_filename);
+  DT_LOG_DEBUG(logging, "Instantiate the UDD writer");
+
+  // The UDD writer (DPP output module(s)):
+  snredbridge::udd_writer writer;
+  if (!output_codec.empty())
+    output_filename = snredbridge::udd_writer::make_codec_filename(output_filename, output_codec);
+  writer_cfg.filename = output_filename;
+  const bool gzip_output = output_filename.size() > 3
+    && output_filename.compare(output_filename.size() - 3, 3, ".gz") == 0;
+  if ((writer_cfg.compression_level >= 0 || writer_cfg.compression_threads > 1) && !gzip_output)
+    DT_LOG_WARNING(logging, "Compression level and threads only apply to gzip outputs!");
 
   // // Store metadata
   // datatools::multi_properties & writer_metadata = writer.grab_metadata_store();
@@ -174,45 +513,65 @@ int main (int argc, char *argv[])
   // writer_metadata.tree_dump();
 
   //
-  writer.initialize_simple();
+  writer.initialize(writer_cfg);
   DT_LOG_DEBUG(logging, "Initialization of the output module is done.");
 
+  // Per-event digest files, used by red_bridge_validation to only
+  // deep-compare the events whose digests differ
+  std::unique_ptr<snredbridge::digest_file_writer> red_digests;
+  std::unique_ptr<snredbridge::digest_file_writer> udd_digests;
+  if (write_digests)
+    {
+      red_digests.reset(new snredbridge::digest_file_writer(output_filename + ".red.digest", !context.no_waveform));
+      udd_digests.reset(new snredbridge::digest_file_writer(output_filename + ".udd.digest", !context.no_waveform));
+    }
+
+  // Columnar export of the hits, written in the same pass
+  std::unique_ptr<snredbridge::hit_columns_writer> columns;
+  if (!columns_prefix.empty())
+    columns.reset(new snredbridge::hit_columns_writer(columns_prefix));
+
   // RED counter
   std::size_t red_counter = 0;
 
   // UDD counter
   std::size_t udd_counter = 0;
 
-  while (red_source.has_record_tag() && red_counter < data_count)
-    {
-      // Check the serialization tag of the next record:
-      DT_THROW_IF(!red_source.record_tag_is(snfee::data::raw_event_data::SERIAL_TAG),
-                  std::logic_error, "Unexpected record tag '" << red_source.get_record_tag() << "'!");
-
-      // Empty working RED object
-      snfee::data::raw_event_data red;
-
-      // Load the next RED object:
-      red_source.load(red);
-      red_counter++;
+  // Validation counters
+  snredbridge::validation_summary validation;
 
-      datatools::things event_record;
-
-      // Do the RED to UDD conversion
-      if (!do_red_to_udd_conversion(red, event_record))
-	break;
-
-      // Write the event record
-      dpp::base_module::process_status status = writer.process(event_record);
-
-      udd_counter++;
-      DT_LOG_DEBUG(logging, "Exit do_red_to_udd_conversion");
-
-      // Smart print :
-      // event_record.tree_dump(std::clog, "The event data record composed by EH and UDD banks.");
-
-
-    } // (while red_source.has_record_tag())
+  // Stage timers, counters and progress reports. The expected number of
+  // events (for the ETA) is known from the selected ranges or from -n
+  snredbridge::run_metrics metrics;
+  metrics.nthreads = nthreads;
+  for (const auto & red_filename : reader_cfg.filenames)
+    {
+      const int64_t red_size = snredbridge::file_size(red_filename);
+      if (red_size > 0) metrics.bytes_in += red_size;
+    }
+  std::size_t expected_events = 0;
+  for (const auto & range : reader_cfg.ranges) expected_events += range.end - range.begin;
+  if (max_events_set && (expected_events == 0 || data_count < expected_events))
+    expected_events = data_count;
+  snredbridge::progress_reporter progress(progress_period, expected_events);
+
+  par_cfg.recycle = recycle;
+  par_cfg.validate = validate;
+  par_cfg.red_digests = red_digests.get();
+  par_cfg.udd_digests = udd_digests.get();
+  par_cfg.metrics = &metrics;
+  par_cfg.progress = &progress;
+  par_cfg.columns = columns.get();
+  par_cfg.selection = selection.is_active() ? &selection : nullptr;
+  if (nthreads >= 2)
+    {
+      par_cfg.nworkers = (nthreads > 2) ? nthreads - 2 : 1;
+      DT_LOG_INFORMATION(logging, "Running pipelined read/convert/write stages with "
+                         << par_cfg.nworkers << " conversion worker(s)");
+      run_parallel_conversion(red_source, writer, context, par_cfg, data_count, red_counter, udd_counter, validation);
+    }
+  else
+    run_sequential_conversion(red_source, writer, context, par_cfg, data_count, red_counter, udd_counter, validation);
 
 
   // Check input RED file and output UDD file and count the number of events in each file
@@ -221,11 +580,66 @@ int main (int argc, char *argv[])
   // Read UDD file here
 
 
+  // Close the last output file
+  writer.terminate();
+  // Stop reading the RED stream, then wait for its builder (and copy)
+  red_source.close();
+  if (rtd2red_source)
+    rtd2red_source->close();
+  if (write_digests)
+    {
+      red_digests->close();
+      udd_digests->close();
+    }
+  if (columns)
+    columns->close();
+  for (const auto & udd_filename : writer.get_filenames())
+    {
+      const int64_t udd_size = snredbridge::file_size(udd_filename);
+      if (udd_size > 0) metrics.bytes_out += udd_size;
+    }
+
   std::cout << "Results :" << std::endl;
   std::cout << "- Worker #0 (input RED)"  << std::endl;
   std::cout << "  - Processed records : " << red_counter << std::endl;
+  if (red_source.get_number_of_skipped_records() > 0)
+    std::cout << "  - Skipped records   : " << red_source.get_number_of_skipped_records() << std::endl;
   std::cout << "- Worker #1 (output UDD)" << std::endl;
   std::cout << "  - Stored records    : " << udd_counter << std::endl;
+  std::cout << "  - Output files      : " << writer.get_filenames().size() << std::endl;
+  if (writer.is_rolling())
+    for (const auto & udd_filename : writer.get_filenames())
+      std::cout << "    - " << udd_filename << std::endl;
+  if (write_digests)
+    std::cout << "  - Digest files      : " << output_filename << ".{red,udd}.digest" << std::endl;
+  if (writer_cfg.write_index)
+    std::cout << "  - Index files       : " << writer.get_filenames().size() << " (UDD_FILE.idx)" << std::endl;
+  if (columns)
+    std::cout << "  - Column files      : " << columns_prefix << ".{calo,tracker}.cols" << std::endl;
+
+  if (selection.is_active())
+    {
+      std::cout << "Selection (before conversion) :" << std::endl;
+      selection.print(std::cout);
+    }
+
+  if (validate)
+    {
+      std::cout << "Validation (RED events compared with the produced event records) :" << std::endl;
+      validation.print(std::cout);
+    }
+
+  const double elapsed = metrics.get_elapsed_seconds();
+  std::cout << "Timing :" << std::endl;
+  std::cout << "- Wall time           : " << elapsed << " s ("
+            << (elapsed > 0 ? udd_counter / elapsed : 0.0) << " events/s)" << std::endl;
+  std::cout << "- RED read            : " << metrics.read.get_seconds() << " s" << std::endl;
+  std::cout << "- Conversion          : " << metrics.convert.get_seconds() << " s" << std::endl;
+  if (validate)
+    std::cout << "- Validation          : " << metrics.validate.get_seconds() << " s" << std::endl;
+  std::cout << "- UDD write           : " << metrics.write.get_seconds() << " s" << std::endl;
+  if (!report_filename.empty())
+    metrics.store_json(report_filename);
 
   snfee::terminate();
 
@@ -247,241 +661,515 @@ int main (int argc, char *argv[])
 
 
 
-bool do_red_to_udd_conversion(const snfee::data::raw_event_data red_,
-                              datatools::things & event_record_)
+void run_sequential_conversion(snredbridge::red_reader & red_source_,
+                               snredbridge::udd_writer & writer_,
+                               snredbridge::conversion_context & context_,
+                               const parallel_config & config_,
+                               const std::size_t data_count_,
+                               std::size_t & red_counter_,
+                               std::size_t & udd_counter_,
+                               snredbridge::validation_summary & validation_)
 {
-  // Run number
-  int32_t red_run_id   = red_.get_run_id();
-
-  // Event number
-  int32_t red_event_id = red_.get_event_id();
-
-  // Container of merged TriggerID(s) by event builder
-  const std::set<int32_t> & red_trigger_ids = red_.get_origin_trigger_ids();
-
-  // RED Digitized trigger hits
-  const std::vector<snfee::data::trigger_record> red_trigger_hits = red_.get_trigger_records();
-
-  // RED Digitized calo hits
-  const std::vector<snfee::data::calo_digitized_hit> red_calo_hits = red_.get_calo_hits();
-
-  // RED Digitized tracker hits
-  const std::vector<snfee::data::tracker_digitized_hit> red_tracker_hits = red_.get_tracker_hits();
-
-  // Print RED infos
-  // std::cout << "Event #" << red_event_id << " contains "
-  //           << red_trigger_ids.size() << " TriggerID(s) with "
-  //           << red_calo_hits.size() << " calo hit(s) and "
-  //           << red_tracker_hits.size() << " tracker hit(s)"
-  //           << std::endl;
-
-  std::string EH_output_tag  = "EH";
-  std::string UDD_output_tag = "UDD";
-
-  // Empty working EH object
-  // auto & EH = snedm::addToEvent<snemo::datamodel::event_header>(EH_output_tag, event_record_);
-  auto & EH = event_record_.add<snemo::datamodel::event_header>(EH_output_tag);
-
-  // Empty working UDD object
-  // auto & UDD = snedm::addToEvent<snemo::datamodel::unified_digitized_data>(UDD_output_tag, event_record_);
-  auto & UDD = event_record_.add<snemo::datamodel::unified_digitized_data>(UDD_output_tag);
-
-  // Fill Event Header based on RED attributes
-  EH.get_id().set_run_number(red_run_id);
-  EH.get_id().set_event_number(red_event_id);
-  EH.set_generation(snemo::datamodel::event_header::GENERATION_REAL);
-
-  // Set the event timestamp
-  const snfee::data::timestamp & reference_timestamp = red_.get_reference_time();
-  const double reference_time = (reference_timestamp.get_ticks() * snfee::data::clock_period(reference_timestamp.get_clock()))/CLHEP::second;
-  const double event_time = run_sync_time + reference_time;
-  const int64_t event_time_sec = std::floor(event_time);
-  const int64_t event_time_psec = std::floor(1E12*(event_time-event_time_sec));
-  EH.get_timestamp().set_seconds(event_time_sec);
-  EH.get_timestamp().set_picoseconds(event_time_psec);
-
-  if (reference_time > run_end_time)
-    return false;
-
-  // Transfer RED properties to EH one
-  EH.set_properties(red_.get_auxiliaries());
-
-  // Compute and store deltat to the previous event
-  const snemo::datamodel::timestamp & eh_timestamp = EH.get_timestamp();
-  double deltat_previous_event = 0;
-  if (previous_eh_timestamp.is_valid()) {
-    deltat_previous_event = eh_timestamp.get_seconds() - previous_eh_timestamp.get_seconds();
-    deltat_previous_event += 1E-12 * (eh_timestamp.get_picoseconds() - previous_eh_timestamp.get_picoseconds());
-  }
+  // In recycling mode, the RED object, the event record and its banks
+  // are kept from one event to the next and UDD hits come from pools
+  snredbridge::conversion_pools pools;
+  snredbridge::conversion_pools * hit_pools = config_.recycle ? &pools : nullptr;
+  std::unique_ptr<snfee::data::raw_event_data> red_ptr;
+  std::unique_ptr<datatools::things> event_record_ptr;
+
+  while (red_counter_ < data_count_)
+    {
+      // Empty working RED object
+      if (!config_.recycle || !red_ptr) red_ptr.reset(new snfee::data::raw_event_data);
+      snfee::data::raw_event_data & red = *red_ptr;
+
+      // Load the next RED object (the serialization tag is checked by the reader):
+      {
+        snredbridge::scoped_stage_timer timer(&config_.metrics->read);
+        if (!red_source_.load_next(red)) break;
+      }
+      red_counter_++;
+      config_.metrics->events_in++;
+      if (config_.progress != nullptr) config_.progress->update(red_counter_, udd_counter_);
+      // The time to the previous event also counts the records skipped by the reader
+      if (red_source_.has_skipped_record())
+        snredbridge::skip_deltat_previous_event(context_, red_source_.get_last_skipped_reference_time());
+
+      // Inspect the RED event before building anything
+      if (config_.selection != nullptr)
+        {
+          const int rejecting_cut = config_.selection->find_rejecting_cut(red);
+          config_.selection->count(rejecting_cut);
+          if (rejecting_cut >= 0)
+            {
+              config_.metrics->events_rejected++;
+              // The time to the previous event counts the rejected events
+              snredbridge::skip_deltat_previous_event(context_, snredbridge::reference_time_in_seconds(red.get_reference_time()));
+              continue;
+            }
+        }
 
-  if (deltat_previous_event < 0)
-    DT_LOG_WARNING(logging, "negative deltat (" << deltat_previous_event << " sec) for event #" << red_event_id);
+      if (!config_.recycle || !event_record_ptr) event_record_ptr.reset(new datatools::things);
+      datatools::things & event_record = *event_record_ptr;
+
+      // Do the RED to UDD conversion
+      bool accepted = false;
+      {
+        snredbridge::scoped_stage_timer timer(&config_.metrics->convert);
+        accepted = snredbridge::do_red_to_udd_conversion(context_, red, event_record, hit_pools);
+      }
+      if (!accepted)
+        break;
+      config_.metrics->add_event_record(event_record);
+
+      if (config_.red_digests != nullptr)
+        write_event_digests(context_, red, event_record, *config_.red_digests, *config_.udd_digests);
+
+      if (config_.validate)
+        {
+          snredbridge::scoped_stage_timer timer(&config_.metrics->validate);
+          const bool equivalent = snredbridge::compare_red_event_record(red, event_record, context_.logging, context_.no_waveform);
+          if (!equivalent)
+            DT_LOG_WARNING(context_.logging, "Event record is not equivalent to RED event #" << red.get_event_id());
+          validation_.add_compared_event(equivalent);
+        }
+      snredbridge::fill_deltat_previous_event(context_, event_record);
 
-  EH.get_properties().store("deltat_previous_event", deltat_previous_event*CLHEP::second);
-  previous_eh_timestamp = EH.get_timestamp();
+      // Write the event record
+      {
+        snredbridge::scoped_stage_timer timer(&config_.metrics->write);
+        writer_.process(event_record);
+        if (config_.columns != nullptr) config_.columns->write(event_record);
+      }
 
-  // // Store event time width
-  // if (red_.get_auxiliaries().has_key("time_width"))
-  //   EH.get_properties().store_real("time_width", red_.get_auxiliaries().fetch_real("time_width"));
+      udd_counter_++;
+      config_.metrics->events_out++;
+      DT_LOG_DEBUG(context_.logging, "Exit do_red_to_udd_conversion");
 
-  // // Store first hit time
-  // if (red_.get_auxiliaries().has_key("first_hit_time"))
-  //   EH.get_properties().store_real("first_hit_time", red_.get_auxiliaries().fetch_real("first_hit_time"));
+      // Smart print :
+      // event_record.tree_dump(std::clog, "The event data record composed by EH and UDD banks.");
+    } // (while red_counter_ < data_count_)
+  return;
+}
 
-  // Store trigger info
-  datatools::properties::data::vint trigger_id_vint;
-  datatools::properties::data::vint trigger_decision_vint;
-  datatools::properties::data::vint progenitor_trigger_id_vint;
+void run_parallel_conversion(snredbridge::red_reader & red_source_,
+                             snredbridge::udd_writer & writer_,
+                             snredbridge::conversion_context & context_,
+                             const parallel_config & config_,
+                             const std::size_t data_count_,
+                             std::size_t & red_counter_,
+                             std::size_t & udd_counter_,
+                             snredbridge::validation_summary & validation_)
+{
+  // The reader thread groups RED events into numbered batches, a pool of
+  // workers converts each batch into its own event records and the writer
+  // (current thread) puts the converted batches back in order through a
+  // reorder buffer. The deltat_previous_event chaining is done by the
+  // writer, in event order, just before storing each event record.
+  //
+  // In recycling mode, the writer gives the written batches back to the
+  // reader, which refills them: RED objects and event records (with their
+  // banks) live as long as the run.
+  struct work_batch
+  {
+    std::size_t seq = 0;
+    std::size_t size = 0;
+    std::vector<snfee::data::raw_event_data> reds;
+    std::vector<std::unique_ptr<datatools::things>> records;
+    std::vector<bool> accepted;
+    std::vector<bool> equivalent;
+    std::vector<uint64_t> red_digests;
+    struct rejected_event
+    {
+      std::size_t slot = 0;       // Slot of the next event
+      int cut = -1;               // Rejecting cut (-1 for records skipped by the reader)
+      double reference_time = 0;  // Reference time (s)
+    };
+    std::vector<rejected_event> rejected;
+  };
+  typedef std::unique_ptr<work_batch> batch_ptr_type;
+  const std::size_t batch_size = (config_.batch_size == 0) ? 1 : config_.batch_size;
+  const std::size_t max_in_flight = (config_.queue_size < config_.nworkers) ? config_.nworkers : config_.queue_size;
+  snredbridge::bounded_queue<batch_ptr_type> todo_queue(max_in_flight);
+  snredbridge::bounded_queue<batch_ptr_type> done_queue(max_in_flight);
+  snredbridge::bounded_queue<batch_ptr_type> free_queue(max_in_flight);
+
+  // Limit the number of batches between the reader and the writer so that
+  // a slow batch cannot make the reorder buffer grow without bound
+  std::mutex flight_mutex;
+  std::condition_variable flight_cv;
+  std::size_t in_flight = 0;
+  bool stopping = false;
+  auto stop_all = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(flight_mutex);
+      stopping = true;
+    }
+    flight_cv.notify_all();
+    todo_queue.close();
+    done_queue.close();
+  };
+
+  std::exception_ptr reader_error;
+  std::vector<std::exception_ptr> worker_errors(config_.nworkers);
+
+  // Stage #0 : load (and decompress) RED records
+  std::thread reader_thread([&]() {
+      try {
+        std::size_t nloaded = 0;
+        std::size_t seq = 0;
+        bool end_of_input = false;
+        while (!end_of_input && nloaded < data_count_)
+          {
+            {
+              std::unique_lock<std::mutex> lock(flight_mutex);
+              flight_cv.wait(lock, [&] { return stopping || in_flight < max_in_flight; });
+              if (stopping) break;
+              in_flight++;
+            }
+            batch_ptr_type batch;
+            if (!config_.recycle || !free_queue.try_pop(batch)) {
+              batch.reset(new work_batch);
+              batch->reds.reserve(batch_size);
+            }
+            batch->seq = seq++;
+            batch->size = 0;
+            batch->rejected.clear();
+            while (batch->size < batch_size && nloaded < data_count_)
+              {
+                if (batch->reds.size() == batch->size) batch->reds.emplace_back();
+                snredbridge::scoped_stage_timer timer(&config_.metrics->read);
+                if (!red_source_.load_next(batch->reds[batch->size]))
+                  {
+                    end_of_input = true;
+                    break;
+                  }
+                nloaded++;
+                config_.metrics->events_in++;
+                if (red_source_.has_skipped_record())
+                  {
+                    work_batch::rejected_event skipped;
+                    skipped.slot = batch->size;
+                    skipped.reference_time = red_source_.get_last_skipped_reference_time();
+                    batch->rejected.push_back(skipped);
+                  }
+                // Rejected events are not converted, their slot is reused
+                if (config_.selection != nullptr)
+                  {
+                    const snfee::data::raw_event_data & red = batch->reds[batch->size];
+                    const int rejecting_cut = config_.selection->find_rejecting_cut(red);
+                    if (rejecting_cut >= 0)
+                      {
+                        work_batch::rejected_event rejected;
+                        rejected.slot = batch->size;
+                        rejected.cut = rejecting_cut;
+                        rejected.reference_time = snredbridge::reference_time_in_seconds(red.get_reference_time());
+                        batch->rejected.push_back(rejected);
+                        continue;
+                      }
+                  }
+                batch->size++;
+              }
+            if (!todo_queue.push(std::move(batch))) break;
+          }
+      }
+      catch (...) {
+        reader_error = std::current_exception();
+        stop_all();
+      }
+      todo_queue.close();
+    });
+
+  // Stage #1 : RED to UDD conversion workers
+  std::size_t running_workers = config_.nworkers;
+  std::mutex workers_mutex;
+  std::vector<std::thread> worker_threads;
+  for (std::size_t iworker = 0; iworker < config_.nworkers; iworker++)
+    {
+      worker_threads.emplace_back([&, iworker]() {
+          try {
+            snredbridge::conversion_pools pools;
+            snredbridge::conversion_pools * hit_pools = config_.recycle ? &pools : nullptr;
+            const bool with_digests = (config_.red_digests != nullptr);
+            batch_ptr_type batch;
+            while (todo_queue.pop(batch))
+              {
+                const std::size_t nevents = batch->size;
+                batch->accepted.assign(nevents, false);
+                batch->equivalent.assign(nevents, false);
+                if (with_digests) batch->red_digests.assign(nevents, 0);
+                for (std::size_t ievent = 0; ievent < nevents; ievent++)
+                  {
+                    if (batch->records.size() == ievent) batch->records.emplace_back(new datatools::things);
+                    const snfee::data::raw_event_data & red = batch->reds[ievent];
+                    datatools::things & event_record = *batch->records[ievent];
+                    if (with_digests)
+                      batch->red_digests[ievent] = snredbridge::digest_red_event(red, !context_.no_waveform,
+                                                                                                 &context_.waveform_roi);
+                    {
+                      snredbridge::scoped_stage_timer timer(&config_.metrics->convert);
+                      batch->accepted[ievent] = snredbridge::do_red_to_udd_conversion(context_, red, event_record,
+                                                                                      hit_pools);
+                    }
+                    // Events after the end of the run time window are not converted
+                    if (!batch->accepted[ievent]) break;
+                    config_.metrics->add_event_record(event_record);
+                    if (config_.validate)
+                      {
+                        snredbridge::scoped_stage_timer timer(&config_.metrics->validate);
+                        batch->equivalent[ievent] = snredbridge::compare_red_event_record(red, event_record,
+                                                                                          context_.logging,
+                                                                                          context_.no_waveform);
+                      }
+                  }
+                if (!config_.recycle) batch->reds.clear();
+                if (!done_queue.push(std::move(batch))) break;
+              }
+          }
+          catch (...) {
+            worker_errors[iworker] = std::current_exception();
+            stop_all();
+          }
+          std::lock_guard<std::mutex> lock(workers_mutex);
+          if (--running_workers == 0) done_queue.close();
+        });
+    }
 
-  for (const auto & red_trigger_hit : red_trigger_hits) {
-    trigger_id_vint.push_back(red_trigger_hit.get_trigger_id());
-    trigger_decision_vint.push_back(red_trigger_hit.get_trigger_decision());
-    if (red_trigger_hit.has_progenitor_trigger_id())
-      progenitor_trigger_id_vint.push_back(red_trigger_hit.get_progenitor_trigger_id());
-    else progenitor_trigger_id_vint.push_back(-1);
+  // Stage #2 : reorder, chain and write the event records (current thread)
+  std::exception_ptr writer_error;
+  try {
+    std::map<std::size_t, batch_ptr_type> reorder_buffer;
+    std::size_t next_seq = 0;
+    bool end_of_run = false;
+    batch_ptr_type batch;
+    while (!end_of_run && done_queue.pop(batch))
+      {
+        reorder_buffer[batch->seq] = std::move(batch);
+        auto found = reorder_buffer.find(next_seq);
+        while (!end_of_run && found != reorder_buffer.end())
+          {
+            work_batch & ready = *found->second;
+            // Count and chain the events rejected by the selection (or
+            // skipped by the reader) in event order
+            std::size_t irejected = 0;
+            auto count_rejected = [&](const std::size_t slot_) {
+              for (; irejected < ready.rejected.size() && ready.rejected[irejected].slot <= slot_; irejected++)
+                {
+                  snredbridge::skip_deltat_previous_event(context_, ready.rejected[irejected].reference_time);
+                  if (ready.rejected[irejected].cut < 0) continue;
+                  config_.selection->count(ready.rejected[irejected].cut);
+                  config_.metrics->events_rejected++;
+                  red_counter_++;
+                  if (config_.progress != nullptr) config_.progress->update(red_counter_, udd_counter_);
+                }
+            };
+            for (std::size_t ievent = 0; ievent < ready.size; ievent++)
+              {
+                count_rejected(ievent);
+                red_counter_++;
+                if (config_.selection != nullptr) config_.selection->count(-1);
+                if (!ready.accepted[ievent])
+                  {
+                    end_of_run = true;
+                    break;
+                  }
+                if (config_.validate)
+                  {
+                    if (!ready.equivalent[ievent])
+                      DT_LOG_WARNING(context_.logging, "Event record is not equivalent to RED event #"
+                                     << ready.records[ievent]->get<snemo::datamodel::event_header>("EH").get_id().get_event_number());
+                    validation_.add_compared_event(ready.equivalent[ievent]);
+                  }
+                if (config_.red_digests != nullptr)
+                  {
+                    const auto & UDD = ready.records[ievent]->get<snemo::datamodel::unified_digitized_data>("UDD");
+                    snredbridge::digest_entry entry;
+                    entry.run_id = UDD.get_run_id();
+                    entry.event_id = UDD.get_event_id();
+                    entry.digest = ready.red_digests[ievent];
+                    config_.red_digests->write(entry);
+                    entry.digest = snredbridge::digest_event_record(*ready.records[ievent], !context_.no_waveform);
+                    config_.udd_digests->write(entry);
+                  }
+                snredbridge::fill_deltat_previous_event(context_, *ready.records[ievent]);
+                {
+                  snredbridge::scoped_stage_timer timer(&config_.metrics->write);
+                  writer_.process(*ready.records[ievent]);
+                  if (config_.columns != nullptr) config_.columns->write(*ready.records[ievent]);
+                }
+                udd_counter_++;
+                config_.metrics->events_out++;
+                if (config_.progress != nullptr) config_.progress->update(red_counter_, udd_counter_);
+              }
+            if (!end_of_run) count_rejected(ready.size);
+            if (config_.recycle) free_queue.push(std::move(found->second));
+            reorder_buffer.erase(found);
+            {
+              std::lock_guard<std::mutex> lock(flight_mutex);
+              in_flight--;
+            }
+            flight_cv.notify_one();
+            found = reorder_buffer.find(++next_seq);
+          }
+      }
   }
+  catch (...) {
+    writer_error = std::current_exception();
+  }
+  stop_all();
 
-  EH.get_properties().store("trigger_id", trigger_id_vint);
-  EH.get_properties().store("trigger_decision", trigger_decision_vint);
-  EH.get_properties().store("progenitor_trigger_id", progenitor_trigger_id_vint);
+  reader_thread.join();
+  for (auto & worker_thread : worker_threads) worker_thread.join();
 
-  // GO: we can add some additional properties to the Event Header
-  // EH.get_properties().store("simulation.bundle", "falaise");
-  // EH.get_properties().store("simulation.version", "0.1");
-  // EH.get_properties().store("author", std::string(getenv("USER")));
+  if (reader_error) std::rethrow_exception(reader_error);
+  for (const auto & worker_error : worker_errors)
+    if (worker_error) std::rethrow_exception(worker_error);
+  if (writer_error) std::rethrow_exception(writer_error);
+  return;
+}
 
-  // Copy RED attributes to UDD attributes
-  UDD.set_run_id(red_run_id);
-  UDD.set_event_id(red_event_id);
-  UDD.set_reference_timestamp(reference_timestamp.get_ticks());
-  UDD.set_origin_trigger_ids(red_trigger_ids);
-  // UDD.set_auxiliaries(red_.get_auxiliaries());
 
-  // Scan and copy RED calo digitized hit into UDD calo digitized hit:
-  for (std::size_t ihit = 0; ihit < red_calo_hits.size(); ihit++)
-    {
-      // std::clog << "DEBUG do_red_to_udd_conversion : Calo hit #" << ihit << std::endl;
-      snfee::data::calo_digitized_hit red_calo_hit = red_calo_hits[ihit];
-      snemo::datamodel::calorimeter_digitized_hit & udd_calo_hit = UDD.add_calorimeter_hit();
-      udd_calo_hit.set_geom_id(red_calo_hit.get_geom_id());
-      udd_calo_hit.set_hit_id(red_calo_hit.get_hit_id());
-      udd_calo_hit.set_timestamp(red_calo_hit.get_reference_time().get_ticks());
-      std::vector<int16_t> calo_waveform = red_calo_hit.get_waveform();
-      if (!no_waveform) udd_calo_hit.set_waveform(calo_waveform);
-      udd_calo_hit.set_low_threshold_only(red_calo_hit.is_low_threshold_only());
-      udd_calo_hit.set_high_threshold(red_calo_hit.is_high_threshold());
-      udd_calo_hit.set_fcr(red_calo_hit.get_fcr());
-      udd_calo_hit.set_lt_trigger_counter(red_calo_hit.get_lt_trigger_counter());
-      udd_calo_hit.set_lt_time_counter(red_calo_hit.get_lt_time_counter());
-      udd_calo_hit.set_fwmeas_baseline(red_calo_hit.get_fwmeas_baseline());
-      udd_calo_hit.set_fwmeas_peak_amplitude(red_calo_hit.get_fwmeas_peak_amplitude());
-      udd_calo_hit.set_fwmeas_peak_cell(red_calo_hit.get_fwmeas_peak_cell());
-      udd_calo_hit.set_fwmeas_charge(red_calo_hit.get_fwmeas_charge());
-      udd_calo_hit.set_fwmeas_rising_cell(red_calo_hit.get_fwmeas_rising_cell());
-      udd_calo_hit.set_fwmeas_falling_cell(red_calo_hit.get_fwmeas_falling_cell());
-      snemo::datamodel::calorimeter_digitized_hit::rtd_origin the_rtd_origin(red_calo_hit.get_origin().get_hit_number(),
-                                                                             red_calo_hit.get_origin().get_trigger_id());
-      udd_calo_hit.set_origin(the_rtd_origin);
-
-    } // end of for ihit
-
-  // sort calo hit by om num
-  auto & udd_calo_hits = UDD.grab_calorimeter_hits();
-
-  std::sort(udd_calo_hits.begin(), udd_calo_hits.end(),
-	    [](const auto & h1, const auto & h2) {return (snemo::datamodel::om_num(h1->get_geom_id()) < snemo::datamodel::om_num(h2->get_geom_id()));});
-
-  // correct hit id values
-  for (std::size_t ihit = 0; ihit < udd_calo_hits.size(); ihit++)
-    udd_calo_hits[ihit]->set_hit_id(ihit);
-
-
-  // Scan and copy RED tracker digitized hit into UDD calo digitized hit:
-  for (std::size_t ihit = 0; ihit < red_tracker_hits.size(); ihit++)
+int run_batch(const std::string & manifest_filename_,
+              const batch_config & config_)
+{
+  // Each run is converted sequentially, with its own reader, writer,
+  // context and selection counters. The job threads take the runs in
+  // the manifest order; a failed run does not stop the others.
+  const std::vector<snredbridge::run_manifest_entry> runs = snredbridge::load_run_manifest(manifest_filename_);
+  DT_THROW_IF(runs.empty(), std::logic_error, "No run in batch manifest '" << manifest_filename_ << "'!");
+  std::vector<batch_run_result> results(runs.size());
+  const auto batch_start = std::chrono::steady_clock::now();
+
+  auto convert_run = [&config_](const snredbridge::run_manifest_entry & run_, batch_run_result & result_) {
+    snredbridge::conversion_context context = config_.context;
+    context.run_sync_time = run_.sync_time;
+    if (run_.has_end_time) context.run_end_time = run_.end_time;
+    snredbridge::event_selection selection = config_.selection;
+
+    snredbridge::red_reader::config_type reader_cfg;
+    reader_cfg.filenames = snredbridge::expand_filenames({run_.input});
+    reader_cfg.read_ahead_bytes = config_.read_ahead_bytes;
+    reader_cfg.end_time = context.run_end_time;
+    snredbridge::red_reader red_source(reader_cfg);
+
+    snredbridge::udd_writer::config_type writer_cfg = config_.writer_cfg;
+    writer_cfg.filename = config_.output_codec.empty()
+      ? run_.output : snredbridge::udd_writer::make_codec_filename(run_.output, config_.output_codec);
+    snredbridge::udd_writer writer;
+    writer.initialize(writer_cfg);
+
+    std::unique_ptr<snredbridge::digest_file_writer> red_digests;
+    std::unique_ptr<snredbridge::digest_file_writer> udd_digests;
+    if (config_.write_digests)
+      {
+        red_digests.reset(new snredbridge::digest_file_writer(writer_cfg.filename + ".red.digest", !context.no_waveform));
+        udd_digests.reset(new snredbridge::digest_file_writer(writer_cfg.filename + ".udd.digest", !context.no_waveform));
+      }
+
+    snredbridge::run_metrics metrics;
+    snredbridge::progress_reporter progress(config_.progress_period, config_.expected_events);
+    progress.set_label(run_.output);
+    parallel_config run_cfg;
+    run_cfg.recycle = config_.recycle;
+    run_cfg.validate = config_.validate;
+    run_cfg.red_digests = red_digests.get();
+    run_cfg.udd_digests = udd_digests.get();
+    run_cfg.metrics = &metrics;
+    run_cfg.progress = &progress;
+    run_cfg.selection = selection.is_active() ? &selection : nullptr;
+    snredbridge::validation_summary validation;
+    run_sequential_conversion(red_source, writer, context, run_cfg, config_.data_count,
+                              result_.red_counter, result_.udd_counter, validation);
+    writer.terminate();
+    if (config_.write_digests)
+      {
+        red_digests->close();
+        udd_digests->close();
+      }
+    red_source.close();
+    result_.rejected_counter = metrics.events_rejected;
+    result_.non_equal_counter = validation.non_equal_event_counter;
+    result_.output_files = writer.get_filenames().size();
+    result_.seconds = metrics.get_elapsed_seconds();
+  };
+
+  std::mutex print_mutex;
+  std::atomic<std::size_t> next_run{0};
+  std::atomic<std::size_t> ndone{0};
+  std::vector<std::thread> job_threads;
+  const std::size_t njobs = std::min(std::max<std::size_t>(config_.njobs, 1), runs.size());
+  std::clog << "Converting " << runs.size() << " run(s) from '" << manifest_filename_ << "' with "
+            << njobs << " job(s)" << std::endl;
+  for (std::size_t ijob = 0; ijob < njobs; ijob++)
     {
-      // std::clog << "DEBUG do_red_to_udd_conversion : Tracker hit #" << ihit << std::endl;
-      snfee::data::tracker_digitized_hit red_tracker_hit = red_tracker_hits[ihit];
-      snemo::datamodel::tracker_digitized_hit & udd_tracker_hit = UDD.add_tracker_hit();
-      udd_tracker_hit.set_geom_id(red_tracker_hit.get_geom_id());
-      udd_tracker_hit.set_hit_id(red_tracker_hit.get_hit_id());
-
-      // Do the loop on RED GG timestamps and convert them into UDD GG timestamps
-	  const std::vector<snfee::data::tracker_digitized_hit::gg_times> gg_timestamps_v = red_tracker_hit.get_times();
+      job_threads.emplace_back([&]() {
+          for (std::size_t irun = next_run++; irun < runs.size(); irun = next_run++)
+            {
+              batch_run_result & result = results[irun];
+              try {
+                convert_run(runs[irun], result);
+                result.ok = true;
+              }
+              catch (std::exception & x) {
+                result.error = x.what();
+              }
+              catch (...) {
+                result.error = "unexpected error";
+              }
+              std::lock_guard<std::mutex> lock(print_mutex);
+              std::clog << "[" << ++ndone << "/" << runs.size() << "] " << runs[irun].output << " : "
+                        << (result.ok ? "done" : "FAILED") << std::endl;
+            }
+        });
+    }
+  for (auto & job_thread : job_threads) job_thread.join();
 
-      for (std::size_t iggtime = 0; iggtime < gg_timestamps_v.size(); iggtime++)
+  std::size_t nfailed = 0;
+  std::size_t total_udd_counter = 0;
+  std::cout << "Batch results :" << std::endl;
+  for (std::size_t irun = 0; irun < runs.size(); irun++)
+    {
+      const batch_run_result & result = results[irun];
+      std::cout << "- Run #" << irun << " (line " << runs[irun].line << ") " << runs[irun].input
+                << " -> " << runs[irun].output << std::endl;
+      if (!result.ok)
         {
-          // std::clog << "DEBUG do_red_to_udd_conversion : Tracker hit #" << ihit << " Geiger Time #" << iggtime <<  std::endl;
-          // Retrieve RED GG timestamps
-	      const snfee::data::tracker_digitized_hit::gg_times & a_gg_timestamp = gg_timestamps_v[iggtime];
-
-          // Create empty UDD GG timestamps
-          snemo::datamodel::tracker_digitized_hit::gg_times & udd_gg_timestamp = udd_tracker_hit.add_times();
-
-          // Fill UDD anode and cathode timestamps and RTD origin for backtracing
-          snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r0_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R0).get_hit_number(),
-                                                                                  a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R0).get_trigger_id());
-          udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R0,
-                                            anode_r0_rtd_origin);
-          udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R0,
-                                          a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R0).get_ticks());
-
-          snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r1_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R1).get_hit_number(),
-                                                                                  a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R1).get_trigger_id());
-          udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R1,
-                                            anode_r1_rtd_origin);
-          udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R1,
-                                          a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R1).get_ticks());
-
-          snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r2_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R2).get_hit_number(),
-                                                                                  a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R2).get_trigger_id());
-          udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R2,
-                                            anode_r2_rtd_origin);
-          udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R2,
-                                          a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R2).get_ticks());
-
-          snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r3_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R3).get_hit_number(),
-                                                                                  a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R3).get_trigger_id());
-          udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R3,
-                                            anode_r3_rtd_origin);
-          udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R3,
-                                          a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R3).get_ticks());
-
-          snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r4_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R4).get_hit_number(),
-                                                                                  a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R4).get_trigger_id());
-          udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R4,
-                                            anode_r4_rtd_origin);
-          udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R4,
-                                          a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R4).get_ticks());
-
-          snemo::datamodel::tracker_digitized_hit::rtd_origin bottom_cathode_rtd_origin(a_gg_timestamp.get_bottom_cathode_origin().get_hit_number(),
-                                                                                        a_gg_timestamp.get_bottom_cathode_origin().get_trigger_id());
-          udd_gg_timestamp.set_bottom_cathode_origin(bottom_cathode_rtd_origin);
-          udd_gg_timestamp.set_bottom_cathode_time(a_gg_timestamp.get_bottom_cathode_time().get_ticks());
-
-
-          snemo::datamodel::tracker_digitized_hit::rtd_origin top_cathode_rtd_origin(a_gg_timestamp.get_top_cathode_origin().get_hit_number(),
-                                                                                     a_gg_timestamp.get_top_cathode_origin().get_trigger_id());
-          udd_gg_timestamp.set_top_cathode_origin(top_cathode_rtd_origin);
-          udd_gg_timestamp.set_top_cathode_time(a_gg_timestamp.get_top_cathode_time().get_ticks());
-
-
-	    } // end of iggtime
-
-    } // end for ihit
-
-  // sort tracker hit by cell num
-  auto & udd_tracker_hits = UDD.grab_tracker_hits();
-
-  std::sort(udd_tracker_hits.begin(), udd_tracker_hits.end(),
-	    [](const auto & h1, const auto & h2) {return (snemo::datamodel::gg_num(h1->get_geom_id()) < snemo::datamodel::gg_num(h2->get_geom_id()));});
-
-  // correct hit id values
-  for (std::size_t ihit = 0; ihit < udd_tracker_hits.size(); ihit++)
-    udd_tracker_hits[ihit]->set_hit_id(ihit);
-
-  // red_.print_tree(std::clog);
-  // EH.tree_dump(std::clog, "Event header('EH'): ");
-  // UDD.tree_dump(std::clog, "Unified Digitized Data('UDD'): ");
-
-  return true;
+          nfailed++;
+          std::cout << "  - Status            : FAILED (" << result.error << ")" << std::endl;
+          continue;
+        }
+      total_udd_counter += result.udd_counter;
+      std::cout << "  - Status            : OK" << std::endl;
+      std::cout << "  - Processed records : " << result.red_counter << std::endl;
+      if (result.rejected_counter > 0)
+        std::cout << "  - Rejected records  : " << result.rejected_counter << std::endl;
+      std::cout << "  - Stored records    : " << result.udd_counter << std::endl;
+      if (result.output_files > 1)
+        std::cout << "  - Output files      : " << result.output_files << std::endl;
+      if (config_.validate)
+        std::cout << "  - Non equal events  : " << result.non_equal_counter << std::endl;
+      std::cout << "  - Wall time         : " << result.seconds << " s" << std::endl;
+    }
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+  std::cout << "- Runs                : " << runs.size() - nfailed << " OK, " << nfailed << " failed" << std::endl;
+  std::cout << "- Stored records      : " << total_udd_counter << std::endl;
+  std::cout << "- Wall time           : " << elapsed << " s" << std::endl;
+  return (nfailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void write_event_digests(const snredbridge::conversion_context & context_,
+                         const snfee::data::raw_event_data & red_,
+                         const datatools::things & event_record_,
+                         snredbridge::digest_file_writer & red_digests_,
+                         snredbridge::digest_file_writer & udd_digests_)
+{
+  const bool with_waveform = !context_.no_waveform;
+  snredbridge::digest_entry entry;
+  entry.run_id = red_.get_run_id();
+  entry.event_id = red_.get_event_id();
+  entry.digest = snredbridge::digest_red_event(red_, with_waveform, &context_.waveform_roi);
+  red_digests_.write(entry);
+  entry.digest = snredbridge::digest_event_record(event_record_, with_waveform);
+  udd_digests_.write(entry);
+  return;
 }
@@ -0,0 +1,343 @@
+// Standard library:
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/things.h>
+
+// - SNFEE:
+#include <snfee/snfee.h>
+#include <snfee/data/raw_event_data.h>
+
+// - zlib:
+#include <zlib.h>
+
+// - SNREDBridge:
+#include <snredbridge/conversion_context.h>
+#include <snredbridge/file_utils.h>
+#include <snredbridge/hit_pool.h>
+#include <snredbridge/parallel_gzip.h>
+#include <snredbridge/red_generator.h>
+#include <snredbridge/red_to_udd_conversion.h>
+#include <snredbridge/red_udd_comparison.h>
+
+//----------------------------------------------------------------------
+// Allocation counter: all the dynamic allocations of the program go
+// through these operators
+//----------------------------------------------------------------------
+
+namespace {
+  std::atomic<std::size_t> allocation_counter{0};
+}
+
+void * operator new(std::size_t size_)
+{
+  allocation_counter.fetch_add(1, std::memory_order_relaxed);
+  if (size_ == 0) size_ = 1;
+  void * ptr = std::malloc(size_);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void * operator new[](std::size_t size_)
+{
+  return operator new(size_);
+}
+
+void operator delete(void * ptr_) noexcept
+{
+  std::free(ptr_);
+}
+
+void operator delete[](void * ptr_) noexcept
+{
+  std::free(ptr_);
+}
+
+void operator delete(void * ptr_, std::size_t) noexcept
+{
+  std::free(ptr_);
+}
+
+void operator delete[](void * ptr_, std::size_t) noexcept
+{
+  std::free(ptr_);
+}
+
+/// Timing and allocations of a benchmarked kernel
+struct kernel_measure
+{
+  std::size_t nevents = 0;
+  std::size_t nhits = 0;
+  std::size_t nallocations = 0;
+  double seconds = 0.0;
+
+  void print(std::ostream & out_, const std::string & name_) const
+  {
+    out_ << "- " << name_ << std::endl;
+    out_ << "  - Events          : " << nevents << std::endl;
+    out_ << "  - Time            : " << seconds << " s" << std::endl;
+    out_ << "  - Events/s        : " << (seconds > 0 ? nevents / seconds : 0.0) << std::endl;
+    out_ << "  - ns/event        : " << (nevents > 0 ? 1.e9 * seconds / nevents : 0.0) << std::endl;
+    out_ << "  - ns/hit          : " << (nhits > 0 ? 1.e9 * seconds / nhits : 0.0) << std::endl;
+    out_ << "  - Allocations/evt : " << (nevents > 0 ? static_cast<double>(nallocations) / nevents : 0.0) << std::endl;
+  }
+};
+
+//----------------------------------------------------------------------
+// MAIN PROGRAM
+//----------------------------------------------------------------------
+
+int main (int argc, char *argv[])
+{
+  datatools::logger::priority logging = datatools::logger::PRIO_WARNING;
+  int error_code = EXIT_SUCCESS;
+  try {
+    snredbridge::red_generator::config_type generator_cfg;
+    std::size_t nevents = 10000;
+    std::size_t nrepeats = 5;
+    bool recycle = false;
+    std::size_t gzip_threads = 0;
+    snredbridge::conversion_context context;
+    context.run_sync_time = 1.6e9;
+
+    for (int iarg=1; iarg<argc; ++iarg)
+      {
+        std::string arg (argv[iarg]);
+        if (arg[0] == '-')
+          {
+            if ((arg == "-d") || (arg == "--debug"))
+              logging = datatools::logger::PRIO_DEBUG;
+
+            else if ((arg == "-v") || (arg == "--verbose"))
+              logging = datatools::logger::PRIO_INFORMATION;
+
+            else if ((arg == "-n") || (arg == "--events"))
+              nevents = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if ((arg == "-r") || (arg == "--repeat"))
+              nrepeats = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--calo-hits")
+              generator_cfg.mean_calo_hits = std::strtod(argv[++iarg], NULL);
+
+            else if (arg == "--tracker-hits")
+              generator_cfg.mean_tracker_hits = std::strtod(argv[++iarg], NULL);
+
+            else if (arg == "--waveform-length")
+              generator_cfg.waveform_length = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--gg-times")
+              generator_cfg.gg_times_per_hit = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--seed")
+              generator_cfg.seed = std::strtoull(argv[++iarg], NULL, 10);
+
+            else if ((arg == "-no-wf") || (arg == "--no-waveform"))
+              context.no_waveform = true;
+
+            else if (arg == "--waveform-roi")
+              snredbridge::parse_waveform_roi(argv[++iarg], context.waveform_roi);
+
+            else if (arg == "--waveform-delta")
+              context.waveform_roi.delta = true;
+
+            else if (arg == "--gzip-threads")
+              gzip_threads = std::strtoul(argv[++iarg], NULL, 10);
+            else if (arg == "--recycle")
+              recycle = true;
+
+            else if (arg=="-h" || arg=="--help")
+              {
+                std::cout << std::endl;
+                std::cout << "Usage:   " << argv[0] << " [options]" << std::endl;
+                std::cout << std::endl;
+                std::cout << "Benchmark of the RED to UDD conversion and of the RED/UDD comparison on synthetic events" << std::endl;
+                std::cout << std::endl;
+                std::cout << "Options:   -h / --help" << std::endl;
+                std::cout << "           -n / --events N      Number of generated events (default: 10000)" << std::endl;
+                std::cout << "           -r / --repeat N      Number of passes over the events (default: 5)" << std::endl;
+                std::cout << "           --calo-hits X        Mean number of calorimeter hits per event (default: 4)" << std::endl;
+                std::cout << "           --tracker-hits X     Mean number of tracker hits per event (default: 20)" << std::endl;
+                std::cout << "           --waveform-length N  Number of samples per waveform (default: 1024)" << std::endl;
+                std::cout << "           --gg-times N         Number of GG times per tracker hit (default: 1)" << std::endl;
+                std::cout << "           --seed N             Seed of the generator" << std::endl;
+                std::cout << "           -no-wf / --no-waveform Do not convert (nor compare) the waveforms" << std::endl;
+                std::cout << "           --waveform-roi PRE:POST Only convert a window of the waveforms (see red_bridge)" << std::endl;
+                std::cout << "           --waveform-delta       Delta-encode the converted waveforms" << std::endl;
+                std::cout << "           --recycle            Reuse the event records and UDD hits (as red_bridge --recycle)" << std::endl;
+                std::cout << "           --gzip-threads N     Also compress the waveforms with the parallel gzip writer on N threads" << std::endl;
+                std::cout << "                                and check that zlib inflates them back (default: 0, no check)" << std::endl;
+                std::cout << "           -v / --verbose       More logs" << std::endl;
+                std::cout << "           -d / --debug         Debug logs" << std::endl;
+                std::cout << std::endl;
+                return 0;
+              }
+
+            else
+              DT_LOG_WARNING(logging, "Ignoring option '" << arg << "' !");
+          }
+      }
+    context.logging = logging;
+    if (nrepeats == 0) nrepeats = 1;
+
+    snfee::initialize();
+
+    // Generate the events
+    DT_LOG_INFORMATION(logging, "Generating " << nevents << " synthetic RED events");
+    snredbridge::red_generator generator(generator_cfg);
+    std::vector<snfee::data::raw_event_data> reds(nevents);
+    std::size_t nhits = 0;
+    for (auto & red : reds)
+      {
+        generator.generate(red);
+        nhits += red.get_calo_hits().size() + red.get_tracker_hits().size();
+      }
+
+    typedef std::chrono::steady_clock clock_type;
+
+    // Benchmark #1 : RED to UDD conversion
+    kernel_measure conversion;
+    {
+      snredbridge::conversion_pools pools;
+      snredbridge::conversion_pools * hit_pools = recycle ? &pools : nullptr;
+      std::unique_ptr<datatools::things> event_record;
+      for (std::size_t irepeat = 0; irepeat < nrepeats; irepeat++)
+        {
+          const std::size_t nallocations_start = allocation_counter.load();
+          const clock_type::time_point start = clock_type::now();
+          for (const auto & red : reds)
+            {
+              if (!recycle || !event_record) event_record.reset(new datatools::things);
+              snredbridge::do_red_to_udd_conversion(context, red, *event_record, hit_pools);
+              snredbridge::fill_deltat_previous_event(context, *event_record);
+            }
+          conversion.seconds += std::chrono::duration<double>(clock_type::now() - start).count();
+          conversion.nallocations += allocation_counter.load() - nallocations_start;
+          conversion.nevents += nevents;
+          conversion.nhits += nhits;
+        }
+    }
+
+    // Benchmark #2 : RED/UDD comparison
+    kernel_measure comparison;
+    std::size_t non_equal_events = 0;
+    {
+      std::vector<std::unique_ptr<datatools::things>> event_records;
+      event_records.reserve(nevents);
+      for (const auto & red : reds)
+        {
+          event_records.emplace_back(new datatools::things);
+          snredbridge::do_red_to_udd_conversion(context, red, *event_records.back());
+        }
+      for (std::size_t irepeat = 0; irepeat < nrepeats; irepeat++)
+        {
+          const std::size_t nallocations_start = allocation_counter.load();
+          const clock_type::time_point start = clock_type::now();
+          for (std::size_t ievent = 0; ievent < nevents; ievent++)
+            {
+              if (!snredbridge::compare_red_event_record(reds[ievent], *event_records[ievent],
+                                                         logging, context.no_waveform))
+                non_equal_events++;
+            }
+          comparison.seconds += std::chrono::duration<double>(clock_type::now() - start).count();
+          comparison.nallocations += allocation_counter.load() - nallocations_start;
+          comparison.nevents += nevents;
+          comparison.nhits += nhits;
+        }
+    }
+
+    // Benchmark #3 : parallel gzip compression, with a zlib round trip
+    double gzip_seconds = 0.0;
+    std::size_t gzip_in_bytes = 0;
+    int64_t gzip_out_bytes = 0;
+    if (gzip_threads > 0)
+      {
+        const std::string gz_filename = snredbridge::make_temporary_filename("red_bridge_benchmark.gz");
+        try {
+          const clock_type::time_point start = clock_type::now();
+          {
+            snredbridge::parallel_gzip_writer gz_writer(gz_filename, 6, gzip_threads);
+            for (const auto & red : reds)
+              for (const auto & calo_hit : red.get_calo_hits())
+                {
+                  const std::vector<int16_t> & waveform = calo_hit.get_waveform();
+                  gz_writer.write(reinterpret_cast<const char *>(waveform.data()), waveform.size() * sizeof(int16_t));
+                  gzip_in_bytes += waveform.size() * sizeof(int16_t);
+                }
+            gz_writer.close();
+          }
+          gzip_seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+          gzip_out_bytes = snredbridge::file_size(gz_filename);
+
+          // Inflate the file with plain zlib and compare with the input, waveform by waveform
+          gzFile gz_in = gzopen(gz_filename.c_str(), "rb");
+          DT_THROW_IF(gz_in == NULL, std::runtime_error, "Cannot open '" << gz_filename << "'!");
+          std::vector<char> buffer;
+          bool same = true;
+          for (const auto & red : reds)
+            for (const auto & calo_hit : red.get_calo_hits())
+              {
+                const std::vector<int16_t> & waveform = calo_hit.get_waveform();
+                const std::size_t nbytes = waveform.size() * sizeof(int16_t);
+                buffer.resize(nbytes);
+                if (same && nbytes > 0)
+                  same = gzread(gz_in, buffer.data(), nbytes) == static_cast<int>(nbytes)
+                    && std::memcmp(buffer.data(), waveform.data(), nbytes) == 0;
+              }
+          char extra;
+          if (same) same = gzread(gz_in, &extra, 1) == 0;
+          gzclose(gz_in);
+          DT_THROW_IF(!same, std::runtime_error,
+                      "The parallel gzip output '" << gz_filename << "' does not inflate back to its input!");
+        }
+        catch (...) {
+          std::remove(gz_filename.c_str());
+          throw;
+        }
+        std::remove(gz_filename.c_str());
+      }
+
+    std::cout << "Benchmark :" << std::endl;
+    std::cout << "- Generated events  : " << nevents << " (" << nhits << " hits, "
+              << generator_cfg.waveform_length << " samples/waveform)" << std::endl;
+    std::cout << "- Passes            : " << nrepeats << std::endl;
+    conversion.print(std::cout, std::string("do_red_to_udd_conversion") + (recycle ? " (recycle)" : ""));
+    comparison.print(std::cout, "compare_red_event_record");
+    if (gzip_threads > 0)
+      {
+        std::cout << "- parallel_gzip_writer (" << gzip_threads << " threads)" << std::endl;
+        std::cout << "  - Input           : " << gzip_in_bytes << " bytes" << std::endl;
+        std::cout << "  - Output          : " << gzip_out_bytes << " bytes" << std::endl;
+        std::cout << "  - Time            : " << gzip_seconds << " s" << std::endl;
+        std::cout << "  - MB/s            : " << (gzip_seconds > 0 ? 1.e-6 * gzip_in_bytes / gzip_seconds : 0.0) << std::endl;
+        std::cout << "  - zlib round trip : OK" << std::endl;
+      }
+    if (non_equal_events > 0)
+      DT_LOG_WARNING(logging, non_equal_events << " comparisons failed on synthetic events!");
+
+    snfee::terminate();
+  }
+
+  catch (std::exception & x) {
+    DT_LOG_FATAL(logging, x.what());
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    DT_LOG_FATAL(logging, "unexpected error !");
+    error_code = EXIT_FAILURE;
+  }
+  return (error_code);
+}
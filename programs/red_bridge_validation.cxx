@@ -1,10 +1,17 @@
 // Standard library:
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <exception>
 #include <stdexcept>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 // Third party:
@@ -23,11 +30,98 @@
 #include <snfee/io/multifile_data_reader.h>
 #include <snfee/data/raw_event_data.h>
 
+// - SNREDBridge:
+#include <snredbridge/bounded_queue.h>
+#include <snredbridge/event_digest.h>
+#include <snredbridge/file_utils.h>
+#include <snredbridge/gzip_read_ahead.h>
+#include <snredbridge/red_udd_comparison.h>
+#include <snredbridge/red_udd_diff.h>
 
-bool compare_red_event_record(const snfee::data::raw_event_data &,
-                              const datatools::things &,
-                              const datatools::logger::priority &,
-                              bool);
+/// Source of event records: return the next event record of the UDD
+/// stream, or a null pointer at the end of the stream
+typedef std::function<std::unique_ptr<datatools::things>()> record_source_type;
+
+/// A RED event and its event record (null if it was not found)
+struct event_pair
+{
+  snfee::data::raw_event_data red;
+  std::unique_ptr<datatools::things> event_record;
+  bool equivalent = false;
+  snredbridge::digest_entry red_digest;
+  snredbridge::digest_entry udd_digest;
+  std::vector<snredbridge::field_difference> differences;
+};
+
+/// Configuration of the validation
+struct validation_config
+{
+  bool no_waveform = false;          ///< Do not compare the waveforms
+  snredbridge::waveform_roi_config waveform_roi; ///< Stored part of the UDD waveforms (for the digests)
+  bool with_digests = false;         ///< Compute the digests of the compared events
+  bool with_differences = false;     ///< List the differing fields of the non equal events
+  const snredbridge::digest_comparison * digests = nullptr; ///< Digest prefilter (optional)
+  datatools::logger::priority logging = datatools::logger::PRIO_WARNING;
+  std::size_t nworkers   = 1;        ///< Number of comparison workers
+  std::size_t batch_size = 16;       ///< Number of events per work batch
+  std::size_t queue_size = 64;       ///< Max number of batches in flight
+  std::size_t join_window = 64;      ///< Max number of event records buffered by the join
+};
+
+/// Event results aggregated by the (single) collector, in event order
+struct validation_results
+{
+  snredbridge::validation_summary summary;
+  std::size_t unmatched_record_counter = 0; ///< Event records matching no RED event
+  bool print_non_equal_events = false; ///< Print the non equal RED and UDD events
+  snredbridge::diff_report_writer * diff_report = nullptr;
+  snredbridge::digest_file_writer * red_digests = nullptr;
+  snredbridge::digest_file_writer * udd_digests = nullptr;
+};
+
+/// \brief Bounded lookahead join of the UDD stream on (run ID, event ID)
+///
+/// Event records read ahead while searching for a RED event are kept in a
+/// window of limited size, so that out of order or missing event records
+/// do not make the following RED events missing. Assuming RED events come
+/// in (run ID, event ID) order, buffered event records older than the
+/// searched RED event can not match anymore and are dropped.
+class event_record_window
+{
+public:
+
+  typedef std::pair<int32_t, int32_t> key_type;
+
+  /// Constructor
+  event_record_window(const record_source_type & source_, const std::size_t capacity_,
+                      const datatools::logger::priority logging_);
+
+  /// Take the event record of a RED event. Return a null pointer if it is not found
+  std::unique_ptr<datatools::things> take(const int32_t red_run_id_, const int32_t red_event_id_);
+
+  /// Return the number of event records which matched no RED event so far
+  std::size_t get_number_of_unmatched_records() const;
+
+private:
+
+  record_source_type _source_;     ///< Source of event records
+  std::size_t _capacity_;          ///< Max number of buffered event records
+  datatools::logger::priority _logging_; ///< Logging priority
+  bool _end_of_source_ = false;    ///< The source is exhausted
+  std::map<key_type, std::unique_ptr<datatools::things>> _buffer_; ///< Buffered event records
+  std::size_t _dropped_ = 0;       ///< Number of dropped event records
+
+};
+
+void compare_event_pair(event_pair &, const validation_config &);
+
+void collect_event_pair(const event_pair &, const datatools::logger::priority, validation_results &);
+
+void run_parallel_validation(snfee::io::multifile_data_reader &,
+                             dpp::input_module &,
+                             const std::size_t,
+                             const validation_config &,
+                             validation_results &);
 
 
 //----------------------------------------------------------------------
@@ -44,6 +138,13 @@ int main (int argc, char *argv[])
     std::string input_udd_filename = "";
     size_t data_count = 100000000;
     bool no_waveform = false;
+    std::string red_digest_filename = "";
+    std::string udd_digest_filename = "";
+    std::string output_digest_prefix = "";
+    std::string diff_report_filename = "";
+    std::size_t nthreads = 1;
+    uint64_t read_ahead_bytes = 0;
+    validation_config val_cfg;
 
     for (int iarg=1; iarg<argc; ++iarg)
       {
@@ -70,6 +171,39 @@ int main (int argc, char *argv[])
             else if ((arg == "-no-wf") || (arg == "--no-waveform"))
               no_waveform = true;
 
+            else if (arg == "--waveform-roi")
+              snredbridge::parse_waveform_roi(argv[++iarg], val_cfg.waveform_roi);
+
+            else if (arg == "--waveform-delta")
+              val_cfg.waveform_roi.delta = true;
+
+            else if (arg == "--red-digest")
+              red_digest_filename = std::string(argv[++iarg]);
+
+            else if (arg == "--udd-digest")
+              udd_digest_filename = std::string(argv[++iarg]);
+
+            else if (arg == "--write-digests")
+              output_digest_prefix = std::string(argv[++iarg]);
+
+            else if (arg == "--join-window")
+              val_cfg.join_window = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--diff-file")
+              diff_report_filename = std::string(argv[++iarg]);
+
+            else if ((arg == "-t") || (arg == "--threads"))
+              nthreads = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--batch-size")
+              val_cfg.batch_size = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--queue-size")
+              val_cfg.queue_size = std::strtoul(argv[++iarg], NULL, 10);
+
+            else if (arg == "--read-ahead")
+              read_ahead_bytes = snredbridge::parse_byte_size(argv[++iarg]);
+
             else if (arg=="-h" || arg=="--help")
               {
                 std::cout << std::endl;
@@ -80,6 +214,25 @@ int main (int argc, char *argv[])
                 std::cout << "           -iudd / --input-udd    UDD_FILE" << std::endl;
                 std::cout << "           -n    / --max-events   Max number of events" << std::endl;
                 std::cout << "           -no-wf / --no-waveform Do compare the waveform between RED and UDD" << std::endl;
+                std::cout << "           --waveform-roi PRE:POST The UDD waveforms were saved with red_bridge --waveform-roi PRE:POST" << std::endl;
+                std::cout << "           --waveform-delta       The UDD waveforms were saved with red_bridge --waveform-delta" << std::endl;
+                std::cout << "                                  (both only matter for the digests: the comparison reads the stored" << std::endl;
+                std::cout << "                                  window and encoding of each UDD waveform)" << std::endl;
+                std::cout << "           --red-digest   FILE    Digests of the RED events (as written by red_bridge --write-digests)" << std::endl;
+                std::cout << "           --udd-digest   FILE    Digests of the stored event records (as written by --write-digests);" << std::endl;
+                std::cout << "                                  with --red-digest, only the events whose digests differ are" << std::endl;
+                std::cout << "                                  deep-compared (red_bridge UDD digests do not check the stored file)" << std::endl;
+                std::cout << "           --write-digests PREFIX Write the digests of the read RED events and event records" << std::endl;
+                std::cout << "                                  to PREFIX.red.digest and PREFIX.udd.digest" << std::endl;
+                std::cout << "           --join-window N        Max number of event records read ahead to find a RED event (default: 64)" << std::endl;
+                std::cout << "           --diff-file FILE       Write the differing fields of the non equal events to FILE" << std::endl;
+                std::cout << "                                  (tab-separated: run, event, bank, hit, field, RED and UDD values)" << std::endl;
+                std::cout << "           -t / --threads N       Number of threads (>=2 reads RED and UDD in their own threads," << std::endl;
+                std::cout << "                                  with N-3 comparison workers when N>=4)" << std::endl;
+                std::cout << "           --batch-size N         Number of events per comparison batch (default: 16)" << std::endl;
+                std::cout << "           --read-ahead SIZE      Decompress the gzipped input files on dedicated threads, up to SIZE" << std::endl;
+                std::cout << "                                  bytes ahead of the readers (k/M/G suffix allowed, e.g. 64M)" << std::endl;
+                std::cout << "           --queue-size N         Max number of batches in flight (default: 64)" << std::endl;
                 std::cout << std::endl;
                 return 0;
               }
@@ -89,14 +242,76 @@ int main (int argc, char *argv[])
           }
       }
 
-    if (input_red_filename.empty() || input_udd_filename.empty())
+    const bool use_digests = !red_digest_filename.empty() && !udd_digest_filename.empty();
+    if (!use_digests && (input_red_filename.empty() || input_udd_filename.empty()))
       {
         std::cerr << "*** ERROR: missing input RED or UDD filename !" << std::endl;
         return 1;
       }
 
+    // RED, ER, EH, UDD, missing and non equal events counters
+    validation_results results;
+    snredbridge::validation_summary & summary = results.summary;
+    std::size_t & red_counter = summary.red_counter;
+    std::size_t & er_counter = summary.er_counter;
+    std::size_t & eh_counter = summary.eh_counter;
+    std::size_t & udd_counter = summary.udd_counter;
+    std::size_t & missing_event_counter = summary.missing_event_counter;
+    std::size_t & non_equal_event_counter = summary.non_equal_event_counter;
+
+    // Compare the digest streams first: events with equal digests are not
+    // deep-compared, and the RED/UDD files are not read at all if all
+    // digests are equal (or if no RED/UDD file is given)
+    snredbridge::digest_comparison digests;
+    if (use_digests)
+      {
+        digests = snredbridge::compare_digest_files(red_digest_filename, udd_digest_filename, logging);
+        std::cout << "Digests :" << std::endl;
+        std::cout << "- RED digests       : " << digests.red_counter << std::endl;
+        std::cout << "- UDD digests       : " << digests.udd_counter << std::endl;
+        std::cout << "- Equal digests     : " << digests.equal_counter << std::endl;
+        std::cout << "- Different digests : " << digests.different_counter << std::endl;
+        std::cout << "- Missing digests   : " << digests.missing_counter << std::endl;
+        if (!digests.udd_from_stored_records)
+          {
+            // Digests of event records taken before they were written (as
+            // red_bridge --write-digests does) only check the conversion
+            DT_LOG_WARNING(logging, "UDD digests '" << udd_digest_filename << "' were not computed from a stored UDD file:"
+                           << " all the events are deep-compared");
+            if (input_red_filename.empty() || input_udd_filename.empty())
+              {
+                std::cerr << "*** ERROR: missing input RED or UDD filename (the UDD digests do not check the stored UDD file) !" << std::endl;
+                return 1;
+              }
+          }
+        else if (digests.suspicious_events.empty() || input_red_filename.empty() || input_udd_filename.empty())
+          {
+            red_counter = digests.red_counter;
+            er_counter = digests.equal_counter + digests.different_counter;
+            eh_counter = digests.equal_counter;
+            udd_counter = digests.equal_counter;
+            missing_event_counter = digests.missing_counter;
+            non_equal_event_counter = digests.different_counter;
+            summary.print(std::cout);
+            return 0;
+          }
+      }
+
     snfee::initialize();
 
+    // Decompression of the gzipped inputs ahead of the readers (the readers
+    // must be destroyed first)
+    std::unique_ptr<snredbridge::gzip_read_ahead> red_read_ahead;
+    std::unique_ptr<snredbridge::gzip_read_ahead> udd_read_ahead;
+    if (read_ahead_bytes > 0)
+      {
+        snredbridge::gzip_read_ahead::config_type read_ahead_cfg;
+        read_ahead_cfg.nbuffers = std::max<std::size_t>(read_ahead_bytes / read_ahead_cfg.buffer_size, 2);
+        red_read_ahead.reset(new snredbridge::gzip_read_ahead({input_red_filename}, read_ahead_cfg));
+        udd_read_ahead.reset(new snredbridge::gzip_read_ahead({input_udd_filename}, read_ahead_cfg));
+        input_red_filename = red_read_ahead->get_filenames().front();
+        input_udd_filename = udd_read_ahead->get_filenames().front();
+      }
 
     /// Configuration for raw data reader
     snfee::io::multifile_data_reader::config_type reader_cfg;
@@ -118,111 +333,87 @@ int main (int argc, char *argv[])
     reader.initialize_simple();
     DT_LOG_DEBUG(logging, "Initialization of the UDD input module is done.");
 
-    std::string EH_tag  = "EH";
-    std::string UDD_tag = "UDD";
-
-    // RED counter
-    std::size_t red_counter = 0;
-
-    // ER counter
-    std::size_t er_counter = 0;
-
-    // EH counter
-    std::size_t eh_counter = 0;
-
-    // UDD counter
-    std::size_t udd_counter = 0;
-
-    // Missing event counter (for debug purpose)
-    std::size_t missing_event_counter = 0;
-
-    // Non equal events counter during comparison function (for debug purpose)
-    std::size_t non_equal_event_counter = 0;
-
-    std::vector<snfee::data::raw_event_data> list_of_non_equal_red_events;
-    std::vector<snemo::datamodel::unified_digitized_data> list_of_non_equal_udd_events;
-
-    // Check number of events in each data format
-    while (red_source.has_record_tag() && red_counter < data_count)
+    // Digests of the events read from the files
+    std::unique_ptr<snredbridge::digest_file_writer> red_digests;
+    std::unique_ptr<snredbridge::digest_file_writer> udd_digests;
+    if (!output_digest_prefix.empty())
       {
-        // Check and analyze 1 RED event and 1 UDD event
-        // For 1 RED event, must have 1 event record with 1 event header and 1 UDD event for a given RUN ID, same EVENT ID
+        red_digests.reset(new snredbridge::digest_file_writer(output_digest_prefix + ".red.digest", !no_waveform));
+        udd_digests.reset(new snredbridge::digest_file_writer(output_digest_prefix + ".udd.digest", !no_waveform, true));
+        results.red_digests = red_digests.get();
+        results.udd_digests = udd_digests.get();
+      }
 
-        // Empty working RED object
-        snfee::data::raw_event_data red;
-        red_source.load(red);
-        red_counter++;
+    // Field-level differences of the non equal events, written as they are found
+    std::unique_ptr<snredbridge::diff_report_writer> diff_report;
+    if (!diff_report_filename.empty())
+      {
+        diff_report.reset(new snredbridge::diff_report_writer(diff_report_filename));
+        results.diff_report = diff_report.get();
+      }
+    results.print_non_equal_events = is_debug;
 
-        int32_t red_run_id   = red.get_run_id();
-        int32_t red_event_id = red.get_event_id();
+    val_cfg.no_waveform = no_waveform;
+    val_cfg.with_differences = !diff_report_filename.empty();
+    val_cfg.with_digests = !output_digest_prefix.empty();
+    val_cfg.digests = (use_digests && digests.udd_from_stored_records) ? &digests : nullptr;
+    val_cfg.logging = logging;
 
-        bool find_corresponding_udd_event = false;
-        datatools::things event_record;
+    if (nthreads >= 2)
+      {
+        val_cfg.nworkers = (nthreads > 4) ? nthreads - 3 : 1;
+        DT_LOG_INFORMATION(logging, "Running concurrent RED/UDD readers with "
+                           << val_cfg.nworkers << " comparison worker(s)");
+        run_parallel_validation(red_source, reader, data_count, val_cfg, results);
+      }
 
-        while (!reader.is_terminated() || !find_corresponding_udd_event) {
-          // Empty working UDD object
-          dpp::base_module::process_status status = reader.process(event_record);
+    else
+      {
+        // Event records are read on demand from the input module
+        const record_source_type next_record = [&reader, &logging]() {
+          std::unique_ptr<datatools::things> event_record(new datatools::things);
+          dpp::base_module::process_status status = reader.process(*event_record);
           if (status != dpp::base_module::PROCESS_OK) {
             DT_LOG_DEBUG(logging, "Cannot process another event record, status is " << status);
-            break;
-          }
-          //event_record.tree_dump(std::clog, "An event record:");
-
-          auto & EH  = event_record.get<snemo::datamodel::event_header>(EH_tag);
-          auto & UDD = event_record.get<snemo::datamodel::unified_digitized_data>(UDD_tag);
-
-          // Search for corresponding ER event with proper runID and eventID
-          if (EH.get_id().get_run_number() == red_run_id && EH.get_id().get_event_number() == red_event_id
-              && UDD.get_run_id() == red_run_id && UDD.get_event_id() == red_event_id) {
-            DT_LOG_DEBUG(logging, "Find corresponding EH/UDD event for run #" << red_run_id <<  " event #" << red_event_id);
-            find_corresponding_udd_event = true;
-          }
-        } // end of while UDD
-
-        if (find_corresponding_udd_event) {
-          er_counter++;
-          bool is_valid = compare_red_event_record(red, event_record, logging, no_waveform);
-          if (is_valid) {
-            eh_counter++;
-            udd_counter++;
+            event_record.reset();
           }
-          else {
-            // Save non equal RED and UDD events for potential display in debug mode
-            list_of_non_equal_red_events.push_back(red);
-            list_of_non_equal_udd_events.push_back(event_record.get<snemo::datamodel::unified_digitized_data>(UDD_tag));
-            non_equal_event_counter++;
+          return event_record;
+        };
+        event_record_window window(next_record, val_cfg.join_window, logging);
 
+        // Check number of events in each data format
+        while (red_source.has_record_tag() && red_counter < data_count)
+          {
+            // Check and analyze 1 RED event and 1 UDD event
+            // For 1 RED event, must have 1 event record with 1 event header and 1 UDD event for a given RUN ID, same EVENT ID
+            event_pair pair;
+            red_source.load(pair.red);
+            pair.event_record = window.take(pair.red.get_run_id(), pair.red.get_event_id());
+            compare_event_pair(pair, val_cfg);
+            collect_event_pair(pair, logging, results);
           }
-        }
-
-        else {
-          DT_LOG_WARNING(logging, "Did not find corresponding EH/UDD event for run #" << red_run_id <<  " event #" << red_event_id);
-          missing_event_counter++;
-        }
-
-        event_record.clear();
+        results.unmatched_record_counter = window.get_number_of_unmatched_records();
       }
 
+    // A decompression error looks like the end of an input
+    if (red_read_ahead) red_read_ahead->check_errors();
+    if (udd_read_ahead) udd_read_ahead->check_errors();
 
-    std::cout << "Results :" << std::endl;
-    std::cout << "- Worker #0 (input RED)" << std::endl;
-    std::cout << "  - RED events    : " << red_counter << std::endl;
-    std::cout << "- Worker #1 (output ER)" << std::endl;
-    std::cout << "  - Event Records : " << er_counter << std::endl;
-    std::cout << "  - Contains (EH and UDD banks)" << std::endl;
-    std::cout << "    - Event header : " << eh_counter << std::endl;
-    std::cout << "    - UDD events   : " << udd_counter << std::endl;
-    std::cout << "- Missing events     : " << missing_event_counter << std::endl;
-    std::cout << "- Non equal events   : " << non_equal_event_counter << std::endl;
+    if (red_digests) {
+      red_digests->close();
+      udd_digests->close();
+    }
 
-    if (is_debug && non_equal_event_counter != 0)
-      {
-        DT_LOG_DEBUG(logging, "Display RED and UDD non equal events");
-        for (std::size_t i = 0; i < non_equal_event_counter; i++) {
-          list_of_non_equal_red_events[i].print_tree(std::clog);
-          list_of_non_equal_udd_events[i].print_tree(std::clog);
-        }
-      }
+    if (diff_report) {
+      diff_report->close();
+    }
+
+    summary.print(std::cout);
+    if (results.unmatched_record_counter > 0)
+      std::cout << "- Unmatched records  : " << results.unmatched_record_counter << std::endl;
+    if (diff_report)
+      std::cout << "- Differences        : " << diff_report->get_number_of_differences()
+                << " (in '" << diff_report_filename << "')" << std::endl;
 
     snfee::terminate();
 
@@ -242,228 +433,359 @@ int main (int argc, char *argv[])
 
 
 
-bool compare_red_event_record(const snfee::data::raw_event_data & red_,
-                              const datatools::things & event_record_,
-                              const datatools::logger::priority & logging_,
-                              bool no_wf_)
+event_record_window::event_record_window(const record_source_type & source_,
+                                         const std::size_t capacity_,
+                                         const datatools::logger::priority logging_)
+  : _source_(source_), _capacity_(capacity_ == 0 ? 1 : capacity_), _logging_(logging_)
 {
-  DT_LOG_DEBUG(logging_, "Entering compare_red_event_record.");
-  bool red_er_is_equivalent = false;
-  // event_record_.tree_dump(std::clog, "An event record:");
-
-  std::string EH_tag  = "EH";
-  std::string UDD_tag = "UDD";
-  auto & EH  = event_record_.get<snemo::datamodel::event_header>(EH_tag);
-  auto & UDD = event_record_.get<snemo::datamodel::unified_digitized_data>(UDD_tag);
-
-  // red_.print_tree(std::clog);
-  // EH.tree_dump(std::clog, "Event header('EH'): ");
-  // UDD.tree_dump(std::clog, "Unified Digitized Data('UDD'): ");
-
-  // Compare RED attributes with EH / UDD ones
-  bool is_event_header_equivalent = false;
-  // Check Run ID, Event ID and Generation
-  if (EH.get_id().get_run_number() == red_.get_run_id()
-      && EH.get_id().get_event_number() == red_.get_event_id()
-      && EH.is_real()) {
-    DT_LOG_DEBUG(logging_, "Corresponding EH is valid.");
-    is_event_header_equivalent = true;
-  }
+}
 
-  bool is_udd_global_equivalent = false;
-  if (UDD.get_run_id() == red_.get_run_id()
-      && UDD.get_event_id() == red_.get_event_id()
-      && UDD.get_reference_timestamp() == red_.get_reference_time().get_ticks()
-      && UDD.get_origin_trigger_ids() == red_.get_origin_trigger_ids()) {
-    DT_LOG_DEBUG(logging_, "Corresponding UDD global is valid.");
-    is_udd_global_equivalent = true;
+
+std::unique_ptr<datatools::things> event_record_window::take(const int32_t red_run_id_,
+                                                             const int32_t red_event_id_)
+{
+  const key_type red_key(red_run_id_, red_event_id_);
+  std::unique_ptr<datatools::things> event_record;
+
+  // Drop the event records of the RED events already passed
+  while (!_buffer_.empty() && _buffer_.begin()->first < red_key) {
+    DT_LOG_DEBUG(_logging_, "No RED event for the event record of run #" << _buffer_.begin()->first.first
+                 << " event #" << _buffer_.begin()->first.second);
+    _buffer_.erase(_buffer_.begin());
+    _dropped_++;
   }
 
-  bool is_calo_equivalent = false;
+  auto found = _buffer_.find(red_key);
+  if (found == _buffer_.end()) {
+    // Read ahead until the event record is found or the window is full
+    while (!_end_of_source_ && _buffer_.size() < _capacity_) {
+      std::unique_ptr<datatools::things> next_record = _source_();
+      if (!next_record) {
+        _end_of_source_ = true;
+        break;
+      }
+      const auto & EH  = next_record->get<snemo::datamodel::event_header>("EH");
+      const auto & UDD = next_record->get<snemo::datamodel::unified_digitized_data>("UDD");
+      const key_type udd_key(UDD.get_run_id(), UDD.get_event_id());
+      if (EH.get_id().get_run_number() != udd_key.first || EH.get_id().get_event_number() != udd_key.second
+          || udd_key < red_key) {
+        // Inconsistent EH/UDD IDs, or RED event already passed
+        _dropped_++;
+        continue;
+      }
+      auto inserted = _buffer_.emplace(udd_key, std::move(next_record));
+      if (!inserted.second) {
+        DT_LOG_DEBUG(_logging_, "Duplicated event record for run #" << udd_key.first << " event #" << udd_key.second);
+        _dropped_++;
+        continue;
+      }
+      if (udd_key == red_key) {
+        found = inserted.first;
+        break;
+      }
+    }
+  }
 
-  // RED Digitized calo hits
-  const std::vector<snfee::data::calo_digitized_hit> red_calo_hits = red_.get_calo_hits();
+  if (found != _buffer_.end()) {
+    DT_LOG_DEBUG(_logging_, "Find corresponding EH/UDD event for run #" << red_run_id_ <<  " event #" << red_event_id_);
+    event_record = std::move(found->second);
+    _buffer_.erase(found);
+  }
+  return event_record;
+}
 
-  std::size_t number_red_calo_hits = red_calo_hits.size();
-  std::size_t number_udd_calo_hits = UDD.get_calorimeter_hits().size();
-  if (number_red_calo_hits == 0 && number_udd_calo_hits == 0) is_calo_equivalent = true;
 
-  DT_LOG_DEBUG(logging_, "Number of RED calo hits = " << number_red_calo_hits);
-  DT_LOG_DEBUG(logging_, "Number of UDD calo hits = " << number_udd_calo_hits);
+std::size_t event_record_window::get_number_of_unmatched_records() const
+{
+  return _dropped_ + _buffer_.size();
+}
 
-  std::vector<bool> list_calos_corresponding;
 
-  if (number_red_calo_hits == number_udd_calo_hits) {
+void compare_event_pair(event_pair & pair_, const validation_config & config_)
+{
+  if (!pair_.event_record) return;
+  const int32_t red_run_id   = pair_.red.get_run_id();
+  const int32_t red_event_id = pair_.red.get_event_id();
+  if (config_.with_digests) {
+    pair_.red_digest.run_id = red_run_id;
+    pair_.red_digest.event_id = red_event_id;
+    pair_.red_digest.digest = snredbridge::digest_red_event(pair_.red, !config_.no_waveform, &config_.waveform_roi);
+    pair_.udd_digest = pair_.red_digest;
+    pair_.udd_digest.digest = snredbridge::digest_event_record(*pair_.event_record, !config_.no_waveform);
+  }
+  // Events with equal digests are known to be equivalent
+  const bool deep_compare = (config_.digests == nullptr)
+    || config_.digests->suspicious_events.count(std::make_pair(red_run_id, red_event_id)) > 0;
+  pair_.equivalent = deep_compare
+    ? snredbridge::compare_red_event_record(pair_.red, *pair_.event_record, config_.logging, config_.no_waveform)
+    : true;
+  if (!pair_.equivalent && config_.with_differences)
+    snredbridge::diff_red_event_record(pair_.red, *pair_.event_record, config_.no_waveform, pair_.differences);
+  return;
+}
 
-    for (std::size_t ihit = 0; ihit < red_calo_hits.size(); ihit++) {
-      snfee::data::calo_digitized_hit red_calo_hit = red_calo_hits[ihit];
-      bool is_corresponding_udd_calo_find = false;
-      std::size_t udd_calo_counter = 0;
 
-      snemo::datamodel::calorimeter_digitized_hit udd_calo_hit;
+void collect_event_pair(const event_pair & pair_,
+                        const datatools::logger::priority logging_,
+                        validation_results & results_)
+{
+  snredbridge::validation_summary & summary = results_.summary;
+  summary.red_counter++;
+  if (!pair_.event_record) {
+    DT_LOG_WARNING(logging_, "Did not find corresponding EH/UDD event for run #"
+                   << pair_.red.get_run_id() <<  " event #" << pair_.red.get_event_id());
+    summary.missing_event_counter++;
+    return;
+  }
+  summary.er_counter++;
+  if (results_.red_digests != nullptr) {
+    results_.red_digests->write(pair_.red_digest);
+    results_.udd_digests->write(pair_.udd_digest);
+  }
+  if (pair_.equivalent) {
+    summary.eh_counter++;
+    summary.udd_counter++;
+  }
+  else {
+    summary.non_equal_event_counter++;
+    // Report the non equal events as they are found, nothing is kept
+    if (results_.diff_report != nullptr) results_.diff_report->write(pair_.differences);
+    if (results_.print_non_equal_events) {
+      DT_LOG_DEBUG(logging_, "Display RED and UDD non equal events for run #"
+                   << pair_.red.get_run_id() <<  " event #" << pair_.red.get_event_id());
+      pair_.red.print_tree(std::clog);
+      pair_.event_record->get<snemo::datamodel::unified_digitized_data>("UDD").print_tree(std::clog);
+    }
+  }
+  return;
+}
 
-      while (!is_corresponding_udd_calo_find && udd_calo_counter < number_udd_calo_hits) {
-        udd_calo_hit = UDD.get_calorimeter_hits()[udd_calo_counter].get();
 
-        if (udd_calo_hit.get_geom_id() ==  red_calo_hit.get_geom_id()
-            && udd_calo_hit.get_hit_id() == red_calo_hit.get_hit_id()) is_corresponding_udd_calo_find = true;
-        udd_calo_counter++;
+void run_parallel_validation(snfee::io::multifile_data_reader & red_source_,
+                             dpp::input_module & udd_source_,
+                             const std::size_t data_count_,
+                             const validation_config & config_,
+                             validation_results & results_)
+{
+  // RED events and event records are loaded (and decompressed) by two
+  // reader threads. A matcher thread pairs each RED event with its event
+  // record, as the sequential forward search does, and groups the pairs
+  // into numbered batches. A pool of workers compares the pairs and the
+  // collector (current thread) aggregates the results in event order
+  // through a reorder buffer.
+  struct red_batch
+  {
+    std::vector<snfee::data::raw_event_data> reds;
+  };
+  struct record_batch
+  {
+    std::vector<std::unique_ptr<datatools::things>> records;
+  };
+  struct pair_batch
+  {
+    std::size_t seq = 0;
+    std::vector<event_pair> pairs;
+  };
+  typedef std::unique_ptr<red_batch> red_batch_ptr;
+  typedef std::unique_ptr<record_batch> record_batch_ptr;
+  typedef std::unique_ptr<pair_batch> pair_batch_ptr;
+  const std::size_t batch_size = (config_.batch_size == 0) ? 1 : config_.batch_size;
+  const std::size_t max_in_flight = (config_.queue_size < config_.nworkers) ? config_.nworkers : config_.queue_size;
+  snredbridge::bounded_queue<red_batch_ptr> red_queue(max_in_flight);
+  snredbridge::bounded_queue<record_batch_ptr> record_queue(max_in_flight);
+  snredbridge::bounded_queue<pair_batch_ptr> todo_queue(max_in_flight);
+  snredbridge::bounded_queue<pair_batch_ptr> done_queue(max_in_flight);
+
+  // Limit the number of batches between the matcher and the collector so
+  // that a slow batch cannot make the reorder buffer grow without bound
+  std::mutex flight_mutex;
+  std::condition_variable flight_cv;
+  std::size_t in_flight = 0;
+  bool stopping = false;
+  auto stop_all = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(flight_mutex);
+      stopping = true;
+    }
+    flight_cv.notify_all();
+    red_queue.close();
+    record_queue.close();
+    todo_queue.close();
+    done_queue.close();
+  };
+
+  std::exception_ptr red_reader_error;
+  std::exception_ptr udd_reader_error;
+  std::exception_ptr matcher_error;
+  std::vector<std::exception_ptr> worker_errors(config_.nworkers);
+
+  // Stage #0a : load RED events
+  std::thread red_reader_thread([&]() {
+      try {
+        std::size_t nloaded = 0;
+        while (red_source_.has_record_tag() && nloaded < data_count_)
+          {
+            red_batch_ptr batch(new red_batch);
+            batch->reds.reserve(batch_size);
+            while (batch->reds.size() < batch_size && nloaded < data_count_ && red_source_.has_record_tag())
+              {
+                batch->reds.emplace_back();
+                red_source_.load(batch->reds.back());
+                nloaded++;
+              }
+            if (!red_queue.push(std::move(batch))) break;
+          }
       }
-
-      bool is_corresponding_calo_valid = false;
-
-      // Compare calo hit per attributes
-      // create a vector of a boolean for each calo hit already checked
-      if (is_corresponding_udd_calo_find) {
-
-        if (!no_wf_){
-          if (udd_calo_hit.get_geom_id() == red_calo_hit.get_geom_id()
-              && udd_calo_hit.get_hit_id()  == red_calo_hit.get_hit_id()
-              && udd_calo_hit.get_timestamp() == red_calo_hit.get_reference_time().get_ticks()
-              && udd_calo_hit.get_waveform()  == red_calo_hit.get_waveform()
-              && udd_calo_hit.is_low_threshold_only() == red_calo_hit.is_low_threshold_only()
-              && udd_calo_hit.is_high_threshold() == red_calo_hit.is_high_threshold()
-              && udd_calo_hit.get_fcr() == red_calo_hit.get_fcr()
-              && udd_calo_hit.get_lt_trigger_counter() == red_calo_hit.get_lt_trigger_counter()
-              && udd_calo_hit.get_lt_time_counter() == red_calo_hit.get_lt_time_counter()
-              && udd_calo_hit.get_fwmeas_baseline() == red_calo_hit.get_fwmeas_baseline()
-              && udd_calo_hit.get_fwmeas_peak_amplitude() == red_calo_hit.get_fwmeas_peak_amplitude()
-              && udd_calo_hit.get_fwmeas_peak_cell() == red_calo_hit.get_fwmeas_peak_cell()
-              && udd_calo_hit.get_fwmeas_charge() == red_calo_hit.get_fwmeas_charge()
-              && udd_calo_hit.get_fwmeas_rising_cell() == red_calo_hit.get_fwmeas_rising_cell()
-              && udd_calo_hit.get_fwmeas_falling_cell() == red_calo_hit.get_fwmeas_falling_cell()
-              && udd_calo_hit.get_origin().get_hit_number() == red_calo_hit.get_origin().get_hit_number()
-              && udd_calo_hit.get_origin().get_trigger_id() == red_calo_hit.get_origin().get_trigger_id()) {
-            DT_LOG_DEBUG(logging_, "Corresponding UDD calo is valid.");
-            is_corresponding_calo_valid = true;
+      catch (...) {
+        red_reader_error = std::current_exception();
+        stop_all();
+      }
+      red_queue.close();
+    });
+
+  // Stage #0b : load event records
+  std::thread udd_reader_thread([&]() {
+      try {
+        bool end_of_input = false;
+        while (!end_of_input)
+          {
+            record_batch_ptr batch(new record_batch);
+            batch->records.reserve(batch_size);
+            while (batch->records.size() < batch_size)
+              {
+                std::unique_ptr<datatools::things> event_record(new datatools::things);
+                dpp::base_module::process_status status = udd_source_.process(*event_record);
+                if (status != dpp::base_module::PROCESS_OK)
+                  {
+                    DT_LOG_DEBUG(config_.logging, "Cannot process another event record, status is " << status);
+                    end_of_input = true;
+                    break;
+                  }
+                batch->records.push_back(std::move(event_record));
+              }
+            if (batch->records.empty()) break;
+            if (!record_queue.push(std::move(batch))) break;
           }
-        } else {
-          if (udd_calo_hit.get_geom_id() == red_calo_hit.get_geom_id()
-              && udd_calo_hit.get_hit_id()  == red_calo_hit.get_hit_id()
-              && udd_calo_hit.get_timestamp() == red_calo_hit.get_reference_time().get_ticks()
-              && udd_calo_hit.is_low_threshold_only() == red_calo_hit.is_low_threshold_only()
-              && udd_calo_hit.is_high_threshold() == red_calo_hit.is_high_threshold()
-              && udd_calo_hit.get_fcr() == red_calo_hit.get_fcr()
-              && udd_calo_hit.get_lt_trigger_counter() == red_calo_hit.get_lt_trigger_counter()
-              && udd_calo_hit.get_lt_time_counter() == red_calo_hit.get_lt_time_counter()
-              && udd_calo_hit.get_fwmeas_baseline() == red_calo_hit.get_fwmeas_baseline()
-              && udd_calo_hit.get_fwmeas_peak_amplitude() == red_calo_hit.get_fwmeas_peak_amplitude()
-              && udd_calo_hit.get_fwmeas_peak_cell() == red_calo_hit.get_fwmeas_peak_cell()
-              && udd_calo_hit.get_fwmeas_charge() == red_calo_hit.get_fwmeas_charge()
-              && udd_calo_hit.get_fwmeas_rising_cell() == red_calo_hit.get_fwmeas_rising_cell()
-              && udd_calo_hit.get_fwmeas_falling_cell() == red_calo_hit.get_fwmeas_falling_cell()
-              && udd_calo_hit.get_origin().get_hit_number() == red_calo_hit.get_origin().get_hit_number()
-              && udd_calo_hit.get_origin().get_trigger_id() == red_calo_hit.get_origin().get_trigger_id()) {
-            DT_LOG_DEBUG(logging_, "Corresponding UDD calo is valid.");
-            is_corresponding_calo_valid = true;
+      }
+      catch (...) {
+        udd_reader_error = std::current_exception();
+        stop_all();
+      }
+      record_queue.close();
+    });
+
+  // Stage #1 : pair the RED events with their event records
+  std::size_t unmatched_records = 0;
+  std::thread matcher_thread([&]() {
+      try {
+        record_batch_ptr records;
+        std::size_t next_record = 0;
+        const record_source_type next_record_source = [&]() {
+          std::unique_ptr<datatools::things> event_record;
+          while (!records || next_record == records->records.size())
+            {
+              next_record = 0;
+              if (!record_queue.pop(records)) return event_record;
+            }
+          event_record = std::move(records->records[next_record++]);
+          return event_record;
+        };
+        event_record_window window(next_record_source, config_.join_window, config_.logging);
+        std::size_t seq = 0;
+        red_batch_ptr reds;
+        while (red_queue.pop(reds))
+          {
+            {
+              std::unique_lock<std::mutex> lock(flight_mutex);
+              flight_cv.wait(lock, [&] { return stopping || in_flight < max_in_flight; });
+              if (stopping) break;
+              in_flight++;
+            }
+            pair_batch_ptr batch(new pair_batch);
+            batch->seq = seq++;
+            batch->pairs.resize(reds->reds.size());
+            for (std::size_t ievent = 0; ievent < reds->reds.size(); ievent++)
+              {
+                event_pair & pair = batch->pairs[ievent];
+                pair.red = std::move(reds->reds[ievent]);
+                pair.event_record = window.take(pair.red.get_run_id(), pair.red.get_event_id());
+              }
+            if (!todo_queue.push(std::move(batch))) break;
           }
-        }
+        unmatched_records = window.get_number_of_unmatched_records();
       }
-
-      list_calos_corresponding.push_back(is_corresponding_calo_valid);
-
-    } // end of calo red ihit
-
-  } // end of if n_red_calo == n_udd_calo
-
-  if (!list_calos_corresponding.empty()) is_calo_equivalent = std::all_of(list_calos_corresponding.begin(), list_calos_corresponding.end(), [](bool v) { return v; });
-  DT_LOG_DEBUG(logging_, "Calo is equivalent = " << is_calo_equivalent);
-
-  bool is_tracker_equivalent = false;
-
-  // RED Digitized tracker hits
-  const std::vector<snfee::data::tracker_digitized_hit> red_tracker_hits = red_.get_tracker_hits();
-
-  std::size_t number_red_tracker_hits = red_tracker_hits.size();
-  std::size_t number_udd_tracker_hits = UDD.get_tracker_hits().size();
-  if (number_red_tracker_hits == 0 && number_udd_tracker_hits == 0) is_tracker_equivalent = true;
-
-  DT_LOG_DEBUG(logging_, "Number of RED tracker hits = " << number_red_tracker_hits);
-  DT_LOG_DEBUG(logging_, "Number of UDD tracker hits = " << number_udd_tracker_hits);
-
-  std::vector<bool> list_trackers_corresponding;
-
-  if (number_red_tracker_hits == number_udd_tracker_hits) {
-
-    for (std::size_t ihit = 0; ihit < red_tracker_hits.size(); ihit++) {
-      snfee::data::tracker_digitized_hit red_tracker_hit = red_tracker_hits[ihit];
-      bool is_corresponding_udd_tracker_find = false;
-      std::size_t udd_tracker_counter = 0;
-
-      snemo::datamodel::tracker_digitized_hit udd_tracker_hit;
-
-      while (!is_corresponding_udd_tracker_find && udd_tracker_counter < number_udd_tracker_hits) {
-        udd_tracker_hit = UDD.get_tracker_hits()[udd_tracker_counter].get();
-
-        if (udd_tracker_hit.get_geom_id() ==  red_tracker_hit.get_geom_id()
-            && udd_tracker_hit.get_hit_id() == red_tracker_hit.get_hit_id()) is_corresponding_udd_tracker_find = true;
-        udd_tracker_counter++;
+      catch (...) {
+        matcher_error = std::current_exception();
+        stop_all();
       }
+      // The remaining event records are not needed anymore
+      record_queue.close();
+      todo_queue.close();
+    });
+
+  // Stage #2 : comparison workers
+  std::size_t running_workers = config_.nworkers;
+  std::mutex workers_mutex;
+  std::vector<std::thread> worker_threads;
+  for (std::size_t iworker = 0; iworker < config_.nworkers; iworker++)
+    {
+      worker_threads.emplace_back([&, iworker]() {
+          try {
+            pair_batch_ptr batch;
+            while (todo_queue.pop(batch))
+              {
+                for (auto & pair : batch->pairs) compare_event_pair(pair, config_);
+                if (!done_queue.push(std::move(batch))) break;
+              }
+          }
+          catch (...) {
+            worker_errors[iworker] = std::current_exception();
+            stop_all();
+          }
+          std::lock_guard<std::mutex> lock(workers_mutex);
+          if (--running_workers == 0) done_queue.close();
+        });
+    }
 
-      bool is_corresponding_tracker_valid = false;
-
-      // Compare tracker hit per attributes
-      // create a vector of a boolean for each tracker hit already checked
-
-      // GO Note/Warning, number of GG times are the same for now between RED and UDD but it might not be the case in a near future
-      // if we change the event builder algorithm and decide to remove the 'deduplication' for tracker hits.
-      // Not sure how it will impact RED format and then get propagated to UDD format
-      if (is_corresponding_udd_tracker_find
-          && red_tracker_hit.get_times().size() == udd_tracker_hit.get_times().size()) {
-
-        std::vector<bool> list_timestamps_corresponding;
-        bool is_corresponding_timestamp_valid = false;
-        for (std::size_t iggtime = 0; iggtime < red_tracker_hit.get_times().size(); iggtime++)
+  // Stage #3 : aggregate the results in event order (current thread)
+  std::exception_ptr collector_error;
+  try {
+    std::map<std::size_t, pair_batch_ptr> reorder_buffer;
+    std::size_t next_seq = 0;
+    pair_batch_ptr batch;
+    while (done_queue.pop(batch))
+      {
+        reorder_buffer[batch->seq] = std::move(batch);
+        auto found = reorder_buffer.find(next_seq);
+        while (found != reorder_buffer.end())
           {
-            DT_LOG_DEBUG(logging_, "Corresponding UDD tracker is valid.");
-            // Retrieve RED and UDD GG timestamps
-            const snfee::data::tracker_digitized_hit::gg_times      & red_gg_timestamp = red_tracker_hit.get_times()[iggtime];
-            const snemo::datamodel::tracker_digitized_hit::gg_times & udd_gg_timestamp = udd_tracker_hit.get_times()[iggtime];
-            is_corresponding_tracker_valid = true;
-            if (udd_tracker_hit.get_geom_id() ==  red_tracker_hit.get_geom_id()
-                && udd_tracker_hit.get_hit_id() == red_tracker_hit.get_hit_id()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R0).get_hit_number() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R0).get_hit_number()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R0).get_trigger_id() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R0).get_trigger_id()
-                && udd_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R0) == red_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R0).get_ticks()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R1).get_hit_number() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R1).get_hit_number()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R1).get_trigger_id() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R1).get_trigger_id()
-                && udd_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R1) == red_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R1).get_ticks()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R2).get_hit_number() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R2).get_hit_number()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R2).get_trigger_id() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R2).get_trigger_id()
-                && udd_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R2) == red_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R2).get_ticks()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R3).get_hit_number() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R3).get_hit_number()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R3).get_trigger_id() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R3).get_trigger_id()
-                && udd_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R3) == red_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R3).get_ticks()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R4).get_hit_number() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R4).get_hit_number()
-                && udd_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R4).get_trigger_id() == red_gg_timestamp.get_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R4).get_trigger_id()
-                && udd_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R4) == red_gg_timestamp.get_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R4).get_ticks()
-                && udd_gg_timestamp.get_bottom_cathode_origin().get_hit_number() == red_gg_timestamp.get_bottom_cathode_origin().get_hit_number()
-                && udd_gg_timestamp.get_bottom_cathode_origin().get_trigger_id() == red_gg_timestamp.get_bottom_cathode_origin().get_trigger_id()
-                && udd_gg_timestamp.get_bottom_cathode_time() == red_gg_timestamp.get_bottom_cathode_time().get_ticks()
-                && udd_gg_timestamp.get_top_cathode_origin().get_hit_number() == red_gg_timestamp.get_top_cathode_origin().get_hit_number()
-                && udd_gg_timestamp.get_top_cathode_origin().get_trigger_id() == red_gg_timestamp.get_top_cathode_origin().get_trigger_id()
-                && udd_gg_timestamp.get_top_cathode_time() == red_gg_timestamp.get_top_cathode_time().get_ticks())
-              is_corresponding_timestamp_valid = true;
+            for (const auto & pair : found->second->pairs) collect_event_pair(pair, config_.logging, results_);
+            reorder_buffer.erase(found);
+            {
+              std::lock_guard<std::mutex> lock(flight_mutex);
+              in_flight--;
+            }
+            flight_cv.notify_one();
+            found = reorder_buffer.find(++next_seq);
           }
-        list_timestamps_corresponding.push_back(is_corresponding_timestamp_valid);
-        if (!list_timestamps_corresponding.empty()) is_corresponding_tracker_valid = std::all_of(list_timestamps_corresponding.begin(), list_timestamps_corresponding.end(), [](bool v) { return v; });
-        list_trackers_corresponding.push_back(is_corresponding_tracker_valid);
-      } // end of is_corresponding_udd
-
-    } // end of tracker red ihit
-
-  } // end of if n_red_calo == n_udd_calo
-
-  if (!list_trackers_corresponding.empty()) is_tracker_equivalent = std::all_of(list_trackers_corresponding.begin(), list_trackers_corresponding.end(), [](bool v) { return v; });
-  DT_LOG_DEBUG(logging_, "Tracker is equivalent = " << is_tracker_equivalent);
-
-  DT_LOG_DEBUG(logging_, "EH is equivalent = " << is_event_header_equivalent
-               << " UDD global is equivalent = " << is_udd_global_equivalent
-               << " UDD Calo is equivalent = " << is_calo_equivalent
-               << " UDD Tracker is equivalent = " << is_tracker_equivalent);
-  if (is_event_header_equivalent && is_udd_global_equivalent && is_calo_equivalent && is_tracker_equivalent) red_er_is_equivalent = true;
-  DT_LOG_DEBUG(logging_, "RED is equivalent to Event Record = " << red_er_is_equivalent);
-
-
-  return red_er_is_equivalent;
+      }
+  }
+  catch (...) {
+    collector_error = std::current_exception();
+  }
+  stop_all();
+
+  red_reader_thread.join();
+  udd_reader_thread.join();
+  matcher_thread.join();
+  for (auto & worker_thread : worker_threads) worker_thread.join();
+
+  if (red_reader_error) std::rethrow_exception(red_reader_error);
+  if (udd_reader_error) std::rethrow_exception(udd_reader_error);
+  if (matcher_error) std::rethrow_exception(matcher_error);
+  for (const auto & worker_error : worker_errors)
+    if (worker_error) std::rethrow_exception(worker_error);
+  if (collector_error) std::rethrow_exception(collector_error);
+  results_.unmatched_record_counter = unmatched_records;
+  return;
 }
@@ -0,0 +1,108 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/bounded_queue.h
+///
+/// Bounded blocking FIFO queue used to link the stages of the
+/// SNREDBridge processing pipelines (reader, converter, writer...).
+
+#ifndef SNREDBRIDGE_BOUNDED_QUEUE_H
+#define SNREDBRIDGE_BOUNDED_QUEUE_H
+
+// Standard library:
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace snredbridge {
+
+  /// \brief Bounded multi-producer/multi-consumer FIFO queue
+  ///
+  /// Producers block while the queue is full, consumers block while it
+  /// is empty. Closing the queue wakes everybody up: further pushes are
+  /// rejected and consumers drain the remaining items before stopping.
+  template <typename T>
+  class bounded_queue
+  {
+  public:
+
+    /// Constructor
+    explicit bounded_queue(std::size_t capacity_)
+      : _capacity_(capacity_ == 0 ? 1 : capacity_)
+    {
+    }
+
+    /// Push an item, waiting for a free slot. Return false if the queue is closed
+    bool push(T && item_)
+    {
+      std::unique_lock<std::mutex> lock(_mutex_);
+      _not_full_.wait(lock, [this] { return _closed_ || _items_.size() < _capacity_; });
+      if (_closed_) return false;
+      _items_.push_back(std::move(item_));
+      lock.unlock();
+      _not_empty_.notify_one();
+      return true;
+    }
+
+    /// Pop the oldest item, waiting for one. Return false once the queue is closed and drained
+    bool pop(T & item_)
+    {
+      std::unique_lock<std::mutex> lock(_mutex_);
+      _not_empty_.wait(lock, [this] { return _closed_ || !_items_.empty(); });
+      if (_items_.empty()) return false;
+      item_ = std::move(_items_.front());
+      _items_.pop_front();
+      lock.unlock();
+      _not_full_.notify_one();
+      return true;
+    }
+
+    /// Pop the oldest item if any, without waiting. Return false if the queue is empty
+    bool try_pop(T & item_)
+    {
+      std::unique_lock<std::mutex> lock(_mutex_);
+      if (_items_.empty()) return false;
+      item_ = std::move(_items_.front());
+      _items_.pop_front();
+      lock.unlock();
+      _not_full_.notify_one();
+      return true;
+    }
+
+    /// Close the queue and wake up all waiting producers and consumers
+    void close()
+    {
+      {
+        std::lock_guard<std::mutex> lock(_mutex_);
+        _closed_ = true;
+      }
+      _not_full_.notify_all();
+      _not_empty_.notify_all();
+    }
+
+    /// Check if the queue is closed
+    bool is_closed() const
+    {
+      std::lock_guard<std::mutex> lock(_mutex_);
+      return _closed_;
+    }
+
+    /// Return the maximum number of queued items
+    std::size_t get_capacity() const
+    {
+      return _capacity_;
+    }
+
+  private:
+
+    const std::size_t _capacity_;      ///< Maximum number of queued items
+    bool _closed_ = false;             ///< Closed flag
+    std::deque<T> _items_;             ///< Queued items
+    mutable std::mutex _mutex_;        ///< Lock protecting the queue
+    std::condition_variable _not_full_;  ///< Signaled when a slot is released
+    std::condition_variable _not_empty_; ///< Signaled when an item is queued
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_BOUNDED_QUEUE_H
@@ -0,0 +1,173 @@
+// This project:
+#include <snredbridge/channel_table.h>
+
+// Standard library:
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+// - Falaise:
+#include <falaise/snemo/datamodels/geomid_utils.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    // Max number of hits sorted by insertion
+    const std::size_t insertion_sort_max_hits = 32;
+
+    /// Compute the ranks of the hits in channel order (stable)
+    void compute_channel_order(const std::vector<int> & channels_,
+                               const std::size_t nchannels_,
+                               std::vector<uint32_t> & order_)
+    {
+      const std::size_t nhits = channels_.size();
+      order_.resize(nhits);
+      for (std::size_t ihit = 0; ihit < nhits; ihit++) order_[ihit] = ihit;
+      if (nhits <= insertion_sort_max_hits) {
+        for (std::size_t ihit = 1; ihit < nhits; ihit++) {
+          const uint32_t rank = order_[ihit];
+          std::size_t jhit = ihit;
+          for (; jhit > 0 && channels_[order_[jhit - 1]] > channels_[rank]; jhit--) order_[jhit] = order_[jhit - 1];
+          order_[jhit] = rank;
+        }
+        return;
+      }
+      const bool in_table = std::all_of(channels_.begin(), channels_.end(),
+                                        [nchannels_](const int channel_) {
+                                          return channel_ >= -1 && channel_ < static_cast<int>(nchannels_);
+                                        });
+      if (!in_table) {
+        std::stable_sort(order_.begin(), order_.end(),
+                         [&channels_](const uint32_t a_, const uint32_t b_) { return channels_[a_] < channels_[b_]; });
+        return;
+      }
+      // Counting sort on channel + 1 (the hits without channel, -1, first)
+      std::vector<uint32_t> offsets(nchannels_ + 2, 0);
+      for (const int channel : channels_) offsets[channel + 2]++;
+      for (std::size_t ioffset = 1; ioffset < offsets.size(); ioffset++) offsets[ioffset] += offsets[ioffset - 1];
+      for (std::size_t ihit = 0; ihit < nhits; ihit++) order_[offsets[channels_[ihit] + 1]++] = ihit;
+    }
+
+    /// Sort hits by channel, moving the handles in place
+    template <class HitCollection>
+    void sort_hits(HitCollection & hits_, const channel_table & table_)
+    {
+      const std::size_t nhits = hits_.size();
+      if (nhits < 2) return;
+      std::vector<int> channels(nhits);
+      bool sorted = true;
+      for (std::size_t ihit = 0; ihit < nhits; ihit++) {
+        channels[ihit] = table_.get_channel(hits_[ihit]->get_geom_id());
+        if (ihit > 0 && channels[ihit] < channels[ihit - 1]) sorted = false;
+      }
+      if (sorted) return;
+      std::vector<uint32_t> order;
+      compute_channel_order(channels, table_.size(), order);
+      // Apply the permutation cycle by cycle (hit ihit takes hit order[ihit])
+      std::vector<bool> placed(nhits, false);
+      for (std::size_t ihit = 0; ihit < nhits; ihit++) {
+        if (placed[ihit] || order[ihit] == ihit) continue;
+        auto first = std::move(hits_[ihit]);
+        std::size_t jhit = ihit;
+        while (true) {
+          placed[jhit] = true;
+          const std::size_t khit = order[jhit];
+          if (khit == ihit) {
+            hits_[jhit] = std::move(first);
+            break;
+          }
+          hits_[jhit] = std::move(hits_[khit]);
+          jhit = khit;
+        }
+      }
+    }
+
+  } // end of anonymous namespace
+
+  channel_table::channel_table(numbering_function numbering_, const std::vector<layout> & layouts_)
+    : _numbering_(numbering_)
+  {
+    DT_THROW_IF(_numbering_ == nullptr, std::logic_error, "Missing channel numbering function!");
+    int max_channel = -1;
+    for (const auto & the_layout : layouts_) {
+      type_table table;
+      table.type = the_layout.type;
+      table.extents = the_layout.extents;
+      std::size_t naddresses = 1;
+      for (const uint32_t extent : table.extents) naddresses *= extent;
+      table.channels.resize(naddresses, -1);
+      geomtools::geom_id geom_id;
+      geom_id.set_type(table.type);
+      geom_id.set_depth(table.extents.size() + 1);
+      geom_id.set(0, 0);
+      for (std::size_t iaddress = 0; iaddress < naddresses; iaddress++) {
+        // Address components of the flat index (last component fastest)
+        std::size_t rest = iaddress;
+        for (std::size_t icomponent = table.extents.size(); icomponent > 0; icomponent--) {
+          geom_id.set(icomponent, rest % table.extents[icomponent - 1]);
+          rest /= table.extents[icomponent - 1];
+        }
+        table.channels[iaddress] = _numbering_(geom_id);
+        max_channel = std::max(max_channel, table.channels[iaddress]);
+      }
+      _types_.push_back(std::move(table));
+    }
+    _size_ = max_channel + 1;
+  }
+
+  const channel_table & channel_table::calorimeter()
+  {
+    // Main walls (module, side, column, row, part), X-walls (module, side,
+    // wall, column, row) and gamma vetos (module, side, wall, column)
+    static const channel_table table(&snemo::datamodel::om_num,
+                                     {{1302, {2, 20, 13}}, {1232, {2, 2, 2, 16}}, {1252, {2, 2, 16}}});
+    return table;
+  }
+
+  const channel_table & channel_table::tracker()
+  {
+    // Geiger cells (module, side, layer, row)
+    static const channel_table table(&snemo::datamodel::gg_num, {{1204, {2, 9, 113}}});
+    return table;
+  }
+
+  std::size_t channel_table::size() const
+  {
+    return _size_;
+  }
+
+  int channel_table::get_channel(const geomtools::geom_id & geom_id_) const
+  {
+    const uint32_t type = geom_id_.get_type();
+    for (const auto & table : _types_) {
+      if (table.type != type) continue;
+      if (geom_id_.get_depth() <= table.extents.size()) break;
+      std::size_t iaddress = 0;
+      std::size_t icomponent = 0;
+      for (; icomponent < table.extents.size(); icomponent++) {
+        const uint32_t component = geom_id_.get(icomponent + 1);
+        if (component >= table.extents[icomponent]) break;
+        iaddress = iaddress * table.extents[icomponent] + component;
+      }
+      if (icomponent < table.extents.size()) break;
+      return table.channels[iaddress];
+    }
+    return _numbering_(geom_id_);
+  }
+
+  void sort_by_channel(snemo::datamodel::CalorimeterDigiHitHdlCollection & hits_)
+  {
+    sort_hits(hits_, channel_table::calorimeter());
+  }
+
+  void sort_by_channel(snemo::datamodel::TrackerDigiHitHdlCollection & hits_)
+  {
+    sort_hits(hits_, channel_table::tracker());
+  }
+
+} // end of namespace snredbridge
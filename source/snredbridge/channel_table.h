@@ -0,0 +1,143 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/channel_table.h
+///
+/// Dense geometry ID to channel number (OM number, GG cell number) tables
+/// and channel ordering of the UDD hits.
+
+#ifndef SNREDBRIDGE_CHANNEL_TABLE_H
+#define SNREDBRIDGE_CHANNEL_TABLE_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/handle.h>
+#include <bayeux/geomtools/geom_id.h>
+
+// - Falaise:
+#include <falaise/snemo/datamodels/calorimeter_digitized_hit.h>
+#include <falaise/snemo/datamodels/tracker_digitized_hit.h>
+
+namespace snredbridge {
+
+  /// \brief Geometry ID to channel number lookup table
+  ///
+  /// For each geometry type of the channels, the channel number of every
+  /// address is computed once, with the Falaise numbering function, and
+  /// stored in a dense array indexed by the address. A lookup is then a few
+  /// bound checks and one array access. Addresses outside the table (or of
+  /// other types) fall back to the numbering function, so the result is
+  /// always the one of the numbering function.
+  class channel_table
+  {
+  public:
+
+    /// Numbering function (e.g. snemo::datamodel::om_num)
+    typedef int (*numbering_function)(const geomtools::geom_id &);
+
+    /// Address layout of a geometry type
+    struct layout
+    {
+      uint32_t type = 0;              ///< Geometry type
+      std::vector<uint32_t> extents;  ///< Ranges of the address components 1, 2... (component 0, the module, is ignored)
+    };
+
+    /// Constructor: fill the tables of the given layouts
+    channel_table(numbering_function numbering_, const std::vector<layout> & layouts_);
+
+    /// Return the table of the calorimeter optical modules (main walls,
+    /// X-walls and gamma vetos), numbered by snemo::datamodel::om_num
+    static const channel_table & calorimeter();
+
+    /// Return the table of the tracker Geiger cells, numbered by
+    /// snemo::datamodel::gg_num
+    static const channel_table & tracker();
+
+    /// Return the number of channels (highest channel number + 1)
+    std::size_t size() const;
+
+    /// Return the channel number of a geometry ID (negative if it is not a channel)
+    int get_channel(const geomtools::geom_id & geom_id_) const;
+
+  private:
+
+    /// Channel numbers of a geometry type
+    struct type_table
+    {
+      uint32_t type = 0;              ///< Geometry type
+      std::vector<uint32_t> extents;  ///< Ranges of the address components 1, 2...
+      std::vector<int32_t> channels;  ///< Channel number of each address
+    };
+
+    numbering_function _numbering_;   ///< Numbering function
+    std::vector<type_table> _types_;  ///< Tables of the geometry types
+    std::size_t _size_ = 0;           ///< Number of channels
+
+  };
+
+  /// \brief Lookup of digitized hits by (geometry ID, hit ID)
+  ///
+  /// The hits are chained by channel from a dense table of chain heads
+  /// indexed by the channel number, so that a lookup only compares the
+  /// hits of its channel. The hits without channel share one extra chain.
+  /// For duplicated keys, the first hit of the collection is found.
+  template <class Hit>
+  class channel_hit_index
+  {
+  public:
+
+    typedef std::vector<datatools::handle<Hit>> collection_type;
+
+    /// Constructor: index a collection of hits (which must outlive the index)
+    channel_hit_index(const collection_type & hits_, const channel_table & table_)
+      : _hits_(hits_), _table_(table_), _heads_(table_.size() + 1, -1), _next_(hits_.size(), -1)
+    {
+      // Chained backward so that each chain is in collection order
+      for (std::size_t ihit = hits_.size(); ihit-- > 0; ) {
+        const std::size_t slot = _slot_(hits_[ihit]->get_geom_id());
+        _next_[ihit] = _heads_[slot];
+        _heads_[slot] = ihit;
+      }
+    }
+
+    /// Return the hit with the given key, or nullptr
+    const Hit * find(const geomtools::geom_id & geom_id_, const int32_t hit_id_) const
+    {
+      for (int32_t ihit = _heads_[_slot_(geom_id_)]; ihit >= 0; ihit = _next_[ihit]) {
+        const Hit & hit = _hits_[ihit].get();
+        if (hit.get_hit_id() == hit_id_ && hit.get_geom_id() == geom_id_) return &hit;
+      }
+      return nullptr;
+    }
+
+  private:
+
+    std::size_t _slot_(const geomtools::geom_id & geom_id_) const
+    {
+      const int channel = _table_.get_channel(geom_id_);
+      return (channel >= 0 && static_cast<std::size_t>(channel) < _table_.size()) ? channel : _table_.size();
+    }
+
+    const collection_type & _hits_;   ///< Indexed hits
+    const channel_table & _table_;    ///< Channel numbering
+    std::vector<int32_t> _heads_;     ///< First hit of each channel (last one: hits without channel)
+    std::vector<int32_t> _next_;      ///< Next hit of the same channel
+
+  };
+
+  /// Sort UDD calorimeter hits by OM number
+  ///
+  /// The OM number of each hit is looked up once. The order of the hits of
+  /// a same OM is kept. Small collections are insertion-sorted, larger ones
+  /// counting-sorted over the OM numbers.
+  void sort_by_channel(snemo::datamodel::CalorimeterDigiHitHdlCollection & hits_);
+
+  /// Sort UDD tracker hits by GG cell number (same method)
+  void sort_by_channel(snemo::datamodel::TrackerDigiHitHdlCollection & hits_);
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_CHANNEL_TABLE_H
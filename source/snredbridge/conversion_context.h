@@ -0,0 +1,43 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/conversion_context.h
+///
+/// Per-run state of the RED to UDD conversion.
+
+#ifndef SNREDBRIDGE_CONVERSION_CONTEXT_H
+#define SNREDBRIDGE_CONVERSION_CONTEXT_H
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+// - Falaise:
+#include <falaise/snemo/datamodels/timestamp.h>
+
+// This project:
+#include <snredbridge/waveform_roi.h>
+
+namespace snredbridge {
+
+  /// \brief Per-run context shared by the RED to UDD conversion workers
+  ///
+  /// The configuration part is set once before the run starts and is only
+  /// read afterwards, so several conversion workers can share it. The
+  /// chaining state (previous event timestamp) is only updated by the
+  /// sequential fix-up pass applied in event order.
+  struct conversion_context
+  {
+    // Configuration:
+    bool no_waveform = false;             ///< Do not copy the calorimeter waveforms
+    waveform_roi_config waveform_roi;     ///< Stored part and encoding of the calorimeter waveforms
+    double run_sync_time = 0;             ///< UNIX time (s) of the run TDC=0 reference
+    double run_start_time = 0;            ///< Skip events before this time (s) from run_sync_time
+    double run_end_time = 86400*365.24;   ///< Crop events after this time (s) from run_sync_time
+    datatools::logger::priority logging = datatools::logger::PRIO_WARNING; ///< Logging priority
+
+    // Chaining state:
+    snemo::datamodel::timestamp previous_eh_timestamp; ///< Timestamp of the previous RED event, stored or not (rejected, skipped)
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_CONVERSION_CONTEXT_H
@@ -0,0 +1,394 @@
+// This project:
+#include <snredbridge/event_digest.h>
+
+// Standard library:
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+// - Falaise:
+#include <falaise/snemo/datamodels/event_header.h>
+#include <falaise/snemo/datamodels/unified_digitized_data.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    const char digest_magic[8] = {'S', 'N', 'R', 'B', 'D', 'I', 'G', 'S'};
+    const uint32_t digest_version = 2;
+    const uint32_t digest_flag_waveform = 0x1;
+    const uint32_t digest_flag_stored_records = 0x2;
+
+    const uint64_t prime_1 = 0x9e3779b185ebca87ULL;
+    const uint64_t prime_2 = 0xc2b2ae3d27d4eb4fULL;
+
+    inline uint64_t rotl64(const uint64_t x_, const int r_)
+    {
+      return (x_ << r_) | (x_ >> (64 - r_));
+    }
+
+    // Final avalanche of a 64-bit value (MurmurHash3 fmix64)
+    inline uint64_t avalanche(uint64_t h_)
+    {
+      h_ ^= h_ >> 33;
+      h_ *= 0xff51afd7ed558ccdULL;
+      h_ ^= h_ >> 33;
+      h_ *= 0xc4ceb9fe1a85ec53ULL;
+      h_ ^= h_ >> 33;
+      return h_;
+    }
+
+    const decltype(snemo::datamodel::tracker_digitized_hit::ANODE_R0) anode_indexes[5] = {
+      snemo::datamodel::tracker_digitized_hit::ANODE_R0,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R1,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R2,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R3,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R4
+    };
+
+    void add_geom_id(digest_hasher & hasher_, const geomtools::geom_id & gid_)
+    {
+      hasher_.add<uint32_t>(gid_.get_type());
+      hasher_.add<uint32_t>(gid_.get_depth());
+      for (std::size_t i = 0; i < gid_.get_depth(); i++) {
+        hasher_.add<uint32_t>(gid_.get(i));
+      }
+    }
+
+    template <typename Origin>
+    void add_origin(digest_hasher & hasher_, const Origin & origin_)
+    {
+      hasher_.add<int32_t>(origin_.get_hit_number());
+      hasher_.add<int32_t>(origin_.get_trigger_id());
+    }
+
+    // Fields shared by RED and UDD calorimeter hits, except the timestamp
+    // which is stored differently
+    template <typename CaloHit>
+    void add_calo_fields(digest_hasher & hasher_, const CaloHit & hit_)
+    {
+      add_geom_id(hasher_, hit_.get_geom_id());
+      hasher_.add<uint8_t>(hit_.is_low_threshold_only() ? 1 : 0);
+      hasher_.add<uint8_t>(hit_.is_high_threshold() ? 1 : 0);
+      hasher_.add<uint32_t>(hit_.get_fcr());
+      hasher_.add<uint32_t>(hit_.get_lt_trigger_counter());
+      hasher_.add<uint32_t>(hit_.get_lt_time_counter());
+      hasher_.add<int32_t>(hit_.get_fwmeas_baseline());
+      hasher_.add<int32_t>(hit_.get_fwmeas_peak_amplitude());
+      hasher_.add<int32_t>(hit_.get_fwmeas_peak_cell());
+      hasher_.add<int32_t>(hit_.get_fwmeas_charge());
+      hasher_.add<int32_t>(hit_.get_fwmeas_rising_cell());
+      hasher_.add<int32_t>(hit_.get_fwmeas_falling_cell());
+      add_origin(hasher_, hit_.get_origin());
+    }
+
+    // Samples of a waveform, and their window in the RED waveform if it is
+    // stored in ROI/delta mode
+    void add_waveform(digest_hasher & hasher_,
+                      const int16_t * samples_,
+                      const std::size_t nsamples_,
+                      const waveform_window * window_,
+                      const std::size_t full_length_)
+    {
+      hasher_.add<uint64_t>(nsamples_);
+      if (nsamples_ > 0) hasher_.update(samples_, nsamples_ * sizeof(samples_[0]));
+      if (window_ != nullptr) {
+        hasher_.add<uint64_t>(window_->offset);
+        hasher_.add<uint64_t>(full_length_);
+      }
+    }
+
+    // Combine the hit digests of an event independently of the hit order
+    struct hit_digest_sum
+    {
+      void add(const uint64_t digest_)
+      {
+        sum += digest_;
+        count++;
+      }
+
+      void fold_into(digest_hasher & hasher_) const
+      {
+        hasher_.add<uint64_t>(count);
+        hasher_.add<uint64_t>(sum);
+      }
+
+      uint64_t sum = 0;
+      uint64_t count = 0;
+    };
+
+  } // end of anonymous namespace
+
+  void digest_hasher::update(const void * data_, const std::size_t size_)
+  {
+    const unsigned char * bytes = static_cast<const unsigned char *>(data_);
+    std::size_t remaining = size_;
+    while (remaining >= sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, bytes, sizeof(word));
+      _state_ = rotl64(_state_ ^ (word * prime_2), 31) * prime_1;
+      bytes += sizeof(word);
+      remaining -= sizeof(word);
+    }
+    if (remaining > 0) {
+      uint64_t word = 0;
+      std::memcpy(&word, bytes, remaining);
+      _state_ = rotl64(_state_ ^ ((word ^ remaining) * prime_2), 27) * prime_1;
+    }
+    _length_ += size_;
+  }
+
+  uint64_t digest_hasher::get_digest() const
+  {
+    return avalanche(_state_ ^ _length_);
+  }
+
+  uint64_t digest_red_event(const snfee::data::raw_event_data & red_,
+                            const bool with_waveform_,
+                            const waveform_roi_config * roi_)
+  {
+    digest_hasher hasher;
+    // Expected event header: same run/event numbers, real data
+    hasher.add<int32_t>(red_.get_run_id());
+    hasher.add<int32_t>(red_.get_event_id());
+    hasher.add<uint8_t>(1);
+    // UDD bank
+    hasher.add<int32_t>(red_.get_run_id());
+    hasher.add<int32_t>(red_.get_event_id());
+    hasher.add<int64_t>(red_.get_reference_time().get_ticks());
+    hasher.add<uint64_t>(red_.get_origin_trigger_ids().size());
+    for (const int32_t trigger_id : red_.get_origin_trigger_ids()) {
+      hasher.add<int32_t>(trigger_id);
+    }
+
+    hit_digest_sum calo_digests;
+    for (const auto & red_calo_hit : red_.get_calo_hits()) {
+      digest_hasher hit_hasher;
+      hit_hasher.add<int64_t>(red_calo_hit.get_reference_time().get_ticks());
+      add_calo_fields(hit_hasher, red_calo_hit);
+      if (with_waveform_) {
+        const auto & waveform = red_calo_hit.get_waveform();
+        if (roi_ != nullptr && roi_->is_active()) {
+          // Only the part stored in the UDD bank
+          const waveform_window window = compute_waveform_window(waveform.size(), red_calo_hit, *roi_);
+          add_waveform(hit_hasher, waveform.data() + window.offset, window.length, &window, waveform.size());
+        } else {
+          add_waveform(hit_hasher, waveform.data(), waveform.size(), nullptr, waveform.size());
+        }
+      }
+      calo_digests.add(hit_hasher.get_digest());
+    }
+    calo_digests.fold_into(hasher);
+
+    hit_digest_sum tracker_digests;
+    for (const auto & red_tracker_hit : red_.get_tracker_hits()) {
+      digest_hasher hit_hasher;
+      add_geom_id(hit_hasher, red_tracker_hit.get_geom_id());
+      hit_hasher.add<uint64_t>(red_tracker_hit.get_times().size());
+      for (const auto & red_gg_times : red_tracker_hit.get_times()) {
+        for (const auto anode_index : anode_indexes) {
+          add_origin(hit_hasher, red_gg_times.get_anode_origin(anode_index));
+          hit_hasher.add<int64_t>(red_gg_times.get_anode_time(anode_index).get_ticks());
+        }
+        add_origin(hit_hasher, red_gg_times.get_bottom_cathode_origin());
+        hit_hasher.add<int64_t>(red_gg_times.get_bottom_cathode_time().get_ticks());
+        add_origin(hit_hasher, red_gg_times.get_top_cathode_origin());
+        hit_hasher.add<int64_t>(red_gg_times.get_top_cathode_time().get_ticks());
+      }
+      tracker_digests.add(hit_hasher.get_digest());
+    }
+    tracker_digests.fold_into(hasher);
+
+    return hasher.get_digest();
+  }
+
+  uint64_t digest_event_record(const datatools::things & event_record_,
+                               const bool with_waveform_)
+  {
+    const auto & EH = event_record_.get<snemo::datamodel::event_header>("EH");
+    const auto & UDD = event_record_.get<snemo::datamodel::unified_digitized_data>("UDD");
+
+    digest_hasher hasher;
+    hasher.add<int32_t>(EH.get_id().get_run_number());
+    hasher.add<int32_t>(EH.get_id().get_event_number());
+    hasher.add<uint8_t>(EH.is_real() ? 1 : 0);
+    hasher.add<int32_t>(UDD.get_run_id());
+    hasher.add<int32_t>(UDD.get_event_id());
+    hasher.add<int64_t>(UDD.get_reference_timestamp());
+    hasher.add<uint64_t>(UDD.get_origin_trigger_ids().size());
+    for (const int32_t trigger_id : UDD.get_origin_trigger_ids()) {
+      hasher.add<int32_t>(trigger_id);
+    }
+
+    hit_digest_sum calo_digests;
+    for (const auto & udd_calo_hdl : UDD.get_calorimeter_hits()) {
+      const auto & udd_calo_hit = udd_calo_hdl.get();
+      digest_hasher hit_hasher;
+      hit_hasher.add<int64_t>(udd_calo_hit.get_timestamp());
+      add_calo_fields(hit_hasher, udd_calo_hit);
+      if (with_waveform_) {
+        const auto & stored = udd_calo_hit.get_waveform();
+        if (udd_calo_hit.get_auxiliaries().has_key(waveform_offset_key)) {
+          std::vector<int16_t> samples;
+          std::size_t full_length = 0;
+          const waveform_window window = decode_waveform(stored, udd_calo_hit.get_auxiliaries(), samples, full_length);
+          add_waveform(hit_hasher, samples.data(), samples.size(), &window, full_length);
+        } else {
+          add_waveform(hit_hasher, stored.data(), stored.size(), nullptr, stored.size());
+        }
+      }
+      calo_digests.add(hit_hasher.get_digest());
+    }
+    calo_digests.fold_into(hasher);
+
+    hit_digest_sum tracker_digests;
+    for (const auto & udd_tracker_hdl : UDD.get_tracker_hits()) {
+      const auto & udd_tracker_hit = udd_tracker_hdl.get();
+      digest_hasher hit_hasher;
+      add_geom_id(hit_hasher, udd_tracker_hit.get_geom_id());
+      hit_hasher.add<uint64_t>(udd_tracker_hit.get_times().size());
+      for (const auto & udd_gg_times : udd_tracker_hit.get_times()) {
+        for (const auto anode_index : anode_indexes) {
+          add_origin(hit_hasher, udd_gg_times.get_anode_origin(anode_index));
+          hit_hasher.add<int64_t>(udd_gg_times.get_anode_time(anode_index));
+        }
+        add_origin(hit_hasher, udd_gg_times.get_bottom_cathode_origin());
+        hit_hasher.add<int64_t>(udd_gg_times.get_bottom_cathode_time());
+        add_origin(hit_hasher, udd_gg_times.get_top_cathode_origin());
+        hit_hasher.add<int64_t>(udd_gg_times.get_top_cathode_time());
+      }
+      tracker_digests.add(hit_hasher.get_digest());
+    }
+    tracker_digests.fold_into(hasher);
+
+    return hasher.get_digest();
+  }
+
+  // Digest file writer
+
+  digest_file_writer::digest_file_writer(const std::string & filename_,
+                                         const bool with_waveform_,
+                                         const bool stored_records_)
+    : _filename_(filename_)
+  {
+    _out_.open(_filename_.c_str(), std::ios::binary | std::ios::trunc);
+    DT_THROW_IF(!_out_, std::runtime_error, "Cannot create digest file '" << _filename_ << "'!");
+    uint32_t flags = with_waveform_ ? digest_flag_waveform : 0;
+    if (stored_records_) flags |= digest_flag_stored_records;
+    _out_.write(digest_magic, sizeof(digest_magic));
+    _out_.write(reinterpret_cast<const char *>(&digest_version), sizeof(digest_version));
+    _out_.write(reinterpret_cast<const char *>(&flags), sizeof(flags));
+  }
+
+  void digest_file_writer::write(const digest_entry & entry_)
+  {
+    _out_.write(reinterpret_cast<const char *>(&entry_.run_id), sizeof(entry_.run_id));
+    _out_.write(reinterpret_cast<const char *>(&entry_.event_id), sizeof(entry_.event_id));
+    _out_.write(reinterpret_cast<const char *>(&entry_.digest), sizeof(entry_.digest));
+  }
+
+  void digest_file_writer::close()
+  {
+    if (!_out_.is_open()) return;
+    _out_.close();
+    DT_THROW_IF(_out_.fail(), std::runtime_error, "Failed to write digest file '" << _filename_ << "'!");
+  }
+
+  // Digest file reader
+
+  digest_file_reader::digest_file_reader(const std::string & filename_)
+    : _filename_(filename_)
+  {
+    _in_.open(_filename_.c_str(), std::ios::binary);
+    DT_THROW_IF(!_in_, std::runtime_error, "Cannot open digest file '" << _filename_ << "'!");
+    char magic[sizeof(digest_magic)];
+    uint32_t version = 0;
+    uint32_t flags = 0;
+    _in_.read(magic, sizeof(magic));
+    _in_.read(reinterpret_cast<char *>(&version), sizeof(version));
+    _in_.read(reinterpret_cast<char *>(&flags), sizeof(flags));
+    DT_THROW_IF(!_in_ || std::memcmp(magic, digest_magic, sizeof(magic)) != 0,
+                std::runtime_error, "File '" << _filename_ << "' is not a digest file!");
+    DT_THROW_IF(version != digest_version, std::runtime_error,
+                "Unsupported version " << version << " of digest file '" << _filename_ << "'!");
+    _with_waveform_ = (flags & digest_flag_waveform) != 0;
+    _stored_records_ = (flags & digest_flag_stored_records) != 0;
+  }
+
+  bool digest_file_reader::is_with_waveform() const
+  {
+    return _with_waveform_;
+  }
+
+  bool digest_file_reader::is_from_stored_records() const
+  {
+    return _stored_records_;
+  }
+
+  bool digest_file_reader::read(digest_entry & entry_)
+  {
+    _in_.read(reinterpret_cast<char *>(&entry_.run_id), sizeof(entry_.run_id));
+    _in_.read(reinterpret_cast<char *>(&entry_.event_id), sizeof(entry_.event_id));
+    _in_.read(reinterpret_cast<char *>(&entry_.digest), sizeof(entry_.digest));
+    return static_cast<bool>(_in_);
+  }
+
+  digest_comparison compare_digest_files(const std::string & red_digest_filename_,
+                                         const std::string & udd_digest_filename_,
+                                         const datatools::logger::priority logging_)
+  {
+    digest_file_reader red_digests(red_digest_filename_);
+    digest_file_reader udd_digests(udd_digest_filename_);
+    DT_THROW_IF(red_digests.is_with_waveform() != udd_digests.is_with_waveform(), std::logic_error,
+                "Digest files '" << red_digest_filename_ << "' and '" << udd_digest_filename_
+                << "' do not both cover (or ignore) the waveforms!");
+
+    digest_comparison result;
+    result.udd_from_stored_records = udd_digests.is_from_stored_records();
+    digest_entry red_entry;
+    digest_entry udd_entry;
+    bool has_red = red_digests.read(red_entry);
+    bool has_udd = udd_digests.read(udd_entry);
+    if (has_udd) result.udd_counter++;
+    while (has_red)
+      {
+        result.red_counter++;
+        const std::pair<int32_t, int32_t> red_key(red_entry.run_id, red_entry.event_id);
+        // Skip the UDD entries of events which are not in the RED stream
+        while (has_udd && std::make_pair(udd_entry.run_id, udd_entry.event_id) < red_key)
+          {
+            has_udd = udd_digests.read(udd_entry);
+            if (has_udd) result.udd_counter++;
+          }
+        if (has_udd && std::make_pair(udd_entry.run_id, udd_entry.event_id) == red_key)
+          {
+            if (udd_entry.digest == red_entry.digest) result.equal_counter++;
+            else
+              {
+                DT_LOG_DEBUG(logging_, "Digests differ for run #" << red_entry.run_id << " event #" << red_entry.event_id);
+                result.different_counter++;
+                result.suspicious_events.insert(red_key);
+              }
+            has_udd = udd_digests.read(udd_entry);
+            if (has_udd) result.udd_counter++;
+          }
+        else
+          {
+            DT_LOG_DEBUG(logging_, "No UDD digest for run #" << red_entry.run_id << " event #" << red_entry.event_id);
+            result.missing_counter++;
+            result.suspicious_events.insert(red_key);
+          }
+        has_red = red_digests.read(red_entry);
+      }
+    while (has_udd)
+      {
+        has_udd = udd_digests.read(udd_entry);
+        if (has_udd) result.udd_counter++;
+      }
+    return result;
+  }
+
+} // end of namespace snredbridge
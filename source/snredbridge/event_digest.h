@@ -0,0 +1,160 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/event_digest.h
+///
+/// Canonical per-event digests of the RED/UDD payload and digest files.
+
+#ifndef SNREDBRIDGE_EVENT_DIGEST_H
+#define SNREDBRIDGE_EVENT_DIGEST_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <string>
+#include <utility>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/things.h>
+
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+// This project:
+#include <snredbridge/waveform_roi.h>
+
+namespace snredbridge {
+
+  /// \brief Fast non-cryptographic 64-bit streaming hash
+  class digest_hasher
+  {
+  public:
+
+    /// Hash a block of bytes
+    void update(const void * data_, const std::size_t size_);
+
+    /// Hash a trivially copyable value
+    template <typename T>
+    void add(const T & value_)
+    {
+      update(&value_, sizeof(T));
+    }
+
+    /// Return the hash of everything added so far
+    uint64_t get_digest() const;
+
+  private:
+
+    uint64_t _state_ = 0x9e3779b97f4a7c15ULL; ///< Running state
+    uint64_t _length_ = 0;                    ///< Number of hashed bytes
+
+  };
+
+  /// Return the digest of the payload of a RED event as converted into UDD
+  ///
+  /// The digest covers the run/event IDs, the expected event header (same
+  /// run/event numbers, real data), reference timestamp, origin
+  /// trigger IDs and, for each hit, its geometry ID, timestamps, RTD origins,
+  /// firmware measurements, waveform (if with_waveform_ is set) and GG times.
+  /// Hit IDs and hit order are not covered, since red_bridge sorts the hits
+  /// and renumbers them: the per-hit digests are combined in an order
+  /// independent way. If the waveforms are stored in ROI/delta mode (roi_),
+  /// only the stored window of each waveform is covered.
+  uint64_t digest_red_event(const snfee::data::raw_event_data & red_,
+                            const bool with_waveform_,
+                            const waveform_roi_config * roi_ = nullptr);
+
+  /// Return the digest of the EH and UDD banks of an event record
+  ///
+  /// Equal to digest_red_event for the RED event it was converted from.
+  uint64_t digest_event_record(const datatools::things & event_record_,
+                               const bool with_waveform_);
+
+  /// \brief Digest file entry
+  struct digest_entry
+  {
+    int32_t run_id = -1;   ///< Run ID
+    int32_t event_id = -1; ///< Event ID
+    uint64_t digest = 0;   ///< Payload digest
+  };
+
+  /// \brief Writer of a digest file
+  ///
+  /// A digest file is a binary file in host byte order made of a small
+  /// header (magic, version, flags) followed by fixed size entries in event
+  /// order. The flags tell if the digests cover the waveforms and if the
+  /// event records were read back from a stored file (rather than digested
+  /// in memory before being written, which does not check the file).
+  class digest_file_writer
+  {
+  public:
+
+    /// Constructor: create the digest file
+    digest_file_writer(const std::string & filename_,
+                       const bool with_waveform_,
+                       const bool stored_records_ = false);
+
+    /// Append an entry
+    void write(const digest_entry & entry_);
+
+    /// Flush and close the file
+    void close();
+
+  private:
+
+    std::string _filename_; ///< File name
+    std::ofstream _out_;    ///< Output stream
+
+  };
+
+  /// \brief Reader of a digest file
+  class digest_file_reader
+  {
+  public:
+
+    /// Constructor: open the digest file and read its header
+    explicit digest_file_reader(const std::string & filename_);
+
+    /// Check if the digests cover the waveforms
+    bool is_with_waveform() const;
+
+    /// Check if the event records were read back from a stored file
+    bool is_from_stored_records() const;
+
+    /// Read the next entry. Return false at the end of the file
+    bool read(digest_entry & entry_);
+
+  private:
+
+    std::string _filename_;      ///< File name
+    std::ifstream _in_;          ///< Input stream
+    bool _with_waveform_ = true; ///< The digests cover the waveforms
+    bool _stored_records_ = false; ///< The event records were read back from a stored file
+
+  };
+
+  /// \brief Result of the comparison of a RED and a UDD digest file
+  struct digest_comparison
+  {
+    std::size_t red_counter = 0;       ///< Number of RED digests
+    std::size_t udd_counter = 0;       ///< Number of UDD digests
+    std::size_t equal_counter = 0;     ///< Number of events with equal digests
+    std::size_t different_counter = 0; ///< Number of events with different digests
+    std::size_t missing_counter = 0;   ///< Number of RED events without UDD digest
+    bool udd_from_stored_records = false; ///< The UDD digests were computed from a stored file
+    std::set<std::pair<int32_t, int32_t>> suspicious_events; ///< (run ID, event ID) of the events to deep-compare
+  };
+
+  /// Compare the digest streams of the RED events and of the event records
+  ///
+  /// Both files are expected in event order, as written by red_bridge: they
+  /// are merged on (run ID, event ID) in a single sequential pass.
+  digest_comparison compare_digest_files(const std::string & red_digest_filename_,
+                                         const std::string & udd_digest_filename_,
+                                         const datatools::logger::priority logging_);
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_EVENT_DIGEST_H
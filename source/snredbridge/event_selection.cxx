@@ -0,0 +1,206 @@
+// This project:
+#include <snredbridge/event_selection.h>
+
+// Standard library:
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+// This project:
+#include <snredbridge/channel_table.h>
+#include <snredbridge/red_to_udd_conversion.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    /// Parse a number, the whole text being used
+    template <typename T>
+    bool parse_number(const std::string & text_, T & value_)
+    {
+      if (text_.empty()) return false;
+      char * end = nullptr;
+      const double value = std::strtod(text_.c_str(), &end);
+      if (*end != '\0') return false;
+      if (std::numeric_limits<T>::is_integer) {
+        // Range of the signed integer type: [-2^n, 2^n[, exact in double
+        const double lowest = static_cast<double>(std::numeric_limits<T>::min());
+        if (!(value >= lowest && value < -lowest)) return false;
+      }
+      value_ = static_cast<T>(value);
+      return static_cast<double>(value_) == value;
+    }
+
+    /// Parse "MIN:MAX", where each bound may be omitted
+    template <typename T>
+    bool parse_range(const std::string & text_, T & min_, T & max_)
+    {
+      const std::size_t colon = text_.find(':');
+      if (colon == std::string::npos) return false;
+      const std::string min_text = text_.substr(0, colon);
+      const std::string max_text = text_.substr(colon + 1);
+      if (!min_text.empty() && !parse_number(min_text, min_)) return false;
+      if (!max_text.empty() && !parse_number(max_text, max_)) return false;
+      return min_ <= max_;
+    }
+
+    /// Split a comma separated list
+    std::vector<std::string> split_list(const std::string & text_)
+    {
+      std::vector<std::string> items;
+      std::size_t begin = 0;
+      while (true) {
+        const std::size_t comma = text_.find(',', begin);
+        items.push_back(text_.substr(begin, comma - begin));
+        if (comma == std::string::npos) break;
+        begin = comma + 1;
+      }
+      return items;
+    }
+
+  } // end of anonymous namespace
+
+  void event_selection::add_cut(const std::string & text_)
+  {
+    const std::size_t equal = text_.find('=');
+    DT_THROW_IF(equal == std::string::npos, std::logic_error,
+                "Invalid selection cut '" << text_ << "' (expected NAME=VALUE)!");
+    const std::string name = text_.substr(0, equal);
+    const std::string value = text_.substr(equal + 1);
+    cut c;
+    c.text = text_;
+    bool ok = true;
+    if (name == "calo_hits" || name == "tracker_hits") {
+      c.type = (name == "calo_hits") ? CUT_CALO_HITS : CUT_TRACKER_HITS;
+      ok = parse_range(value, c.min, c.max);
+    }
+    else if (name == "time") {
+      c.type = CUT_TIME;
+      ok = parse_range(value, c.min_time, c.max_time);
+    }
+    else if (name == "trigger_decision") {
+      c.type = CUT_TRIGGER_DECISION;
+      for (const auto & item : split_list(value)) {
+        int32_t decision = 0;
+        ok = ok && parse_number(item, decision);
+        c.values.push_back(decision);
+      }
+    }
+    else if (name == "om" || name == "cell") {
+      c.type = (name == "om") ? CUT_OM : CUT_CELL;
+      const std::size_t nchannels = (c.type == CUT_OM)
+        ? channel_table::calorimeter().size()
+        : channel_table::tracker().size();
+      for (const auto & item : split_list(value)) {
+        int32_t first = 0;
+        int32_t last = 0;
+        const std::size_t dash = item.find('-', 1);
+        if (dash == std::string::npos) {
+          ok = ok && parse_number(item, first);
+          last = first;
+        } else {
+          ok = ok && parse_number(item.substr(0, dash), first) && parse_number(item.substr(dash + 1), last);
+        }
+        ok = ok && first >= 0 && first <= last && static_cast<std::size_t>(last) < nchannels;
+        if (!ok) break;
+        if (c.channels.size() <= static_cast<std::size_t>(last)) c.channels.resize(last + 1, false);
+        std::fill(c.channels.begin() + first, c.channels.begin() + last + 1, true);
+      }
+    }
+    else {
+      DT_THROW(std::logic_error, "Unknown selection cut '" << name
+               << "' (calo_hits, tracker_hits, trigger_decision, om, cell or time)!");
+    }
+    DT_THROW_IF(!ok, std::logic_error, "Invalid value of selection cut '" << text_ << "'!");
+    _cuts_.push_back(c);
+  }
+
+  bool event_selection::is_active() const
+  {
+    return !_cuts_.empty();
+  }
+
+  bool event_selection::_is_passed_(const cut & cut_, const snfee::data::raw_event_data & red_)
+  {
+    switch (cut_.type) {
+    case CUT_CALO_HITS: {
+      const int64_t nhits = static_cast<int64_t>(red_.get_calo_hits().size());
+      return nhits >= cut_.min && nhits <= cut_.max;
+    }
+    case CUT_TRACKER_HITS: {
+      const int64_t nhits = static_cast<int64_t>(red_.get_tracker_hits().size());
+      return nhits >= cut_.min && nhits <= cut_.max;
+    }
+    case CUT_TRIGGER_DECISION:
+      for (const auto & red_trigger_hit : red_.get_trigger_records()) {
+        const int32_t decision = red_trigger_hit.get_trigger_decision();
+        if (std::find(cut_.values.begin(), cut_.values.end(), decision) != cut_.values.end()) return true;
+      }
+      return false;
+    case CUT_OM: {
+      const channel_table & om_table = channel_table::calorimeter();
+      for (const auto & red_calo_hit : red_.get_calo_hits()) {
+        const int om = om_table.get_channel(red_calo_hit.get_geom_id());
+        if (om >= 0 && static_cast<std::size_t>(om) < cut_.channels.size() && cut_.channels[om]) return true;
+      }
+      return false;
+    }
+    case CUT_CELL: {
+      const channel_table & cell_table = channel_table::tracker();
+      for (const auto & red_tracker_hit : red_.get_tracker_hits()) {
+        const int cell = cell_table.get_channel(red_tracker_hit.get_geom_id());
+        if (cell >= 0 && static_cast<std::size_t>(cell) < cut_.channels.size() && cut_.channels[cell]) return true;
+      }
+      return false;
+    }
+    case CUT_TIME: {
+      const double reference_time = reference_time_in_seconds(red_.get_reference_time());
+      return reference_time >= cut_.min_time && reference_time <= cut_.max_time;
+    }
+    }
+    return false;
+  }
+
+  int event_selection::find_rejecting_cut(const snfee::data::raw_event_data & red_) const
+  {
+    for (std::size_t icut = 0; icut < _cuts_.size(); icut++) {
+      if (!_is_passed_(_cuts_[icut], red_)) return static_cast<int>(icut);
+    }
+    return -1;
+  }
+
+  void event_selection::count(const int rejecting_cut_)
+  {
+    if (rejecting_cut_ < 0) {
+      _naccepted_++;
+      return;
+    }
+    _nrejected_++;
+    _cuts_.at(rejecting_cut_).nrejected++;
+  }
+
+  std::size_t event_selection::get_number_of_accepted() const
+  {
+    return _naccepted_;
+  }
+
+  std::size_t event_selection::get_number_of_rejected() const
+  {
+    return _nrejected_;
+  }
+
+  void event_selection::print(std::ostream & out_) const
+  {
+    out_ << "- Accepted events     : " << _naccepted_ << std::endl;
+    out_ << "- Rejected events     : " << _nrejected_ << std::endl;
+    for (const auto & c : _cuts_) {
+      out_ << "  - by " << c.text << " : " << c.nrejected << std::endl;
+    }
+  }
+
+} // end of namespace snredbridge
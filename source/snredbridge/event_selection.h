@@ -0,0 +1,102 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/event_selection.h
+///
+/// Selection of the RED events to convert, from cuts on their hit counts,
+/// trigger decisions, hit channels and reference time.
+
+#ifndef SNREDBRIDGE_EVENT_SELECTION_H
+#define SNREDBRIDGE_EVENT_SELECTION_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Third party:
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+namespace snredbridge {
+
+  /// \brief Conjunction of cuts on RED events, applied before their conversion
+  ///
+  /// Each cut is given as "NAME=VALUE":
+  ///  - "calo_hits=MIN:MAX", "tracker_hits=MIN:MAX": number of calorimeter
+  ///    or tracker hits (either bound may be omitted, e.g. "calo_hits=2:");
+  ///  - "trigger_decision=D1,D2...": at least one trigger record has one of
+  ///    these trigger decisions;
+  ///  - "om=LIST", "cell=LIST": at least one calorimeter hit on one of these
+  ///    OM numbers, or tracker hit on one of these GG cell numbers, where
+  ///    LIST is made of numbers and ranges (e.g. "0-259,520") below the
+  ///    number of channels of the channel_table;
+  ///  - "time=MIN:MAX": reference time of the event, in seconds from the
+  ///    run TDC=0 (either bound may be omitted).
+  ///
+  /// The cuts are evaluated in the order they were added and only read the
+  /// RED event. find_rejecting_cut can be called concurrently, the counters
+  /// are only updated by count.
+  class event_selection
+  {
+  public:
+
+    /// Add a cut
+    void add_cut(const std::string & text_);
+
+    /// Check if there is at least one cut
+    bool is_active() const;
+
+    /// Return the rank of the first cut rejecting a RED event, or -1 if it is selected
+    int find_rejecting_cut(const snfee::data::raw_event_data & red_) const;
+
+    /// Count the selection result of an event, as given by find_rejecting_cut
+    void count(const int rejecting_cut_);
+
+    /// Return the number of selected events
+    std::size_t get_number_of_accepted() const;
+
+    /// Return the number of rejected events
+    std::size_t get_number_of_rejected() const;
+
+    /// Print the accept/reject counters, with the number of events rejected by each cut
+    void print(std::ostream & out_) const;
+
+  private:
+
+    /// Type of cut
+    enum cut_type
+    {
+      CUT_CALO_HITS,
+      CUT_TRACKER_HITS,
+      CUT_TRIGGER_DECISION,
+      CUT_OM,
+      CUT_CELL,
+      CUT_TIME
+    };
+
+    /// Cut
+    struct cut
+    {
+      std::string text;                        ///< Cut as given
+      cut_type type = CUT_CALO_HITS;           ///< Type
+      int64_t min = 0;                         ///< Min number of hits
+      int64_t max = INT64_MAX;                 ///< Max number of hits
+      double min_time = -1E300;                ///< Min reference time (s)
+      double max_time = +1E300;                ///< Max reference time (s)
+      std::vector<int32_t> values;             ///< Trigger decisions
+      std::vector<bool> channels;              ///< Selected OM or GG cell numbers
+      std::size_t nrejected = 0;               ///< Number of events rejected by this cut
+    };
+
+    static bool _is_passed_(const cut & cut_, const snfee::data::raw_event_data & red_);
+
+    std::vector<cut> _cuts_;      ///< Cuts
+    std::size_t _naccepted_ = 0;  ///< Number of selected events
+    std::size_t _nrejected_ = 0;  ///< Number of rejected events
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_EVENT_SELECTION_H
@@ -0,0 +1,146 @@
+// This project:
+#include <snredbridge/file_utils.h>
+
+// Standard library:
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+// POSIX:
+#include <glob.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/utils.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    // Rank of the temporary files named by this process
+    std::atomic<unsigned int> temporary_counter{0};
+
+    void expand_pattern(const std::string & pattern_,
+                        std::vector<std::string> & filenames_)
+    {
+      std::string pattern = pattern_;
+      DT_THROW_IF(!datatools::fetch_path_with_env(pattern), std::logic_error,
+                  "Cannot resolve file name '" << pattern_ << "'!");
+      if (pattern.find_first_of("*?[") == std::string::npos) {
+        filenames_.push_back(pattern);
+        return;
+      }
+      glob_t matches;
+      const int status = ::glob(pattern.c_str(), 0, nullptr, &matches);
+      if (status != 0) {
+        ::globfree(&matches);
+        DT_THROW(std::logic_error, "No file matches the pattern '" << pattern_ << "'!");
+      }
+      // glob(3) already sorts the matches
+      for (std::size_t i = 0; i < matches.gl_pathc; i++) {
+        filenames_.push_back(matches.gl_pathv[i]);
+      }
+      ::globfree(&matches);
+    }
+
+  } // end of anonymous namespace
+
+  std::vector<std::string> expand_filenames(const std::vector<std::string> & patterns_)
+  {
+    std::vector<std::string> filenames;
+    for (const auto & pattern : patterns_) {
+      if (pattern.empty()) continue;
+      if (pattern[0] != '@') {
+        expand_pattern(pattern, filenames);
+        continue;
+      }
+      // List file
+      std::string list_filename = pattern.substr(1);
+      DT_THROW_IF(!datatools::fetch_path_with_env(list_filename), std::logic_error,
+                  "Cannot resolve list file name '" << pattern.substr(1) << "'!");
+      std::ifstream list_file(list_filename);
+      DT_THROW_IF(!list_file, std::runtime_error, "Cannot open list file '" << list_filename << "'!");
+      std::string line;
+      while (std::getline(list_file, line)) {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        const std::size_t last = line.find_last_not_of(" \t\r");
+        expand_pattern(line.substr(first, last - first + 1), filenames);
+      }
+    }
+    return filenames;
+  }
+
+  void split_extension(const std::string & filename_,
+                       std::string & stem_,
+                       std::string & extension_)
+  {
+    static const std::vector<std::string> known_extensions = {
+      ".data.gz", ".data.bz2", ".data", ".txt.gz", ".txt.bz2", ".txt",
+      ".xml.gz", ".xml.bz2", ".xml", ".brio"
+    };
+    for (const auto & ext : known_extensions) {
+      if (filename_.size() > ext.size()
+          && filename_.compare(filename_.size() - ext.size(), ext.size(), ext) == 0) {
+        stem_ = filename_.substr(0, filename_.size() - ext.size());
+        extension_ = ext;
+        return;
+      }
+    }
+    const std::size_t slash = filename_.rfind('/');
+    const std::size_t dot = filename_.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+      stem_ = filename_;
+      extension_.clear();
+      return;
+    }
+    stem_ = filename_.substr(0, dot);
+    extension_ = filename_.substr(dot);
+  }
+
+  int64_t file_size(const std::string & filename_)
+  {
+    struct stat st;
+    if (::stat(filename_.c_str(), &st) != 0) return -1;
+    return st.st_size;
+  }
+
+  int64_t file_mtime(const std::string & filename_)
+  {
+    struct stat st;
+    if (::stat(filename_.c_str(), &st) != 0) return -1;
+    return st.st_mtime;
+  }
+
+  uint64_t parse_byte_size(const std::string & text_)
+  {
+    char * end = nullptr;
+    const double value = std::strtod(text_.c_str(), &end);
+    DT_THROW_IF(end == text_.c_str() || value < 0, std::logic_error, "Invalid byte size '" << text_ << "'!");
+    double unit = 1.0;
+    switch (*end) {
+    case '\0': case 'B': break;
+    case 'k': case 'K': unit = 1024.0; end++; break;
+    case 'm': case 'M': unit = 1024.0 * 1024.0; end++; break;
+    case 'g': case 'G': unit = 1024.0 * 1024.0 * 1024.0; end++; break;
+    default:
+      DT_THROW(std::logic_error, "Invalid byte size unit in '" << text_ << "'!");
+    }
+    // Optional "B", or "iB" after a unit ("64MB", "2GiB")
+    const std::string unit_suffix(end);
+    DT_THROW_IF(!unit_suffix.empty() && unit_suffix != "B" && (unit == 1.0 || unit_suffix != "iB"),
+                std::logic_error, "Invalid byte size unit in '" << text_ << "'!");
+    return static_cast<uint64_t>(value * unit);
+  }
+
+  std::string make_temporary_filename(const std::string & filename_)
+  {
+    return filename_ + ".tmp-" + std::to_string(::getpid()) + "-" + std::to_string(temporary_counter++);
+  }
+
+} // end of namespace snredbridge
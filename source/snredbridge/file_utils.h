@@ -0,0 +1,46 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/file_utils.h
+///
+/// File name utilities shared by the SNREDBridge programs.
+
+#ifndef SNREDBRIDGE_FILE_UTILS_H
+#define SNREDBRIDGE_FILE_UTILS_H
+
+// Standard library:
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace snredbridge {
+
+  /// Expand a list of input file names
+  ///
+  /// Environment variables are resolved, shell wildcards are expanded (in
+  /// lexicographic order) and entries starting with '@' are read as text
+  /// files listing one input file name per line. Throws if a pattern does
+  /// not match any file.
+  std::vector<std::string> expand_filenames(const std::vector<std::string> & patterns_);
+
+  /// Split a data file name into its stem and its (possibly multi-part)
+  /// extension, e.g. "run-815_udd.data.gz" into "run-815_udd" and ".data.gz"
+  void split_extension(const std::string & filename_,
+                       std::string & stem_,
+                       std::string & extension_);
+
+  /// Return the size in bytes of a file, or -1 if it cannot be accessed
+  int64_t file_size(const std::string & filename_);
+
+  /// Return the last modification time (UNIX time) of a file, or -1 if it cannot be accessed
+  int64_t file_mtime(const std::string & filename_);
+
+  /// Parse a byte size with an optional k/M/G unit (powers of 1024) and an
+  /// optional "B" (or "iB" after a unit), e.g. "512M", "64MB" or "2GiB"
+  uint64_t parse_byte_size(const std::string & text_);
+
+  /// Return a temporary file name next to a file, unique among the
+  /// processes and threads, e.g. "run-815.data.idx.tmp-4242-0"
+  std::string make_temporary_filename(const std::string & filename_);
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_FILE_UTILS_H
@@ -0,0 +1,270 @@
+// This project:
+#include <snredbridge/gzip_read_ahead.h>
+
+// Standard library:
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+// - POSIX:
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Third party:
+// - zlib:
+#include <zlib.h>
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+// This project:
+#include <snredbridge/file_utils.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    // Rank of the named pipes created by this process
+    std::atomic<unsigned int> pipe_counter{0};
+
+  } // end of anonymous namespace
+
+  /// Ring buffer of decompressed data
+  struct gzip_read_ahead::buffer
+  {
+    std::vector<char> data;    ///< Storage
+    std::size_t size = 0;      ///< Number of used bytes
+    bool end_of_file = false;  ///< Last buffer of a file
+  };
+
+  bool gzip_read_ahead::is_gzip_file(const std::string & filename_)
+  {
+    return filename_.size() > 3 && filename_.compare(filename_.size() - 3, 3, ".gz") == 0;
+  }
+
+  gzip_read_ahead::gzip_read_ahead(const std::vector<std::string> & filenames_,
+                                   const config_type & config_)
+    : _free_(std::max<std::size_t>(config_.nbuffers, 2)),
+      _filled_(std::max<std::size_t>(config_.nbuffers, 2))
+  {
+    std::string pipe_dir = config_.pipe_dir;
+    if (pipe_dir.empty()) {
+      const char * tmpdir = std::getenv("TMPDIR");
+      pipe_dir = (tmpdir != nullptr && tmpdir[0] != '\0') ? tmpdir : "/tmp";
+    }
+    for (const auto & filename : filenames_) {
+      if (!is_gzip_file(filename)) {
+        _filenames_.push_back(filename);
+        continue;
+      }
+      std::string stem;
+      std::string extension;
+      const std::size_t slash = filename.rfind('/');
+      split_extension(slash == std::string::npos ? filename : filename.substr(slash + 1), stem, extension);
+      const std::string pipe = pipe_dir + "/snredbridge-" + std::to_string(::getpid())
+        + "-" + std::to_string(pipe_counter++) + "-" + stem + extension.substr(0, extension.size() - 3);
+      ::unlink(pipe.c_str());
+      if (::mkfifo(pipe.c_str(), 0600) != 0) {
+        const int error = errno;
+        for (const auto & created : _pipes_) ::unlink(created.c_str());
+        DT_THROW(std::runtime_error, "Cannot create named pipe '" << pipe << "': " << std::strerror(error));
+      }
+      _gzip_filenames_.push_back(filename);
+      _pipes_.push_back(pipe);
+      _filenames_.push_back(pipe);
+    }
+    if (_pipes_.empty()) {
+      _closed_ = true;
+      return;
+    }
+    for (std::size_t ibuffer = 0; ibuffer < _free_.get_capacity(); ibuffer++) {
+      std::unique_ptr<buffer> ring_buffer(new buffer);
+      ring_buffer->data.resize(std::max<std::size_t>(config_.buffer_size, 4096));
+      _free_.push(std::move(ring_buffer));
+    }
+    _inflate_thread_ = std::thread(&gzip_read_ahead::_inflate_loop_, this);
+    _feed_thread_ = std::thread(&gzip_read_ahead::_feed_loop_, this);
+  }
+
+  gzip_read_ahead::~gzip_read_ahead()
+  {
+    if (_closed_) return;
+    try {
+      close();
+    }
+    catch (...) {
+      // No exception from a destructor
+    }
+  }
+
+  const std::vector<std::string> & gzip_read_ahead::get_filenames() const
+  {
+    return _filenames_;
+  }
+
+  uint64_t gzip_read_ahead::get_number_of_bytes() const
+  {
+    return _bytes_.load();
+  }
+
+  void gzip_read_ahead::check_errors()
+  {
+    std::lock_guard<std::mutex> lock(_errors_mutex_);
+    if (_error_) std::rethrow_exception(_error_);
+  }
+
+  void gzip_read_ahead::close()
+  {
+    if (_closed_) return;
+    _closed_ = true;
+    _stop_ = true;
+    _free_.close();
+    _filled_.close();
+    _inflate_thread_.join();
+    // The feed thread may wait for a reader which is gone (or never came):
+    // open and close the pipes until it is done
+    while (!_feed_done_) {
+      for (const auto & pipe : _pipes_) {
+        const int fd = ::open(pipe.c_str(), O_RDONLY | O_NONBLOCK);
+        if (fd >= 0) ::close(fd);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    _feed_thread_.join();
+    for (const auto & pipe : _pipes_) ::unlink(pipe.c_str());
+    check_errors();
+  }
+
+  void gzip_read_ahead::_set_error_()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_errors_mutex_);
+      if (!_error_) _error_ = std::current_exception();
+    }
+    _free_.close();
+    _filled_.close();
+  }
+
+  void gzip_read_ahead::_inflate_loop_()
+  {
+    try {
+      std::vector<unsigned char> input(256 * 1024);
+      std::unique_ptr<buffer> output;
+      for (const auto & filename : _gzip_filenames_) {
+        std::FILE * file = std::fopen(filename.c_str(), "rb");
+        DT_THROW_IF(file == nullptr, std::runtime_error, "Cannot open gzip file '" << filename << "'!");
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.next_in = Z_NULL;
+        strm.avail_in = 0;
+        // Gzip wrapper only (16), 32 kB window (15)
+        if (inflateInit2(&strm, 16 + 15) != Z_OK) {
+          std::fclose(file);
+          DT_THROW(std::runtime_error, "Cannot initialize inflate!");
+        }
+        bool in_member = false;
+        bool end_of_input = false;
+        bool failed = false;
+        while (!_stop_) {
+          if (!output) {
+            if (!_free_.pop(output)) break;
+            output->size = 0;
+            output->end_of_file = false;
+          }
+          if (strm.avail_in == 0 && !end_of_input) {
+            const std::size_t n = std::fread(input.data(), 1, input.size(), file);
+            if (n == 0) {
+              end_of_input = true;
+              failed = std::ferror(file);
+            }
+            strm.next_in = input.data();
+            strm.avail_in = static_cast<uInt>(n);
+          }
+          if (end_of_input && (!in_member || failed)) {
+            output->end_of_file = true;
+            break;
+          }
+          strm.next_out = reinterpret_cast<Bytef *>(output->data.data() + output->size);
+          strm.avail_out = static_cast<uInt>(output->data.size() - output->size);
+          in_member = true;
+          const int status = inflate(&strm, Z_NO_FLUSH);
+          output->size = output->data.size() - strm.avail_out;
+          if (status == Z_STREAM_END) {
+            // Next member, if any
+            in_member = false;
+            inflateReset(&strm);
+          } else if ((status == Z_BUF_ERROR && end_of_input) || (status != Z_OK && status != Z_BUF_ERROR)) {
+            // Truncated last member or corrupted data
+            failed = true;
+            break;
+          }
+          if (output->size == output->data.size()) {
+            if (!_filled_.push(std::move(output))) break;
+          }
+        }
+        inflateEnd(&strm);
+        std::fclose(file);
+        DT_THROW_IF(failed, std::runtime_error, "Corrupted or truncated gzip file '" << filename << "'!");
+        if (!output || !output->end_of_file) break;
+        if (!_filled_.push(std::move(output))) break;
+      }
+    }
+    catch (...) {
+      _set_error_();
+    }
+  }
+
+  void gzip_read_ahead::_feed_loop_()
+  {
+    // A reader closing its pipe early must not kill the process: the
+    // write then fails with EPIPE
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+    try {
+      std::unique_ptr<buffer> input;
+      for (const auto & pipe : _pipes_) {
+        // Blocks until the reader opens the pipe
+        int fd = -1;
+        do {
+          fd = ::open(pipe.c_str(), O_WRONLY);
+        } while (fd < 0 && errno == EINTR);
+        DT_THROW_IF(fd < 0, std::runtime_error, "Cannot open named pipe '" << pipe << "': " << std::strerror(errno));
+        // After an error or a stop request, the remaining pipes are only
+        // opened and closed so that their reader sees an empty file
+        bool reader_gone = false;
+        while (!_stop_ && _filled_.pop(input)) {
+          std::size_t offset = 0;
+          while (!reader_gone && offset < input->size) {
+            const ssize_t n = ::write(fd, input->data.data() + offset, input->size - offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+              // The reader stopped before the end of the file: skip the rest of it
+              reader_gone = true;
+              break;
+            }
+            offset += static_cast<std::size_t>(n);
+            _bytes_ += static_cast<uint64_t>(n);
+          }
+          const bool end_of_file = input->end_of_file;
+          _free_.push(std::move(input));
+          if (end_of_file) break;
+        }
+        ::close(fd);
+      }
+    }
+    catch (...) {
+      _set_error_();
+    }
+    _feed_done_ = true;
+  }
+
+} // end of namespace snredbridge
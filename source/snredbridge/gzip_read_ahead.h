@@ -0,0 +1,102 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/gzip_read_ahead.h
+///
+/// Decompression of gzipped input files ahead of their reader, on
+/// dedicated threads.
+
+#ifndef SNREDBRIDGE_GZIP_READ_AHEAD_H
+#define SNREDBRIDGE_GZIP_READ_AHEAD_H
+
+// Standard library:
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// This project:
+#include <snredbridge/bounded_queue.h>
+
+namespace snredbridge {
+
+  /// \brief Decompress gzipped input files into a ring of buffers, ahead of their reader
+  ///
+  /// Each gzipped file of the list is replaced by a named pipe with the
+  /// extension of the uncompressed format (e.g. ".data.gz" by ".data"), so
+  /// that SNFEE/Bayeux readers deserialize the plain stream. An inflate
+  /// thread decompresses the files in order (multi-member gzip files are
+  /// supported) into a fixed ring of buffers, and a feed thread writes the
+  /// buffers to the pipes as the reader consumes them. The decompression
+  /// thus runs concurrently with the deserialization, up to the size of
+  /// the ring ahead of it. The files which are not gzipped are read
+  /// directly.
+  ///
+  /// The reader must open the files in the list order. It must be closed
+  /// (or destroyed) before this object.
+  class gzip_read_ahead
+  {
+  public:
+
+    /// Configuration
+    struct config_type
+    {
+      std::size_t buffer_size = 1024 * 1024; ///< Size of the ring buffers
+      std::size_t nbuffers = 16;             ///< Number of ring buffers
+      std::string pipe_dir;                  ///< Directory of the named pipes (empty: $TMPDIR or /tmp)
+    };
+
+    /// Constructor: create the named pipes and start the threads
+    gzip_read_ahead(const std::vector<std::string> & filenames_,
+                    const config_type & config_);
+
+    /// Destructor: stop the threads and remove the named pipes
+    ~gzip_read_ahead();
+
+    /// Return the file names to open instead of the original ones
+    const std::vector<std::string> & get_filenames() const;
+
+    /// Rethrow the first error of the decompression threads, if any
+    void check_errors();
+
+    /// Stop the threads, remove the named pipes and rethrow errors
+    void close();
+
+    /// Return the number of decompressed bytes fed to the reader
+    uint64_t get_number_of_bytes() const;
+
+    /// Check if a file name has a gzip extension
+    static bool is_gzip_file(const std::string & filename_);
+
+  private:
+
+    struct buffer;
+
+    void _inflate_loop_();
+
+    void _feed_loop_();
+
+    void _set_error_();
+
+    std::vector<std::string> _filenames_;             ///< File names to open
+    std::vector<std::string> _gzip_filenames_;        ///< Gzipped input files, in order
+    std::vector<std::string> _pipes_;                 ///< Named pipes of the gzipped files
+    bounded_queue<std::unique_ptr<buffer>> _free_;    ///< Empty buffers of the ring
+    bounded_queue<std::unique_ptr<buffer>> _filled_;  ///< Decompressed buffers, in order
+    std::atomic<bool> _stop_{false};                  ///< Stop request
+    std::atomic<bool> _feed_done_{false};             ///< The feed thread is done
+    std::atomic<uint64_t> _bytes_{0};                 ///< Number of bytes fed to the pipes
+    std::thread _inflate_thread_;                     ///< Decompression thread
+    std::thread _feed_thread_;                        ///< Pipe feed thread
+    std::mutex _errors_mutex_;                        ///< Protect the error
+    std::exception_ptr _error_;                       ///< First error of a thread
+    bool _closed_ = false;                            ///< The threads are stopped
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_GZIP_READ_AHEAD_H
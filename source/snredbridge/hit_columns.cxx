@@ -0,0 +1,473 @@
+// This project:
+#include <snredbridge/hit_columns.h>
+
+// Standard library:
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// - POSIX:
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Third party:
+// - Falaise:
+#include <falaise/snemo/datamodels/unified_digitized_data.h>
+
+// This project:
+#include <snredbridge/channel_table.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    const char column_file_magic[8] = {'S', 'N', 'R', 'B', 'C', 'O', 'L', 'S'};
+    const char column_file_end_magic[8] = {'S', 'N', 'R', 'B', 'C', 'E', 'N', 'D'};
+    const uint32_t column_file_version = 1;
+    const std::size_t name_size = 32;
+
+    // Sizes of the fixed parts of the layout
+    const std::size_t header_size = 8 + 4 + 4 + name_size;
+    const std::size_t column_entry_size = name_size + 4 + 4;
+    const std::size_t chunk_entry_size = 8 + 8 + 4 * 4;
+    const std::size_t trailer_size = 8 + 8 + 8;
+
+    // Flags of the chunk directory entries
+    const int32_t chunk_flag_unsorted = 0x1;
+
+    uint64_t padded_size(const uint64_t size_)
+    {
+      return (size_ + 7) & ~uint64_t(7);
+    }
+
+    template <typename T>
+    T read_value(const char * data_)
+    {
+      T value;
+      std::memcpy(&value, data_, sizeof(T));
+      return value;
+    }
+
+    std::string read_name(const char * data_)
+    {
+      return std::string(data_, strnlen(data_, name_size));
+    }
+
+    // Columns of the calorimeter hit table
+    enum calo_column
+    {
+      CALO_EVENT_ID,
+      CALO_OM_NUM,
+      CALO_TIMESTAMP,
+      CALO_FLAGS,
+      CALO_FWMEAS_BASELINE,
+      CALO_FWMEAS_PEAK_AMPLITUDE,
+      CALO_FWMEAS_PEAK_CELL,
+      CALO_FWMEAS_CHARGE,
+      CALO_FWMEAS_RISING_CELL,
+      CALO_FWMEAS_FALLING_CELL
+    };
+
+    const std::vector<column_descriptor> & calo_columns()
+    {
+      static const std::vector<column_descriptor> columns = {
+        {"event_id", COLUMN_INT32},
+        {"om_num", COLUMN_INT32},
+        {"timestamp", COLUMN_INT64},
+        {"flags", COLUMN_UINT8},
+        {"fwmeas_baseline", COLUMN_INT16},
+        {"fwmeas_peak_amplitude", COLUMN_INT16},
+        {"fwmeas_peak_cell", COLUMN_INT16},
+        {"fwmeas_charge", COLUMN_INT32},
+        {"fwmeas_rising_cell", COLUMN_INT32},
+        {"fwmeas_falling_cell", COLUMN_INT32}
+      };
+      return columns;
+    }
+
+    // Columns of the tracker GG times table
+    enum tracker_column
+    {
+      TRACKER_EVENT_ID,
+      TRACKER_GG_NUM,
+      TRACKER_ANODE_R0,
+      TRACKER_BOTTOM_CATHODE = TRACKER_ANODE_R0 + 5,
+      TRACKER_TOP_CATHODE
+    };
+
+    const std::vector<column_descriptor> & tracker_columns()
+    {
+      static const std::vector<column_descriptor> columns = {
+        {"event_id", COLUMN_INT32},
+        {"gg_num", COLUMN_INT32},
+        {"anode_r0", COLUMN_INT64},
+        {"anode_r1", COLUMN_INT64},
+        {"anode_r2", COLUMN_INT64},
+        {"anode_r3", COLUMN_INT64},
+        {"anode_r4", COLUMN_INT64},
+        {"bottom_cathode", COLUMN_INT64},
+        {"top_cathode", COLUMN_INT64}
+      };
+      return columns;
+    }
+
+    const decltype(snemo::datamodel::tracker_digitized_hit::ANODE_R0) anode_indexes[5] = {
+      snemo::datamodel::tracker_digitized_hit::ANODE_R0,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R1,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R2,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R3,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R4
+    };
+
+  } // end of anonymous namespace
+
+  std::size_t column_element_size(const column_type type_)
+  {
+    switch (type_) {
+    case COLUMN_INT8: return 1;
+    case COLUMN_UINT8: return 1;
+    case COLUMN_INT16: return 2;
+    case COLUMN_INT32: return 4;
+    case COLUMN_INT64: return 8;
+    }
+    DT_THROW(std::logic_error, "Unknown column type " << static_cast<uint32_t>(type_) << "!");
+  }
+
+  // Column file writer
+
+  column_file_writer::column_file_writer(const std::string & filename_,
+                                         const std::string & table_,
+                                         const std::vector<column_descriptor> & columns_,
+                                         const std::size_t chunk_rows_)
+    : _filename_(filename_),
+      _columns_(columns_),
+      _chunk_rows_(std::max<std::size_t>(chunk_rows_, 1)),
+      _buffers_(columns_.size())
+  {
+    DT_THROW_IF(table_.size() >= name_size, std::logic_error, "Table name '" << table_ << "' is too long!");
+    for (const auto & column : _columns_) {
+      DT_THROW_IF(column.name.size() >= name_size, std::logic_error, "Column name '" << column.name << "' is too long!");
+      _element_sizes_.push_back(column_element_size(column.type));
+    }
+    _file_ = std::fopen(_filename_.c_str(), "wb");
+    DT_THROW_IF(_file_ == nullptr, std::runtime_error, "Cannot create column file '" << _filename_ << "'!");
+    char name[name_size];
+    _write_(column_file_magic, sizeof(column_file_magic));
+    _write_(&column_file_version, sizeof(column_file_version));
+    const uint32_t ncolumns = static_cast<uint32_t>(_columns_.size());
+    _write_(&ncolumns, sizeof(ncolumns));
+    std::memset(name, 0, sizeof(name));
+    table_.copy(name, name_size - 1);
+    _write_(name, sizeof(name));
+    for (std::size_t icolumn = 0; icolumn < _columns_.size(); icolumn++) {
+      std::memset(name, 0, sizeof(name));
+      _columns_[icolumn].name.copy(name, name_size - 1);
+      _write_(name, sizeof(name));
+      const uint32_t type = _columns_[icolumn].type;
+      const uint32_t element_size = static_cast<uint32_t>(_element_sizes_[icolumn]);
+      _write_(&type, sizeof(type));
+      _write_(&element_size, sizeof(element_size));
+    }
+    _pad_();
+  }
+
+  column_file_writer::~column_file_writer()
+  {
+    if (_closed_) return;
+    try {
+      close();
+    }
+    catch (...) {
+      // No exception from a destructor
+    }
+  }
+
+  void column_file_writer::begin_event(const int32_t run_id_, const int32_t event_id_)
+  {
+    if (_has_events_ && (run_id_ != _current_.run_id || _current_.nrows >= _chunk_rows_)) {
+      _flush_chunk_();
+    }
+    if (!_has_events_) {
+      _has_events_ = true;
+      _current_.run_id = run_id_;
+      _current_.first_event_id = event_id_;
+      _current_.last_event_id = event_id_;
+    }
+    _current_.first_event_id = std::min(_current_.first_event_id, event_id_);
+    _current_.last_event_id = std::max(_current_.last_event_id, event_id_);
+    // Lookups by binary search need the events in (run ID, event ID) order
+    if (_has_previous_ && std::make_pair(run_id_, event_id_) < std::make_pair(_previous_run_id_, _previous_event_id_)) {
+      _current_.sorted = false;
+    }
+    _has_previous_ = true;
+    _previous_run_id_ = run_id_;
+    _previous_event_id_ = event_id_;
+  }
+
+  void column_file_writer::end_row()
+  {
+    DT_THROW_IF(!_has_events_, std::logic_error, "Row out of any event in '" << _filename_ << "'!");
+    _current_.nrows++;
+    for (std::size_t icolumn = 0; icolumn < _columns_.size(); icolumn++) {
+      DT_THROW_IF(_buffers_[icolumn].size() != _current_.nrows * _element_sizes_[icolumn], std::logic_error,
+                  "Missing value of column '" << _columns_[icolumn].name << "' in '" << _filename_ << "'!");
+    }
+    _nrows_++;
+  }
+
+  void column_file_writer::close()
+  {
+    if (_closed_) return;
+    _closed_ = true;
+    _flush_chunk_();
+    const uint64_t directory_offset = _position_;
+    for (const auto & chunk : _chunks_) {
+      const int32_t flags = chunk.sorted ? 0 : chunk_flag_unsorted;
+      _write_(&chunk.offset, sizeof(chunk.offset));
+      _write_(&chunk.nrows, sizeof(chunk.nrows));
+      _write_(&chunk.run_id, sizeof(chunk.run_id));
+      _write_(&chunk.first_event_id, sizeof(chunk.first_event_id));
+      _write_(&chunk.last_event_id, sizeof(chunk.last_event_id));
+      _write_(&flags, sizeof(flags));
+    }
+    const uint64_t nchunks = _chunks_.size();
+    _write_(&nchunks, sizeof(nchunks));
+    _write_(&directory_offset, sizeof(directory_offset));
+    _write_(column_file_end_magic, sizeof(column_file_end_magic));
+    const bool failed = (std::fclose(_file_) != 0);
+    _file_ = nullptr;
+    DT_THROW_IF(failed, std::runtime_error, "Failed to write column file '" << _filename_ << "'!");
+  }
+
+  uint64_t column_file_writer::get_number_of_rows() const
+  {
+    return _nrows_;
+  }
+
+  const std::string & column_file_writer::get_filename() const
+  {
+    return _filename_;
+  }
+
+  void column_file_writer::_flush_chunk_()
+  {
+    if (!_has_events_) return;
+    _current_.offset = _position_;
+    for (auto & buffer : _buffers_) {
+      if (!buffer.empty()) _write_(buffer.data(), buffer.size());
+      _pad_();
+      buffer.clear();
+    }
+    _chunks_.push_back(_current_);
+    _current_ = column_chunk();
+    _has_events_ = false;
+  }
+
+  void column_file_writer::_write_(const void * data_, const std::size_t size_)
+  {
+    DT_THROW_IF(std::fwrite(data_, 1, size_, _file_) != size_, std::runtime_error,
+                "Failed to write column file '" << _filename_ << "'!");
+    _position_ += size_;
+  }
+
+  void column_file_writer::_pad_()
+  {
+    static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    const std::size_t npad = static_cast<std::size_t>(padded_size(_position_) - _position_);
+    if (npad > 0) _write_(zeros, npad);
+  }
+
+  // Column file reader
+
+  column_file_reader::column_file_reader(const std::string & filename_)
+    : _filename_(filename_)
+  {
+    const int fd = ::open(_filename_.c_str(), O_RDONLY);
+    DT_THROW_IF(fd < 0, std::runtime_error, "Cannot open column file '" << _filename_ << "': " << std::strerror(errno));
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(header_size + trailer_size)) {
+      ::close(fd);
+      DT_THROW(std::runtime_error, "Column file '" << _filename_ << "' is too short!");
+    }
+    _size_ = static_cast<std::size_t>(file_stat.st_size);
+    void * data = ::mmap(nullptr, _size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    DT_THROW_IF(data == MAP_FAILED, std::runtime_error, "Cannot map column file '" << _filename_ << "': " << std::strerror(errno));
+    _data_ = static_cast<const char *>(data);
+
+    try {
+      // Header
+      DT_THROW_IF(std::memcmp(_data_, column_file_magic, sizeof(column_file_magic)) != 0
+                  || read_value<uint32_t>(_data_ + 8) != column_file_version,
+                  std::runtime_error, "'" << _filename_ << "' is not a column file (version " << column_file_version << ")!");
+      const uint32_t ncolumns = read_value<uint32_t>(_data_ + 12);
+      _table_ = read_name(_data_ + 16);
+      DT_THROW_IF(header_size + ncolumns * column_entry_size + trailer_size > _size_, std::runtime_error,
+                  "Column file '" << _filename_ << "' is truncated!");
+      for (uint32_t icolumn = 0; icolumn < ncolumns; icolumn++) {
+        const char * entry = _data_ + header_size + icolumn * column_entry_size;
+        column_descriptor column;
+        column.name = read_name(entry);
+        column.type = static_cast<column_type>(read_value<uint32_t>(entry + name_size));
+        DT_THROW_IF(column_element_size(column.type) != read_value<uint32_t>(entry + name_size + 4), std::runtime_error,
+                    "Bad element size of column '" << column.name << "' in '" << _filename_ << "'!");
+        _columns_.push_back(column);
+      }
+
+      // Trailer and chunk directory
+      const char * trailer = _data_ + _size_ - trailer_size;
+      DT_THROW_IF(std::memcmp(trailer + 16, column_file_end_magic, sizeof(column_file_end_magic)) != 0,
+                  std::runtime_error, "Column file '" << _filename_ << "' is truncated (no trailer)!");
+      const uint64_t nchunks = read_value<uint64_t>(trailer);
+      const uint64_t directory_offset = read_value<uint64_t>(trailer + 8);
+      DT_THROW_IF(directory_offset + nchunks * chunk_entry_size + trailer_size != _size_, std::runtime_error,
+                  "Bad chunk directory in column file '" << _filename_ << "'!");
+      for (uint64_t ichunk = 0; ichunk < nchunks; ichunk++) {
+        const char * entry = _data_ + directory_offset + ichunk * chunk_entry_size;
+        column_chunk chunk;
+        chunk.offset = read_value<uint64_t>(entry);
+        chunk.nrows = read_value<uint64_t>(entry + 8);
+        chunk.run_id = read_value<int32_t>(entry + 16);
+        chunk.first_event_id = read_value<int32_t>(entry + 20);
+        chunk.last_event_id = read_value<int32_t>(entry + 24);
+        chunk.sorted = (read_value<int32_t>(entry + 28) & chunk_flag_unsorted) == 0;
+        if (!chunk.sorted) _sorted_ = false;
+        uint64_t chunk_size = 0;
+        for (const auto & column : _columns_) chunk_size += padded_size(chunk.nrows * column_element_size(column.type));
+        DT_THROW_IF(chunk.offset + chunk_size > directory_offset, std::runtime_error,
+                    "Chunk #" << ichunk << " of column file '" << _filename_ << "' is out of the data!");
+        _chunks_.push_back(chunk);
+      }
+    }
+    catch (...) {
+      ::munmap(const_cast<char *>(_data_), _size_);
+      throw;
+    }
+  }
+
+  column_file_reader::~column_file_reader()
+  {
+    ::munmap(const_cast<char *>(_data_), _size_);
+  }
+
+  const std::string & column_file_reader::get_table_name() const
+  {
+    return _table_;
+  }
+
+  const std::vector<column_descriptor> & column_file_reader::get_columns() const
+  {
+    return _columns_;
+  }
+
+  std::size_t column_file_reader::find_column(const std::string & name_) const
+  {
+    for (std::size_t icolumn = 0; icolumn < _columns_.size(); icolumn++) {
+      if (_columns_[icolumn].name == name_) return icolumn;
+    }
+    DT_THROW(std::logic_error, "No column '" << name_ << "' in '" << _filename_ << "'!");
+  }
+
+  const std::vector<column_chunk> & column_file_reader::get_chunks() const
+  {
+    return _chunks_;
+  }
+
+  std::size_t column_file_reader::find_chunk(const int32_t run_id_, const int32_t event_id_) const
+  {
+    if (!_sorted_) {
+      for (std::size_t ichunk = 0; ichunk < _chunks_.size(); ichunk++) {
+        const column_chunk & chunk = _chunks_[ichunk];
+        if (chunk.run_id == run_id_ && chunk.first_event_id <= event_id_ && event_id_ <= chunk.last_event_id) return ichunk;
+      }
+      return _chunks_.size();
+    }
+    // The chunks are in (run ID, event ID) order
+    const auto found = std::lower_bound(_chunks_.begin(), _chunks_.end(), std::make_pair(run_id_, event_id_),
+                                        [](const column_chunk & chunk_, const std::pair<int32_t, int32_t> & key_) {
+                                          return std::make_pair(chunk_.run_id, chunk_.last_event_id) < key_;
+                                        });
+    return static_cast<std::size_t>(found - _chunks_.begin());
+  }
+
+  const char * column_file_reader::_get_column_address_(const std::size_t chunk_, const std::size_t column_) const
+  {
+    const column_chunk & chunk = _chunks_.at(chunk_);
+    uint64_t offset = chunk.offset;
+    for (std::size_t icolumn = 0; icolumn < column_; icolumn++) {
+      offset += padded_size(chunk.nrows * column_element_size(_columns_[icolumn].type));
+    }
+    return _data_ + offset;
+  }
+
+  // Hit columns writer
+
+  hit_columns_writer::hit_columns_writer(const std::string & prefix_,
+                                         const std::size_t chunk_rows_)
+  {
+    _calo_.reset(new column_file_writer(prefix_ + ".calo.cols", "calo_hits", calo_columns(), chunk_rows_));
+    _tracker_.reset(new column_file_writer(prefix_ + ".tracker.cols", "tracker_gg_times", tracker_columns(), chunk_rows_));
+  }
+
+  hit_columns_writer::~hit_columns_writer()
+  {
+  }
+
+  void hit_columns_writer::write(const datatools::things & event_record_)
+  {
+    const auto & UDD = event_record_.get<snemo::datamodel::unified_digitized_data>("UDD");
+    const int32_t run_id = UDD.get_run_id();
+    const int32_t event_id = UDD.get_event_id();
+
+    column_file_writer & calo = *_calo_;
+    calo.begin_event(run_id, event_id);
+    for (const auto & udd_calo_hdl : UDD.get_calorimeter_hits()) {
+      const auto & udd_calo_hit = udd_calo_hdl.get();
+      uint8_t flags = 0;
+      if (udd_calo_hit.is_low_threshold_only()) flags |= 0x1;
+      if (udd_calo_hit.is_high_threshold()) flags |= 0x2;
+      calo.append<int32_t>(CALO_EVENT_ID, event_id);
+      calo.append<int32_t>(CALO_OM_NUM, channel_table::calorimeter().get_channel(udd_calo_hit.get_geom_id()));
+      calo.append<int64_t>(CALO_TIMESTAMP, udd_calo_hit.get_timestamp());
+      calo.append<uint8_t>(CALO_FLAGS, flags);
+      calo.append<int16_t>(CALO_FWMEAS_BASELINE, udd_calo_hit.get_fwmeas_baseline());
+      calo.append<int16_t>(CALO_FWMEAS_PEAK_AMPLITUDE, udd_calo_hit.get_fwmeas_peak_amplitude());
+      calo.append<int16_t>(CALO_FWMEAS_PEAK_CELL, udd_calo_hit.get_fwmeas_peak_cell());
+      calo.append<int32_t>(CALO_FWMEAS_CHARGE, udd_calo_hit.get_fwmeas_charge());
+      calo.append<int32_t>(CALO_FWMEAS_RISING_CELL, udd_calo_hit.get_fwmeas_rising_cell());
+      calo.append<int32_t>(CALO_FWMEAS_FALLING_CELL, udd_calo_hit.get_fwmeas_falling_cell());
+      calo.end_row();
+    }
+
+    column_file_writer & tracker = *_tracker_;
+    tracker.begin_event(run_id, event_id);
+    for (const auto & udd_tracker_hdl : UDD.get_tracker_hits()) {
+      const auto & udd_tracker_hit = udd_tracker_hdl.get();
+      const int32_t gg_num = channel_table::tracker().get_channel(udd_tracker_hit.get_geom_id());
+      for (const auto & udd_gg_times : udd_tracker_hit.get_times()) {
+        tracker.append<int32_t>(TRACKER_EVENT_ID, event_id);
+        tracker.append<int32_t>(TRACKER_GG_NUM, gg_num);
+        for (std::size_t ianode = 0; ianode < 5; ianode++) {
+          tracker.append<int64_t>(TRACKER_ANODE_R0 + ianode, udd_gg_times.get_anode_time(anode_indexes[ianode]));
+        }
+        tracker.append<int64_t>(TRACKER_BOTTOM_CATHODE, udd_gg_times.get_bottom_cathode_time());
+        tracker.append<int64_t>(TRACKER_TOP_CATHODE, udd_gg_times.get_top_cathode_time());
+        tracker.end_row();
+      }
+    }
+  }
+
+  void hit_columns_writer::close()
+  {
+    _calo_->close();
+    _tracker_->close();
+  }
+
+  std::vector<std::string> hit_columns_writer::get_filenames() const
+  {
+    return {_calo_->get_filename(), _tracker_->get_filename()};
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,233 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/hit_columns.h
+///
+/// Columnar (struct of arrays), chunked and memory-mappable export of the
+/// calorimeter hits and tracker GG times of the UDD banks.
+
+#ifndef SNREDBRIDGE_HIT_COLUMNS_H
+#define SNREDBRIDGE_HIT_COLUMNS_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/things.h>
+
+namespace snredbridge {
+
+  /// Type of the elements of a column
+  enum column_type : uint32_t
+  {
+    COLUMN_INT8  = 1,
+    COLUMN_INT16 = 2,
+    COLUMN_INT32 = 3,
+    COLUMN_INT64 = 4,
+    COLUMN_UINT8 = 5
+  };
+
+  /// Return the size in bytes of the elements of a column type
+  std::size_t column_element_size(const column_type type_);
+
+  /// \brief Description of a column
+  struct column_descriptor
+  {
+    std::string name;                 ///< Column name (at most 31 characters)
+    column_type type = COLUMN_INT32;  ///< Element type
+  };
+
+  /// \brief Chunk of rows of a column file
+  ///
+  /// A chunk only holds complete events of a single run, and each of its
+  /// columns is a contiguous array. A chunk is "sorted" if its events are
+  /// in increasing (run ID, event ID) order, from the last event of the
+  /// previous chunk on.
+  struct column_chunk
+  {
+    uint64_t offset = 0;          ///< Position of the first column in the file
+    uint64_t nrows = 0;           ///< Number of rows
+    int32_t run_id = -1;          ///< Run ID of the events
+    int32_t first_event_id = -1;  ///< Lowest event ID
+    int32_t last_event_id = -1;   ///< Highest event ID
+    bool sorted = true;           ///< The events are in (run ID, event ID) order
+  };
+
+  /// \brief Writer of a column file
+  ///
+  /// Layout (native little-endian, all arrays aligned on 8 bytes):
+  ///  - header: "SNRBCOLS", version (uint32), number of columns (uint32),
+  ///    table name (char[32]), then per column its name (char[32]), type
+  ///    and element size (uint32 each);
+  ///  - chunks: for each column in turn, its nrows elements;
+  ///  - chunk directory: offset, nrows (uint64 each), run ID, lowest and
+  ///    highest event IDs and flags (int32 each, bit 0: not sorted) per
+  ///    chunk;
+  ///  - trailer: number of chunks, directory offset (uint64 each), "SNRBCEND".
+  ///
+  /// The rows are buffered per column and a chunk is written when an event
+  /// starts with at least chunk_rows rows buffered (or the run changes).
+  class column_file_writer
+  {
+  public:
+
+    /// Constructor: create the file and write its header
+    column_file_writer(const std::string & filename_,
+                       const std::string & table_,
+                       const std::vector<column_descriptor> & columns_,
+                       const std::size_t chunk_rows_ = 65536);
+
+    /// Destructor: close the file if needed
+    ~column_file_writer();
+
+    /// Append a value to a column of the current row
+    template <typename T>
+    void append(const std::size_t column_, const T value_)
+    {
+      DT_THROW_IF(sizeof(T) != _element_sizes_[column_], std::logic_error,
+                  "Bad element size for column '" << _columns_[column_].name << "' of '" << _filename_ << "'!");
+      std::vector<char> & buffer = _buffers_[column_];
+      const char * bytes = reinterpret_cast<const char *>(&value_);
+      buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    /// Start the rows of an event (possibly ending the current chunk)
+    void begin_event(const int32_t run_id_, const int32_t event_id_);
+
+    /// End the current row (all the columns must have been appended)
+    void end_row();
+
+    /// Write the last chunk, the directory and the trailer, and close the file
+    void close();
+
+    /// Return the number of rows written so far
+    uint64_t get_number_of_rows() const;
+
+    /// Return the file name
+    const std::string & get_filename() const;
+
+  private:
+
+    void _flush_chunk_();
+
+    void _write_(const void * data_, const std::size_t size_);
+
+    void _pad_();
+
+    std::string _filename_;                    ///< File name
+    std::vector<column_descriptor> _columns_;  ///< Columns
+    std::vector<std::size_t> _element_sizes_;  ///< Element sizes of the columns
+    std::size_t _chunk_rows_;                  ///< Min number of rows per chunk
+    std::FILE * _file_ = nullptr;              ///< Output file
+    uint64_t _position_ = 0;                   ///< Current position in the file
+    std::vector<std::vector<char>> _buffers_;  ///< Buffered rows, per column
+    column_chunk _current_;                    ///< Chunk being filled
+    bool _has_events_ = false;                 ///< The current chunk has events
+    bool _has_previous_ = false;               ///< An event was started before
+    int32_t _previous_run_id_ = -1;            ///< Run ID of the previous event
+    int32_t _previous_event_id_ = -1;          ///< Event ID of the previous event
+    std::vector<column_chunk> _chunks_;        ///< Written chunks
+    uint64_t _nrows_ = 0;                      ///< Number of rows
+    bool _closed_ = false;                     ///< The file is closed
+
+  };
+
+  /// \brief Read-only memory mapping of a column file
+  class column_file_reader
+  {
+  public:
+
+    /// Constructor: map the file and check its layout
+    explicit column_file_reader(const std::string & filename_);
+
+    /// Destructor: unmap the file
+    ~column_file_reader();
+
+    /// Return the table name
+    const std::string & get_table_name() const;
+
+    /// Return the columns
+    const std::vector<column_descriptor> & get_columns() const;
+
+    /// Return the index of a column, or throw if it does not exist
+    std::size_t find_column(const std::string & name_) const;
+
+    /// Return the chunks
+    const std::vector<column_chunk> & get_chunks() const;
+
+    /// Return the index of the first chunk which may hold an event (or the number of chunks)
+    ///
+    /// Binary search if all the chunks are sorted. Otherwise, linear scan
+    /// on the event ID ranges: the event may also be in a later chunk.
+    std::size_t find_chunk(const int32_t run_id_, const int32_t event_id_) const;
+
+    /// Return the elements of a column in a chunk, in place in the mapped file
+    template <typename T>
+    const T * get_column_data(const std::size_t chunk_, const std::size_t column_) const
+    {
+      DT_THROW_IF(sizeof(T) != column_element_size(_columns_.at(column_).type), std::logic_error,
+                  "Bad element size for column '" << _columns_[column_].name << "' of '" << _filename_ << "'!");
+      return reinterpret_cast<const T *>(_get_column_address_(chunk_, column_));
+    }
+
+  private:
+
+    const char * _get_column_address_(const std::size_t chunk_, const std::size_t column_) const;
+
+    std::string _filename_;                    ///< File name
+    std::string _table_;                       ///< Table name
+    std::vector<column_descriptor> _columns_;  ///< Columns
+    std::vector<column_chunk> _chunks_;        ///< Chunks
+    bool _sorted_ = true;                      ///< All the chunks are sorted
+    const char * _data_ = nullptr;             ///< Mapped file
+    std::size_t _size_ = 0;                    ///< Size of the mapped file
+
+  };
+
+  /// \brief Export the calorimeter hits and tracker GG times of event records as column files
+  ///
+  /// The calorimeter table ("<prefix>.calo.cols") has one row per hit with
+  /// the columns event_id, om_num, timestamp, flags (bit 0: low threshold
+  /// only, bit 1: high threshold), fwmeas_baseline, fwmeas_peak_amplitude,
+  /// fwmeas_peak_cell, fwmeas_charge, fwmeas_rising_cell and
+  /// fwmeas_falling_cell. The tracker table ("<prefix>.tracker.cols") has
+  /// one row per GG times record with the columns event_id, gg_num,
+  /// anode_r0 to anode_r4, bottom_cathode and top_cathode (TDC ticks). The
+  /// rows follow the event order and, within an event, the UDD hit order
+  /// (by OM and GG cell number).
+  class hit_columns_writer
+  {
+  public:
+
+    /// Constructor: create the column files
+    explicit hit_columns_writer(const std::string & prefix_,
+                                const std::size_t chunk_rows_ = 65536);
+
+    /// Destructor
+    ~hit_columns_writer();
+
+    /// Export the hits of the UDD bank of an event record
+    void write(const datatools::things & event_record_);
+
+    /// Close the column files
+    void close();
+
+    /// Return the names of the column files
+    std::vector<std::string> get_filenames() const;
+
+  private:
+
+    std::unique_ptr<column_file_writer> _calo_;     ///< Calorimeter hit table
+    std::unique_ptr<column_file_writer> _tracker_;  ///< Tracker GG times table
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_HIT_COLUMNS_H
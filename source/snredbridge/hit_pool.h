@@ -0,0 +1,100 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/hit_pool.h
+///
+/// Recycling pools for the UDD digitized hits.
+
+#ifndef SNREDBRIDGE_HIT_POOL_H
+#define SNREDBRIDGE_HIT_POOL_H
+
+// Standard library:
+#include <cstddef>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/handle.h>
+
+// - Falaise:
+#include <falaise/snemo/datamodels/calorimeter_digitized_hit.h>
+#include <falaise/snemo/datamodels/tracker_digitized_hit.h>
+
+namespace snredbridge {
+
+  /// \brief Free list of UDD hit handles reused from one event to the next
+  ///
+  /// Not thread-safe: each conversion worker owns its pools. A recycled hit
+  /// keeps its heap buffers (GG times...) and only the members that the
+  /// conversion does not overwrite are reset.
+  template <typename Hit>
+  class hit_pool
+  {
+  public:
+
+    typedef datatools::handle<Hit> handle_type;
+
+    /// Return a recycled hit handle, or a new one if the pool is empty
+    handle_type acquire()
+    {
+      if (_free_.empty()) {
+        _allocated_++;
+        return handle_type(new Hit);
+      }
+      handle_type hit = _free_.back();
+      _free_.pop_back();
+      reset_hit(hit.grab());
+      return hit;
+    }
+
+    /// Move the hits of a collection back to the pool and empty the collection
+    ///
+    /// The collection keeps its capacity. Hits still shared with another
+    /// owner are dropped rather than recycled.
+    void release(std::vector<handle_type> & hits_)
+    {
+      for (auto & hit : hits_) {
+        if (hit.has_data() && hit.unique()) _free_.push_back(hit);
+      }
+      hits_.clear();
+    }
+
+    /// Return the number of hits available for reuse
+    std::size_t get_number_of_free_hits() const
+    {
+      return _free_.size();
+    }
+
+    /// Return the number of hits allocated by this pool since its creation
+    std::size_t get_number_of_allocated_hits() const
+    {
+      return _allocated_;
+    }
+
+  private:
+
+    static void reset_hit(snemo::datamodel::calorimeter_digitized_hit & hit_)
+    {
+      if (!hit_.get_waveform().empty()) hit_.set_waveform(std::vector<int16_t>());
+      hit_.grab_auxiliaries().clear();
+    }
+
+    static void reset_hit(snemo::datamodel::tracker_digitized_hit & hit_)
+    {
+      hit_.grab_times().clear();
+      hit_.grab_auxiliaries().clear();
+    }
+
+    std::vector<handle_type> _free_; ///< Hits available for reuse
+    std::size_t _allocated_ = 0;     ///< Number of hits allocated by this pool
+
+  };
+
+  /// \brief Set of hit pools owned by a conversion worker
+  struct conversion_pools
+  {
+    hit_pool<snemo::datamodel::calorimeter_digitized_hit> calo_hits;  ///< Calorimeter hits
+    hit_pool<snemo::datamodel::tracker_digitized_hit> tracker_hits;   ///< Tracker hits
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_HIT_POOL_H
@@ -0,0 +1,209 @@
+// This project:
+#include <snredbridge/parallel_gzip.h>
+
+// Standard library:
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+// Third party:
+// - zlib:
+#include <zlib.h>
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    // Size of the deflate window, used as dictionary between blocks
+    const std::size_t dictionary_size = 32768;
+
+  } // end of anonymous namespace
+
+  /// Input block and its compressed output
+  struct parallel_gzip_writer::block
+  {
+    std::size_t seq = 0;       ///< Rank of the block
+    bool last = false;         ///< Last block of the stream
+    std::vector<char> input;   ///< Uncompressed data
+    std::vector<char> dictionary; ///< End of the previous block
+    std::vector<char> output;  ///< Raw deflate data
+    uLong crc = 0;             ///< CRC-32 of the input
+  };
+
+  parallel_gzip_writer::parallel_gzip_writer(const std::string & filename_,
+                                             const int level_,
+                                             const std::size_t nthreads_,
+                                             const std::size_t block_size_)
+    : _filename_(filename_),
+      _level_(std::min(std::max(level_, 0), 9)),
+      _block_size_(std::max<std::size_t>(block_size_, dictionary_size)),
+      _todo_(2 * std::max<std::size_t>(nthreads_, 1)),
+      _done_(2 * std::max<std::size_t>(nthreads_, 1))
+  {
+    _file_ = std::fopen(_filename_.c_str(), "wb");
+    DT_THROW_IF(_file_ == nullptr, std::runtime_error, "Cannot create gzip file '" << _filename_ << "'!");
+    // Gzip header: no name, no time stamp, unknown OS
+    const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255};
+    std::fwrite(header, 1, sizeof(header), _file_);
+    for (std::size_t iworker = 0; iworker < std::max<std::size_t>(nthreads_, 1); iworker++) {
+      _workers_.emplace_back(&parallel_gzip_writer::_compress_loop_, this);
+    }
+    _output_thread_ = std::thread(&parallel_gzip_writer::_output_loop_, this);
+    _current_.reset(new block);
+    _current_->input.reserve(_block_size_);
+  }
+
+  parallel_gzip_writer::~parallel_gzip_writer()
+  {
+    if (_closed_) return;
+    try {
+      close();
+    }
+    catch (...) {
+      // No exception from a destructor
+    }
+  }
+
+  void parallel_gzip_writer::write(const char * data_, const std::size_t size_)
+  {
+    DT_THROW_IF(_closed_, std::logic_error, "Gzip file '" << _filename_ << "' is closed!");
+    std::size_t offset = 0;
+    while (offset < size_) {
+      const std::size_t n = std::min(size_ - offset, _block_size_ - _current_->input.size());
+      _current_->input.insert(_current_->input.end(), data_ + offset, data_ + offset + n);
+      offset += n;
+      if (_current_->input.size() == _block_size_) _submit_(false);
+    }
+  }
+
+  void parallel_gzip_writer::close()
+  {
+    if (_closed_) return;
+    _closed_ = true;
+    // The threads are stopped and joined before any error is reported
+    std::exception_ptr submit_error;
+    try {
+      _submit_(true);
+    }
+    catch (...) {
+      submit_error = std::current_exception();
+    }
+    _todo_.close();
+    for (auto & worker : _workers_) worker.join();
+    _done_.close();
+    _output_thread_.join();
+    bool write_failed = (std::ferror(_file_) != 0);
+    if (std::fclose(_file_) != 0) write_failed = true;
+    _file_ = nullptr;
+    _check_errors_();
+    if (submit_error) std::rethrow_exception(submit_error);
+    DT_THROW_IF(write_failed, std::runtime_error, "Failed to write gzip file '" << _filename_ << "'!");
+  }
+
+  void parallel_gzip_writer::_submit_(const bool last_)
+  {
+    _check_errors_();
+    std::unique_ptr<block> full = std::move(_current_);
+    full->seq = _next_seq_++;
+    full->last = last_;
+    full->dictionary.swap(_dictionary_);
+    // Keep the end of this block as dictionary of the next one
+    const std::size_t ndict = std::min(full->input.size(), dictionary_size);
+    _dictionary_.assign(full->input.end() - ndict, full->input.end());
+    if (!last_) {
+      _current_.reset(new block);
+      _current_->input.reserve(_block_size_);
+    }
+    _todo_.push(std::move(full));
+  }
+
+  void parallel_gzip_writer::_compress_loop_()
+  {
+    try {
+      std::unique_ptr<block> job;
+      while (_todo_.pop(job)) {
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        // Raw deflate stream: the gzip wrapper is written by hand
+        DT_THROW_IF(deflateInit2(&strm, _level_, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK,
+                    std::runtime_error, "Cannot initialize deflate!");
+        if (!job->dictionary.empty()) {
+          deflateSetDictionary(&strm, reinterpret_cast<const Bytef *>(job->dictionary.data()),
+                               static_cast<uInt>(job->dictionary.size()));
+        }
+        job->output.resize(deflateBound(&strm, job->input.size()) + 16);
+        strm.next_in = reinterpret_cast<Bytef *>(job->input.data());
+        strm.avail_in = static_cast<uInt>(job->input.size());
+        strm.next_out = reinterpret_cast<Bytef *>(job->output.data());
+        strm.avail_out = static_cast<uInt>(job->output.size());
+        // Byte-aligned end of block so that the blocks can be concatenated
+        const int status = deflate(&strm, job->last ? Z_FINISH : Z_SYNC_FLUSH);
+        const bool ok = job->last ? (status == Z_STREAM_END) : (status == Z_OK && strm.avail_in == 0);
+        job->output.resize(job->output.size() - strm.avail_out);
+        deflateEnd(&strm);
+        DT_THROW_IF(!ok, std::runtime_error, "Deflate failed for gzip file '" << _filename_ << "'!");
+        job->crc = crc32(0L, reinterpret_cast<const Bytef *>(job->input.data()), static_cast<uInt>(job->input.size()));
+        job->dictionary.clear();
+        if (!_done_.push(std::move(job))) break;
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(_errors_mutex_);
+      if (!_error_) _error_ = std::current_exception();
+      _todo_.close();
+      _done_.close();
+    }
+  }
+
+  void parallel_gzip_writer::_output_loop_()
+  {
+    try {
+      std::map<std::size_t, std::unique_ptr<block>> reorder_buffer;
+      std::size_t next_seq = 0;
+      uLong crc = crc32(0L, Z_NULL, 0);
+      uint64_t total_size = 0;
+      std::unique_ptr<block> job;
+      while (_done_.pop(job)) {
+        reorder_buffer[job->seq] = std::move(job);
+        auto found = reorder_buffer.find(next_seq);
+        while (found != reorder_buffer.end()) {
+          const block & ready = *found->second;
+          DT_THROW_IF(std::fwrite(ready.output.data(), 1, ready.output.size(), _file_) != ready.output.size(),
+                      std::runtime_error, "Failed to write gzip file '" << _filename_ << "': " << std::strerror(errno));
+          crc = crc32_combine(crc, ready.crc, static_cast<z_off_t>(ready.input.size()));
+          total_size += ready.input.size();
+          if (ready.last) {
+            // Gzip trailer: CRC-32 and input size modulo 2^32, little endian
+            unsigned char trailer[8];
+            for (int i = 0; i < 4; i++) {
+              trailer[i] = static_cast<unsigned char>((crc >> (8 * i)) & 0xff);
+              trailer[4 + i] = static_cast<unsigned char>((total_size >> (8 * i)) & 0xff);
+            }
+            DT_THROW_IF(std::fwrite(trailer, 1, sizeof(trailer), _file_) != sizeof(trailer),
+                        std::runtime_error, "Failed to write gzip file '" << _filename_ << "': " << std::strerror(errno));
+          }
+          reorder_buffer.erase(found);
+          found = reorder_buffer.find(++next_seq);
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(_errors_mutex_);
+      if (!_error_) _error_ = std::current_exception();
+      _todo_.close();
+      _done_.close();
+    }
+  }
+
+  void parallel_gzip_writer::_check_errors_()
+  {
+    std::lock_guard<std::mutex> lock(_errors_mutex_);
+    if (_error_) std::rethrow_exception(_error_);
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,91 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/parallel_gzip.h
+///
+/// Block-parallel gzip compression of a byte stream into a standard
+/// (single member) gzip file.
+
+#ifndef SNREDBRIDGE_PARALLEL_GZIP_H
+#define SNREDBRIDGE_PARALLEL_GZIP_H
+
+// Standard library:
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// This project:
+#include <snredbridge/bounded_queue.h>
+
+namespace snredbridge {
+
+  /// \brief Gzip file writer compressing blocks of input in parallel
+  ///
+  /// The input is cut into blocks which are deflated independently by a
+  /// pool of threads, each block being primed with the last 32 kB of the
+  /// previous one as dictionary. The blocks are byte-aligned with a sync
+  /// flush, so that their concatenation (with a single gzip header and a
+  /// trailer holding the combined CRC-32) is one regular deflate stream:
+  /// the output can be read by gunzip, zlib or boost::iostreams. The
+  /// compression ratio is very close to the one of a sequential gzip.
+  class parallel_gzip_writer
+  {
+  public:
+
+    /// Constructor: create the output file
+    ///
+    /// level_ is the zlib compression level (0-9), nthreads_ the number of
+    /// compression threads (at least 1) and block_size_ the size of the
+    /// input blocks.
+    parallel_gzip_writer(const std::string & filename_,
+                         const int level_,
+                         const std::size_t nthreads_,
+                         const std::size_t block_size_ = 128 * 1024);
+
+    /// Destructor: close the file if needed
+    ~parallel_gzip_writer();
+
+    /// Append bytes to the stream
+    void write(const char * data_, const std::size_t size_);
+
+    /// Compress the last block, write the trailer and close the file
+    void close();
+
+  private:
+
+    struct block;
+
+    void _submit_(const bool last_);
+
+    void _compress_loop_();
+
+    void _output_loop_();
+
+    void _check_errors_();
+
+    std::string _filename_;                         ///< Output file name
+    int _level_;                                    ///< Compression level
+    std::size_t _block_size_;                       ///< Size of the input blocks
+    std::FILE * _file_ = nullptr;                   ///< Output file
+    std::unique_ptr<block> _current_;               ///< Block being filled
+    std::vector<char> _dictionary_;                 ///< Last 32 kB of the previous block
+    std::size_t _next_seq_ = 0;                     ///< Rank of the next block
+    bounded_queue<std::unique_ptr<block>> _todo_;   ///< Blocks to compress
+    bounded_queue<std::unique_ptr<block>> _done_;   ///< Compressed blocks
+    std::vector<std::thread> _workers_;             ///< Compression threads
+    std::thread _output_thread_;                    ///< Output thread
+    std::mutex _errors_mutex_;                      ///< Protect the error
+    std::exception_ptr _error_;                     ///< First error of a thread
+    bool _closed_ = false;                          ///< The file is closed
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_PARALLEL_GZIP_H
@@ -0,0 +1,151 @@
+// This project:
+#include <snredbridge/red_generator.h>
+
+// Standard library:
+#include <set>
+#include <type_traits>
+
+// Third party:
+// - SNFEE:
+#include <snfee/data/time.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    // Main wall: 2 sides x 20 columns x 13 rows of optical modules
+    const int number_of_main_wall_oms = 520;
+    // Tracker: 2 sides x 9 layers x 113 rows of cells
+    const int number_of_tracker_cells = 2034;
+
+    const decltype(snfee::data::tracker_digitized_hit::ANODE_R0) anode_indexes[5] = {
+      snfee::data::tracker_digitized_hit::ANODE_R0,
+      snfee::data::tracker_digitized_hit::ANODE_R1,
+      snfee::data::tracker_digitized_hit::ANODE_R2,
+      snfee::data::tracker_digitized_hit::ANODE_R3,
+      snfee::data::tracker_digitized_hit::ANODE_R4
+    };
+
+    // Draw n distinct channel numbers in [0, nchannels_), in increasing order
+    std::set<int> draw_channels(std::mt19937_64 & engine_, std::size_t n_, const int nchannels_)
+    {
+      std::set<int> channels;
+      if (n_ > static_cast<std::size_t>(nchannels_)) n_ = nchannels_;
+      std::uniform_int_distribution<int> channel_dist(0, nchannels_ - 1);
+      while (channels.size() < n_) channels.insert(channel_dist(engine_));
+      return channels;
+    }
+
+    // RTD origin of a hit, whatever the origin type of the hit class
+    template <typename Hit>
+    typename std::decay<decltype(std::declval<Hit>().get_origin())>::type
+    make_origin(const int32_t hit_number_, const int32_t trigger_id_)
+    {
+      return typename std::decay<decltype(std::declval<Hit>().get_origin())>::type(hit_number_, trigger_id_);
+    }
+
+    template <typename GGTimes>
+    typename std::decay<decltype(std::declval<GGTimes>().get_bottom_cathode_origin())>::type
+    make_gg_origin(const int32_t hit_number_, const int32_t trigger_id_)
+    {
+      return typename std::decay<decltype(std::declval<GGTimes>().get_bottom_cathode_origin())>::type(hit_number_, trigger_id_);
+    }
+
+  } // end of anonymous namespace
+
+  red_generator::red_generator(const config_type & config_)
+    : _config_(config_), _engine_(config_.seed)
+  {
+  }
+
+  const red_generator::config_type & red_generator::get_config() const
+  {
+    return _config_;
+  }
+
+  void red_generator::generate(snfee::data::raw_event_data & red_)
+  {
+    typedef snfee::data::tracker_digitized_hit::gg_times gg_times_type;
+    const int32_t event_id = _next_event_id_++;
+    const int32_t trigger_id = event_id;
+    std::exponential_distribution<double> step_dist(1.0 / (_config_.ticks_between_events > 0 ? _config_.ticks_between_events : 1));
+    _reference_ticks_ += 1 + static_cast<int64_t>(step_dist(_engine_));
+
+    red_.grab_calo_hits().clear();
+    red_.grab_tracker_hits().clear();
+    red_.grab_origin_trigger_ids().clear();
+    red_.set_run_id(_config_.run_id);
+    red_.set_event_id(event_id);
+    red_.set_reference_time(snfee::data::timestamp(snfee::data::CLOCK_160MHz, _reference_ticks_));
+    red_.add_origin_trigger_id(trigger_id);
+
+    // Calorimeter hits, in increasing OM number
+    std::poisson_distribution<int> ncalo_dist(_config_.mean_calo_hits > 0 ? _config_.mean_calo_hits : 1.e-9);
+    std::normal_distribution<double> noise_dist(0.0, 2.0);
+    std::uniform_int_distribution<int> amplitude_dist(50, 2000);
+    const std::size_t waveform_length = _config_.waveform_length;
+    int32_t hit_number = 0;
+    for (const int om : draw_channels(_engine_, ncalo_dist(_engine_), number_of_main_wall_oms)) {
+      snfee::data::calo_digitized_hit & calo_hit = red_.add_calo_hit();
+      calo_hit.set_geom_id(geomtools::geom_id(1302, 0, om / 260, (om % 260) / 13, om % 13));
+      calo_hit.set_hit_id(hit_number);
+      calo_hit.set_reference_time(snfee::data::timestamp(snfee::data::CLOCK_160MHz, _reference_ticks_ + (om % 8)));
+      const int16_t baseline = 2048;
+      const int16_t amplitude = static_cast<int16_t>(amplitude_dist(_engine_));
+      const std::size_t peak_cell = waveform_length / 4;
+      std::vector<int16_t> & waveform = calo_hit.grab_waveform();
+      waveform.resize(waveform_length);
+      int32_t charge = 0;
+      for (std::size_t icell = 0; icell < waveform_length; icell++) {
+        // Triangular pulse of 16 cells rising, 48 cells falling
+        double pulse = 0.0;
+        if (icell + 16 > peak_cell && icell <= peak_cell) pulse = amplitude * (1.0 - (peak_cell - icell) / 16.0);
+        else if (icell > peak_cell && icell < peak_cell + 48) pulse = amplitude * (1.0 - (icell - peak_cell) / 48.0);
+        const int16_t sample = static_cast<int16_t>(baseline - pulse + noise_dist(_engine_));
+        waveform[icell] = sample;
+        charge += sample - baseline;
+      }
+      calo_hit.set_low_threshold_only(amplitude < 150);
+      calo_hit.set_high_threshold(amplitude >= 150);
+      calo_hit.set_fcr(static_cast<uint16_t>(event_id % 1024));
+      calo_hit.set_lt_trigger_counter(static_cast<uint16_t>(event_id));
+      calo_hit.set_lt_time_counter(static_cast<uint32_t>(_reference_ticks_));
+      calo_hit.set_fwmeas_baseline(static_cast<int16_t>(baseline * 16));
+      calo_hit.set_fwmeas_peak_amplitude(static_cast<int16_t>(amplitude * 8));
+      calo_hit.set_fwmeas_peak_cell(static_cast<int16_t>(peak_cell));
+      calo_hit.set_fwmeas_charge(charge);
+      calo_hit.set_fwmeas_rising_cell(static_cast<int32_t>((peak_cell > 8 ? peak_cell - 8 : 0) * 256));
+      calo_hit.set_fwmeas_falling_cell(static_cast<int32_t>((peak_cell + 24) * 256));
+      calo_hit.set_origin(make_origin<snfee::data::calo_digitized_hit>(hit_number, trigger_id));
+      hit_number++;
+    }
+
+    // Tracker hits, in increasing cell number
+    std::poisson_distribution<int> ntracker_dist(_config_.mean_tracker_hits > 0 ? _config_.mean_tracker_hits : 1.e-9);
+    std::uniform_int_distribution<int64_t> drift_dist(0, 4000);
+    hit_number = 0;
+    for (const int cell : draw_channels(_engine_, ntracker_dist(_engine_), number_of_tracker_cells)) {
+      snfee::data::tracker_digitized_hit & tracker_hit = red_.add_tracker_hit();
+      tracker_hit.set_geom_id(geomtools::geom_id(1204, 0, cell / 1017, (cell % 1017) / 113, cell % 113));
+      tracker_hit.set_hit_id(hit_number);
+      const int64_t anode_ticks = _reference_ticks_ / 2 + drift_dist(_engine_) / 100;
+      for (std::size_t itime = 0; itime < _config_.gg_times_per_hit; itime++) {
+        gg_times_type & gg_times = tracker_hit.add_times();
+        const int32_t time_hit_number = hit_number * static_cast<int32_t>(_config_.gg_times_per_hit) + static_cast<int32_t>(itime);
+        const auto origin = make_gg_origin<gg_times_type>(time_hit_number, trigger_id);
+        for (std::size_t ianode = 0; ianode < 5; ianode++) {
+          gg_times.set_anode_origin(anode_indexes[ianode], origin);
+          gg_times.set_anode_time(anode_indexes[ianode],
+                                  snfee::data::timestamp(snfee::data::CLOCK_80MHz, anode_ticks + 10 * ianode + itime));
+        }
+        gg_times.set_bottom_cathode_origin(origin);
+        gg_times.set_bottom_cathode_time(snfee::data::timestamp(snfee::data::CLOCK_80MHz, anode_ticks + drift_dist(_engine_)));
+        gg_times.set_top_cathode_origin(origin);
+        gg_times.set_top_cathode_time(snfee::data::timestamp(snfee::data::CLOCK_80MHz, anode_ticks + drift_dist(_engine_)));
+      }
+      hit_number++;
+    }
+    return;
+  }
+
+} // end of namespace snredbridge
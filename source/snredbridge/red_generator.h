@@ -0,0 +1,63 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_generator.h
+///
+/// Generator of synthetic SNFEE RED events, used to benchmark the
+/// conversion and validation kernels without real run data.
+
+#ifndef SNREDBRIDGE_RED_GENERATOR_H
+#define SNREDBRIDGE_RED_GENERATOR_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+// Third party:
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+namespace snredbridge {
+
+  /// \brief Generator of synthetic RED events
+  ///
+  /// Events have Poisson distributed numbers of main wall calorimeter hits
+  /// and tracker hits on distinct channels, sorted and numbered as the
+  /// SNFEE event builder does, with waveforms made of a noisy baseline and
+  /// a negative pulse. The same seed gives the same events.
+  class red_generator
+  {
+  public:
+
+    /// Configuration
+    struct config_type
+    {
+      uint64_t seed = 314159;              ///< Seed of the random engine
+      int32_t run_id = 0;                  ///< Run ID of the events
+      double mean_calo_hits = 4.0;         ///< Mean number of calorimeter hits per event
+      double mean_tracker_hits = 20.0;     ///< Mean number of tracker hits per event
+      std::size_t waveform_length = 1024;  ///< Number of samples per waveform
+      std::size_t gg_times_per_hit = 1;    ///< Number of GG times per tracker hit
+      int64_t ticks_between_events = 16000; ///< Mean reference time step (160 MHz ticks)
+    };
+
+    /// Constructor
+    explicit red_generator(const config_type & config_);
+
+    /// Fill the next event
+    void generate(snfee::data::raw_event_data & red_);
+
+    /// Return the configuration
+    const config_type & get_config() const;
+
+  private:
+
+    config_type _config_;               ///< Configuration
+    std::mt19937_64 _engine_;           ///< Random engine
+    int32_t _next_event_id_ = 0;        ///< Event ID of the next event
+    int64_t _reference_ticks_ = 0;      ///< Reference time of the last event
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_GENERATOR_H
@@ -0,0 +1,279 @@
+// This project:
+#include <snredbridge/red_index.h>
+
+// Standard library:
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/clhep_units.h>
+
+// - SNFEE:
+#include <snfee/io/multifile_data_reader.h>
+#include <snfee/data/raw_event_data.h>
+#include <snfee/data/time.h>
+
+// This project:
+#include <snredbridge/file_utils.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    const char INDEX_MAGIC[8] = {'S', 'N', 'R', 'B', 'R', 'E', 'D', 'I'};
+    const uint32_t INDEX_VERSION = 1;
+
+    template <typename T>
+    void write_pod(std::ostream & out_, const T & value_)
+    {
+      out_.write(reinterpret_cast<const char *>(&value_), sizeof(T));
+    }
+
+    template <typename T>
+    void read_pod(std::istream & in_, T & value_)
+    {
+      in_.read(reinterpret_cast<char *>(&value_), sizeof(T));
+    }
+
+    /// Return the number of bytes from the current position to the end of a stream
+    uint64_t remaining_bytes(std::istream & in_)
+    {
+      const std::streamoff position = in_.tellg();
+      in_.seekg(0, std::ios::end);
+      const std::streamoff end = in_.tellg();
+      in_.seekg(position);
+      return (in_ && end > position) ? static_cast<uint64_t>(end - position) : 0;
+    }
+
+  } // end of anonymous namespace
+
+  std::string red_index::default_filename(const std::string & red_filename_,
+                                          const std::string & index_dir_)
+  {
+    if (index_dir_.empty()) return red_filename_ + ".idx";
+    const std::size_t slash = red_filename_.rfind('/');
+    const std::string basename = (slash == std::string::npos) ? red_filename_ : red_filename_.substr(slash + 1);
+    return index_dir_ + "/" + basename + ".idx";
+  }
+
+  red_index red_index::fetch(const std::string & red_filename_,
+                             const std::string & index_dir_,
+                             datatools::logger::priority logging_)
+  {
+    const std::string index_filename = default_filename(red_filename_, index_dir_);
+    red_index index;
+    if (file_size(index_filename) >= 0) {
+      try {
+        index.load(index_filename);
+        if (index.is_up_to_date(red_filename_)) {
+          DT_LOG_DEBUG(logging_, "Loaded RED index '" << index_filename << "' (" << index.size() << " records)");
+          return index;
+        }
+        DT_LOG_INFORMATION(logging_, "RED index '" << index_filename << "' is out of date");
+      }
+      catch (std::exception & x) {
+        DT_LOG_WARNING(logging_, "Cannot load RED index '" << index_filename << "': " << x.what());
+      }
+    }
+    DT_LOG_INFORMATION(logging_, "Building RED index for '" << red_filename_ << "'...");
+    index.build(red_filename_);
+    try {
+      index.store(index_filename);
+      DT_LOG_INFORMATION(logging_, "Stored RED index '" << index_filename << "' (" << index.size() << " records)");
+    }
+    catch (std::exception & x) {
+      DT_LOG_WARNING(logging_, "Cannot store RED index '" << index_filename << "': " << x.what());
+    }
+    return index;
+  }
+
+  void red_index::build(const std::string & red_filename_)
+  {
+    _entries_.clear();
+    _event_ids_sorted_ = true;
+    _red_file_size_ = file_size(red_filename_);
+    _red_file_mtime_ = file_mtime(red_filename_);
+    DT_THROW_IF(_red_file_size_ < 0, std::runtime_error, "Cannot access RED file '" << red_filename_ << "'!");
+
+    snfee::io::multifile_data_reader::config_type reader_cfg;
+    reader_cfg.filenames.push_back(red_filename_);
+    snfee::io::multifile_data_reader red_source(reader_cfg);
+    snfee::data::raw_event_data red;
+    while (red_source.has_record_tag()) {
+      DT_THROW_IF(!red_source.record_tag_is(snfee::data::raw_event_data::SERIAL_TAG),
+                  std::logic_error, "Unexpected record tag '" << red_source.get_record_tag() << "'!");
+      red_source.load(red);
+      entry e;
+      e.run_id = red.get_run_id();
+      e.event_id = red.get_event_id();
+      e.reference_ticks = red.get_reference_time().get_ticks();
+      e.clock = static_cast<int32_t>(red.get_reference_time().get_clock());
+      if (!_entries_.empty() && e.event_id < _entries_.back().event_id) _event_ids_sorted_ = false;
+      _entries_.push_back(e);
+    }
+    _check_time_order_();
+  }
+
+  void red_index::load(const std::string & index_filename_)
+  {
+    std::ifstream in(index_filename_, std::ios::binary);
+    DT_THROW_IF(!in, std::runtime_error, "Cannot open RED index file '" << index_filename_ << "'!");
+    char magic[sizeof(INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    uint32_t version = 0;
+    read_pod(in, version);
+    DT_THROW_IF(!in || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || version != INDEX_VERSION,
+                std::runtime_error, "'" << index_filename_ << "' is not a RED index file (version " << INDEX_VERSION << ")!");
+    uint64_t nentries = 0;
+    read_pod(in, _red_file_size_);
+    read_pod(in, _red_file_mtime_);
+    read_pod(in, nentries);
+    DT_THROW_IF(!in || nentries > remaining_bytes(in) / sizeof(entry),
+                std::runtime_error, "Truncated RED index file '" << index_filename_ << "'!");
+    _entries_.resize(nentries);
+    if (nentries > 0) in.read(reinterpret_cast<char *>(_entries_.data()), nentries * sizeof(entry));
+    DT_THROW_IF(!in, std::runtime_error, "Truncated RED index file '" << index_filename_ << "'!");
+    _event_ids_sorted_ = std::is_sorted(_entries_.begin(), _entries_.end(),
+                                        [](const entry & e1, const entry & e2) { return e1.event_id < e2.event_id; });
+    _check_time_order_();
+  }
+
+  void red_index::store(const std::string & index_filename_) const
+  {
+    // Private temporary file, so that concurrent jobs building the same
+    // index do not write into each other's file
+    const std::string tmp_filename = make_temporary_filename(index_filename_);
+    {
+      std::ofstream out(tmp_filename, std::ios::binary | std::ios::trunc);
+      DT_THROW_IF(!out, std::runtime_error, "Cannot create RED index file '" << tmp_filename << "'!");
+      out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+      write_pod(out, INDEX_VERSION);
+      write_pod(out, _red_file_size_);
+      write_pod(out, _red_file_mtime_);
+      write_pod(out, static_cast<uint64_t>(_entries_.size()));
+      if (!_entries_.empty()) out.write(reinterpret_cast<const char *>(_entries_.data()), _entries_.size() * sizeof(entry));
+      out.close();
+      if (!out) {
+        std::remove(tmp_filename.c_str());
+        DT_THROW(std::runtime_error, "Cannot write RED index file '" << tmp_filename << "'!");
+      }
+    }
+    // Atomic replacement, so that concurrent jobs never see a partial index
+    if (std::rename(tmp_filename.c_str(), index_filename_.c_str()) != 0) {
+      std::remove(tmp_filename.c_str());
+      DT_THROW(std::runtime_error, "Cannot rename '" << tmp_filename << "' to '" << index_filename_ << "'!");
+    }
+  }
+
+  bool red_index::is_up_to_date(const std::string & red_filename_) const
+  {
+    return _red_file_size_ >= 0
+      && file_size(red_filename_) == _red_file_size_
+      && file_mtime(red_filename_) == _red_file_mtime_;
+  }
+
+  std::size_t red_index::size() const
+  {
+    return _entries_.size();
+  }
+
+  bool red_index::empty() const
+  {
+    return _entries_.empty();
+  }
+
+  const red_index::entry & red_index::get_entry(const std::size_t rank_) const
+  {
+    DT_THROW_IF(rank_ >= _entries_.size(), std::range_error, "Invalid RED index rank " << rank_ << "!");
+    return _entries_[rank_];
+  }
+
+  const std::vector<red_index::entry> & red_index::get_entries() const
+  {
+    return _entries_;
+  }
+
+  std::size_t red_index::lower_bound_event(const int64_t event_id_) const
+  {
+    if (_event_ids_sorted_) {
+      auto found = std::lower_bound(_entries_.begin(), _entries_.end(), event_id_,
+                                    [](const entry & e, int64_t id) { return e.event_id < id; });
+      return found - _entries_.begin();
+    }
+    for (std::size_t rank = 0; rank < _entries_.size(); rank++) {
+      if (_entries_[rank].event_id >= event_id_) return rank;
+    }
+    return _entries_.size();
+  }
+
+  std::size_t red_index::upper_bound_event(const int64_t event_id_) const
+  {
+    if (_event_ids_sorted_) {
+      auto found = std::upper_bound(_entries_.begin(), _entries_.end(), event_id_,
+                                    [](int64_t id, const entry & e) { return id < e.event_id; });
+      return found - _entries_.begin();
+    }
+    for (std::size_t rank = _entries_.size(); rank > 0; rank--) {
+      if (_entries_[rank - 1].event_id <= event_id_) return rank;
+    }
+    return 0;
+  }
+
+  double red_index::get_reference_time(const std::size_t rank_) const
+  {
+    const entry & e = get_entry(rank_);
+    return (e.reference_ticks * snfee::data::clock_period(static_cast<snfee::data::clock_type>(e.clock))) / CLHEP::second;
+  }
+
+  void red_index::_check_time_order_()
+  {
+    _times_sorted_ = true;
+    for (std::size_t rank = 1; rank < _entries_.size(); rank++) {
+      if (get_reference_time(rank) < get_reference_time(rank - 1)) {
+        _times_sorted_ = false;
+        break;
+      }
+    }
+  }
+
+  std::size_t red_index::lower_bound_time(const double time_) const
+  {
+    if (_times_sorted_) {
+      std::size_t lo = 0;
+      std::size_t hi = _entries_.size();
+      while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (get_reference_time(mid) < time_) lo = mid + 1;
+        else hi = mid;
+      }
+      return lo;
+    }
+    for (std::size_t rank = 0; rank < _entries_.size(); rank++) {
+      if (get_reference_time(rank) >= time_) return rank;
+    }
+    return _entries_.size();
+  }
+
+  std::size_t red_index::upper_bound_time(const double time_) const
+  {
+    if (_times_sorted_) {
+      std::size_t lo = 0;
+      std::size_t hi = _entries_.size();
+      while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (get_reference_time(mid) <= time_) lo = mid + 1;
+        else hi = mid;
+      }
+      return lo;
+    }
+    for (std::size_t rank = _entries_.size(); rank > 0; rank--) {
+      if (get_reference_time(rank - 1) <= time_) return rank;
+    }
+    return 0;
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,115 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_index.h
+///
+/// Sidecar index of the records of a RED file.
+
+#ifndef SNREDBRIDGE_RED_INDEX_H
+#define SNREDBRIDGE_RED_INDEX_H
+
+// Standard library:
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+namespace snredbridge {
+
+  /// \brief Index of the RED records of a file, in file order
+  ///
+  /// Each entry gives the run/event ids and the reference time of one
+  /// record. The record rank in the file is the entry rank. RED records are
+  /// stored in a single serialization archive which SNFEE can only read
+  /// sequentially, so the index does not allow to seek inside a file: it is
+  /// used to select the files and the record range to read without
+  /// converting (or even loading) the records outside of it.
+  ///
+  /// The index file is a binary file in host byte order, made of a header
+  /// (magic, version, size and modification time of the indexed RED file,
+  /// number of entries) followed by fixed size entries.
+  class red_index
+  {
+  public:
+
+    /// Index entry
+    struct entry
+    {
+      int32_t run_id = -1;          ///< Run ID
+      int32_t event_id = -1;        ///< Event ID
+      int64_t reference_ticks = 0;  ///< Ticks of the event reference time
+      int32_t clock = 0;            ///< Clock of the event reference time (snfee::data::clock_type)
+      int32_t reserved = 0;         ///< Padding (unused)
+    };
+
+    /// Return the default index file name associated to a RED file
+    ///
+    /// The index is stored next to the RED file, or in index_dir_ if set.
+    static std::string default_filename(const std::string & red_filename_,
+                                        const std::string & index_dir_ = "");
+
+    /// Return the index of a RED file, loading it from the index file if it
+    /// is up to date or building (and storing) it otherwise
+    static red_index fetch(const std::string & red_filename_,
+                           const std::string & index_dir_ = "",
+                           datatools::logger::priority logging_ = datatools::logger::PRIO_WARNING);
+
+    /// Build the index by reading the whole RED file
+    void build(const std::string & red_filename_);
+
+    /// Load the index from an index file
+    void load(const std::string & index_filename_);
+
+    /// Store the index in an index file
+    void store(const std::string & index_filename_) const;
+
+    /// Check if the index matches the current size and modification time of the RED file
+    bool is_up_to_date(const std::string & red_filename_) const;
+
+    /// Return the number of indexed records
+    std::size_t size() const;
+
+    /// Check if the index is empty
+    bool empty() const;
+
+    /// Return the entry of a record
+    const entry & get_entry(const std::size_t rank_) const;
+
+    /// Return all the entries
+    const std::vector<entry> & get_entries() const;
+
+    /// Return the rank of the first record with an event ID greater or
+    /// equal to event_id_, or size() if there is none
+    std::size_t lower_bound_event(const int64_t event_id_) const;
+
+    /// Return the rank of the first record with an event ID greater than
+    /// event_id_, or size() if there is none
+    std::size_t upper_bound_event(const int64_t event_id_) const;
+
+    /// Return the reference time of a record in seconds
+    double get_reference_time(const std::size_t rank_) const;
+
+    /// Return the rank of the first record with a reference time greater
+    /// or equal to time_ (s), or size() if there is none
+    std::size_t lower_bound_time(const double time_) const;
+
+    /// Return the rank after the last record with a reference time lower
+    /// or equal to time_ (s), or 0 if there is none
+    std::size_t upper_bound_time(const double time_) const;
+
+  private:
+
+    void _check_time_order_();
+
+    int64_t _red_file_size_ = -1;   ///< Size of the indexed RED file
+    int64_t _red_file_mtime_ = -1;  ///< Modification time of the indexed RED file
+    std::vector<entry> _entries_;   ///< Entries in file order
+    bool _event_ids_sorted_ = true; ///< Event IDs are in increasing order
+    bool _times_sorted_ = true;     ///< Reference times are in increasing order
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_INDEX_H
@@ -0,0 +1,180 @@
+// This project:
+#include <snredbridge/red_reader.h>
+
+// Standard library:
+#include <algorithm>
+#include <stdexcept>
+
+// This project:
+#include <snredbridge/gzip_read_ahead.h>
+#include <snredbridge/red_index.h>
+#include <snredbridge/red_to_udd_conversion.h>
+
+namespace snredbridge {
+
+  red_reader::config_type red_reader::select_event_range(const std::vector<std::string> & filenames_,
+                                                         const int64_t first_event_,
+                                                         const int64_t last_event_,
+                                                         const std::string & index_dir_,
+                                                         datatools::logger::priority logging_)
+  {
+    return select_records(filenames_, first_event_, last_event_,
+                          -std::numeric_limits<double>::infinity(),
+                          +std::numeric_limits<double>::infinity(),
+                          index_dir_, logging_);
+  }
+
+  red_reader::config_type red_reader::select_records(const std::vector<std::string> & filenames_,
+                                                     const int64_t first_event_,
+                                                     const int64_t last_event_,
+                                                     const double start_time_,
+                                                     const double end_time_,
+                                                     const std::string & index_dir_,
+                                                     datatools::logger::priority logging_)
+  {
+    config_type config;
+    config.first_event = first_event_;
+    config.last_event = last_event_;
+    config.start_time = start_time_;
+    config.end_time = end_time_;
+    const bool has_start = start_time_ > -std::numeric_limits<double>::infinity();
+    const bool has_end = end_time_ < std::numeric_limits<double>::infinity();
+    std::size_t offset = 0;
+    bool previous_known = false;
+    double previous_reference_time = 0;
+    for (const auto & filename : filenames_) {
+      const red_index index = red_index::fetch(filename, index_dir_, logging_);
+      std::size_t lo = (first_event_ >= 0) ? index.lower_bound_event(first_event_) : 0;
+      std::size_t hi = (last_event_ >= 0) ? index.upper_bound_event(last_event_) : index.size();
+      if (has_start) lo = std::max(lo, index.lower_bound_time(start_time_));
+      if (has_end) hi = std::min(hi, index.upper_bound_time(end_time_));
+      if (lo >= hi) {
+        DT_LOG_INFORMATION(logging_, "No selected event in RED file '" << filename << "'");
+        if (config.filenames.empty() && !index.empty()) {
+          previous_known = true;
+          previous_reference_time = index.get_reference_time(index.size() - 1);
+        }
+        continue;
+      }
+      if (config.filenames.empty()) {
+        if (lo > 0) {
+          previous_known = true;
+          previous_reference_time = index.get_reference_time(lo - 1);
+        }
+        config.has_previous_reference_time = previous_known;
+        config.previous_reference_time = previous_reference_time;
+      }
+      DT_LOG_INFORMATION(logging_, "Selected records [" << lo << ", " << hi << ") of RED file '" << filename << "'");
+      config.filenames.push_back(filename);
+      record_range range;
+      range.begin = offset + lo;
+      range.end = offset + hi;
+      config.ranges.push_back(range);
+      offset += index.size();
+    }
+    // Keep an empty range if nothing is selected, so that nothing is read
+    if (config.ranges.empty()) config.ranges.push_back(record_range());
+    return config;
+  }
+
+  red_reader::red_reader(const config_type & config_)
+    : _config_(config_)
+  {
+    if (!_config_.filenames.empty()) {
+      snfee::io::multifile_data_reader::config_type reader_cfg;
+      reader_cfg.filenames = _config_.filenames;
+      if (_config_.read_ahead_bytes > 0) {
+        gzip_read_ahead::config_type read_ahead_cfg;
+        read_ahead_cfg.nbuffers = std::max<std::size_t>(_config_.read_ahead_bytes / read_ahead_cfg.buffer_size, 2);
+        _read_ahead_.reset(new gzip_read_ahead(_config_.filenames, read_ahead_cfg));
+        reader_cfg.filenames = _read_ahead_->get_filenames();
+      }
+      _source_.reset(new snfee::io::multifile_data_reader(reader_cfg));
+    }
+  }
+
+  red_reader::~red_reader()
+  {
+    close();
+  }
+
+  void red_reader::close()
+  {
+    // Close the named pipes before stopping the decompression threads
+    _source_.reset();
+    _read_ahead_.reset();
+  }
+
+  bool red_reader::load_next(snfee::data::raw_event_data & red_)
+  {
+    _has_skipped_record_ = false;
+    if (!_source_ || _end_of_window_) return false;
+    const bool select = !_config_.ranges.empty();
+    while (true) {
+      if (select) {
+        // Skip the ranges already read
+        while (_range_index_ < _config_.ranges.size() && _rank_ >= _config_.ranges[_range_index_].end) {
+          _range_index_++;
+        }
+        if (_range_index_ == _config_.ranges.size()) return false;
+      }
+      try {
+        if (!_source_->has_record_tag()) {
+          // A decompression error looks like the end of the input
+          if (_read_ahead_) _read_ahead_->check_errors();
+          return false;
+        }
+        DT_THROW_IF(!_source_->record_tag_is(snfee::data::raw_event_data::SERIAL_TAG),
+                    std::logic_error, "Unexpected record tag '" << _source_->get_record_tag() << "'!");
+        _source_->load(red_);
+      }
+      catch (...) {
+        // Report the decompression error rather than its effect on the reader
+        if (_read_ahead_) _read_ahead_->check_errors();
+        throw;
+      }
+      const std::size_t rank = _rank_++;
+      const int64_t event_id = red_.get_event_id();
+      const bool in_event_range = (_config_.first_event < 0 || event_id >= _config_.first_event)
+        && (_config_.last_event < 0 || event_id <= _config_.last_event);
+      const double reference_time = reference_time_in_seconds(red_.get_reference_time());
+      if (in_event_range && (!select || rank >= _config_.ranges[_range_index_].begin)) {
+        if (reference_time > _config_.end_time) {
+          // Stop reading: nothing after the window is converted
+          _end_of_window_ = true;
+          return false;
+        }
+        if (reference_time >= _config_.start_time) return true;
+      }
+      _skipped_++;
+      _has_skipped_record_ = true;
+      _last_skipped_reference_time_ = reference_time;
+    }
+  }
+
+  std::size_t red_reader::get_number_of_read_records() const
+  {
+    return _rank_;
+  }
+
+  std::size_t red_reader::get_number_of_skipped_records() const
+  {
+    return _skipped_;
+  }
+
+  bool red_reader::has_skipped_record() const
+  {
+    return _has_skipped_record_;
+  }
+
+  double red_reader::get_last_skipped_reference_time() const
+  {
+    return _last_skipped_reference_time_;
+  }
+
+  const red_reader::config_type & red_reader::get_config() const
+  {
+    return _config_;
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,135 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_reader.h
+///
+/// Sequential reader of RED records with record range selection.
+
+#ifndef SNREDBRIDGE_RED_READER_H
+#define SNREDBRIDGE_RED_READER_H
+
+// Standard library:
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+// - SNFEE:
+#include <snfee/io/multifile_data_reader.h>
+#include <snfee/data/raw_event_data.h>
+
+namespace snredbridge {
+
+  class gzip_read_ahead;
+
+  /// \brief Range [begin, end) of record ranks in the concatenated input files
+  struct record_range
+  {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  /// \brief Read the RED records of one or several files, in order
+  ///
+  /// If record ranges are given, the records outside of them are skipped
+  /// (loaded but not returned) and the reading stops after the last range.
+  /// The records outside of the event ID bounds are also skipped: with
+  /// unsorted event IDs, the record ranges may include some of them.
+  /// With a time window, the records before its start are skipped and the
+  /// reading stops at the first record after its end.
+  /// With a read-ahead size, gzipped files are decompressed on dedicated
+  /// threads (see gzip_read_ahead).
+  class red_reader
+  {
+  public:
+
+    /// Configuration
+    struct config_type
+    {
+      std::vector<std::string> filenames;  ///< RED files to read, in order
+      std::vector<record_range> ranges;    ///< Selected record ranges, in increasing order (empty: all records)
+      int64_t first_event = -1;            ///< Skip the records with lower event IDs (negative: no bound)
+      int64_t last_event = -1;             ///< Skip the records with higher event IDs (negative: no bound)
+      bool has_previous_reference_time = false; ///< The record before the first selected one is known
+      double previous_reference_time = 0;  ///< Reference time (s) of the record before the first selected one
+      std::size_t read_ahead_bytes = 0;    ///< Size of the decompression ring of gzipped files (0: inline decompression)
+      double start_time = -std::numeric_limits<double>::infinity(); ///< Skip the records before this reference time (s)
+      double end_time = +std::numeric_limits<double>::infinity();   ///< Stop at the first record after this reference time (s)
+    };
+
+    /// Select the records with event IDs in [first_event_, last_event_]
+    ///
+    /// A negative bound means no bound. The RED index of each input file is
+    /// used (built if needed): the files without any selected record are
+    /// dropped and the record ranges of the other ones are computed.
+    static config_type select_event_range(const std::vector<std::string> & filenames_,
+                                          const int64_t first_event_,
+                                          const int64_t last_event_,
+                                          const std::string & index_dir_,
+                                          datatools::logger::priority logging_);
+
+    /// Select the records with event IDs in [first_event_, last_event_] and
+    /// reference times (s from the run TDC=0) in [start_time_, end_time_]
+    ///
+    /// Same as select_event_range, with the time window also used to drop
+    /// files and narrow the record ranges. The time window is set in the
+    /// returned configuration, so that the reader also checks each record.
+    static config_type select_records(const std::vector<std::string> & filenames_,
+                                      const int64_t first_event_,
+                                      const int64_t last_event_,
+                                      const double start_time_,
+                                      const double end_time_,
+                                      const std::string & index_dir_,
+                                      datatools::logger::priority logging_);
+
+    /// Constructor
+    explicit red_reader(const config_type & config_);
+
+    /// Destructor
+    ~red_reader();
+
+    /// Close the RED files (and stop the decompression threads). Later
+    /// loads return false
+    void close();
+
+    /// Load the next selected record. Return false at the end of the input
+    bool load_next(snfee::data::raw_event_data & red_);
+
+    /// Return the number of records read from the files (including the skipped ones)
+    std::size_t get_number_of_read_records() const;
+
+    /// Return the number of skipped records
+    std::size_t get_number_of_skipped_records() const;
+
+    /// Check if records were skipped by the last call to load_next
+    ///
+    /// The time to the previous event of the next loaded record must then
+    /// be chained from the last skipped one (see skip_deltat_previous_event).
+    bool has_skipped_record() const;
+
+    /// Return the reference time (s) of the last record skipped by the last call to load_next
+    double get_last_skipped_reference_time() const;
+
+    /// Return the configuration
+    const config_type & get_config() const;
+
+  private:
+
+    config_type _config_;                                     ///< Configuration
+    std::unique_ptr<gzip_read_ahead> _read_ahead_;            ///< Decompression threads (optional)
+    std::unique_ptr<snfee::io::multifile_data_reader> _source_; ///< SNFEE reader
+    std::size_t _rank_ = 0;                                   ///< Rank of the next record
+    std::size_t _range_index_ = 0;                            ///< Current selected range
+    std::size_t _skipped_ = 0;                                ///< Number of skipped records
+    bool _end_of_window_ = false;                             ///< A record after the time window was read
+    bool _has_skipped_record_ = false;                        ///< The last call to load_next skipped records
+    double _last_skipped_reference_time_ = 0;                 ///< Reference time (s) of the last skipped record
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_READER_H
@@ -0,0 +1,354 @@
+// This project:
+#include <snredbridge/red_to_udd_conversion.h>
+
+// Standard library:
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/clhep_units.h>
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/properties.h>
+
+// - Falaise:
+#include <falaise/snemo/datamodels/event_header.h>
+#include <falaise/snemo/datamodels/unified_digitized_data.h>
+
+// - SNFEE:
+#include <snfee/data/time.h>
+
+// This project:
+#include <snredbridge/channel_table.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    /// Append a new (or recycled) calorimeter hit to the UDD bank
+    snemo::datamodel::calorimeter_digitized_hit &
+    add_calorimeter_hit(snemo::datamodel::unified_digitized_data & udd_,
+                        conversion_pools * pools_)
+    {
+      if (pools_ == nullptr) return udd_.add_calorimeter_hit();
+      udd_.grab_calorimeter_hits().push_back(pools_->calo_hits.acquire());
+      return udd_.grab_calorimeter_hits().back().grab();
+    }
+
+    /// Append a new (or recycled) tracker hit to the UDD bank
+    snemo::datamodel::tracker_digitized_hit &
+    add_tracker_hit(snemo::datamodel::unified_digitized_data & udd_,
+                    conversion_pools * pools_)
+    {
+      if (pools_ == nullptr) return udd_.add_tracker_hit();
+      udd_.grab_tracker_hits().push_back(pools_->tracker_hits.acquire());
+      return udd_.grab_tracker_hits().back().grab();
+    }
+
+    /// Conversion kernel. RED hits are read in place. If pools_ is set,
+    /// the EH and UDD banks already in the event record are reused and the
+    /// UDD hits are taken from the pools (the waveforms are then copied into
+    /// the storage of the recycled hits).
+    bool convert_red_event(const conversion_context & context_,
+                           const snfee::data::raw_event_data & red_,
+                           datatools::things & event_record_,
+                           conversion_pools * pools_)
+    {
+      // Run number
+      int32_t red_run_id   = red_.get_run_id();
+
+      // Event number
+      int32_t red_event_id = red_.get_event_id();
+
+      // Container of merged TriggerID(s) by event builder
+      const std::set<int32_t> & red_trigger_ids = red_.get_origin_trigger_ids();
+
+      // RED Digitized trigger hits
+      const std::vector<snfee::data::trigger_record> & red_trigger_hits = red_.get_trigger_records();
+
+      // RED Digitized calo hits
+      const std::vector<snfee::data::calo_digitized_hit> & red_calo_hits = red_.get_calo_hits();
+
+      // RED Digitized tracker hits
+      const std::vector<snfee::data::tracker_digitized_hit> & red_tracker_hits = red_.get_tracker_hits();
+
+      // Print RED infos
+      // std::cout << "Event #" << red_event_id << " contains "
+      //           << red_trigger_ids.size() << " TriggerID(s) with "
+      //           << red_calo_hits.size() << " calo hit(s) and "
+      //           << red_tracker_hits.size() << " tracker hit(s)"
+      //           << std::endl;
+
+      std::string EH_output_tag  = "EH";
+      std::string UDD_output_tag = "UDD";
+
+      // Crop the events after the end of the run time window before
+      // building anything
+      const snfee::data::timestamp & reference_timestamp = red_.get_reference_time();
+      const double reference_time = reference_time_in_seconds(reference_timestamp);
+      if (reference_time > context_.run_end_time)
+        return false;
+
+      const bool recycle = (pools_ != nullptr)
+        && event_record_.has(EH_output_tag) && event_record_.has(UDD_output_tag);
+
+      // Empty working EH object (all its attributes are set below)
+      // auto & EH = snedm::addToEvent<snemo::datamodel::event_header>(EH_output_tag, event_record_);
+      auto & EH = recycle ? event_record_.grab<snemo::datamodel::event_header>(EH_output_tag)
+        : event_record_.add<snemo::datamodel::event_header>(EH_output_tag);
+
+      // Empty working UDD object
+      // auto & UDD = snedm::addToEvent<snemo::datamodel::unified_digitized_data>(UDD_output_tag, event_record_);
+      auto & UDD = recycle ? event_record_.grab<snemo::datamodel::unified_digitized_data>(UDD_output_tag)
+        : event_record_.add<snemo::datamodel::unified_digitized_data>(UDD_output_tag);
+
+      if (recycle) {
+        // Give the hits of the previous event back to the pools
+        pools_->calo_hits.release(UDD.grab_calorimeter_hits());
+        pools_->tracker_hits.release(UDD.grab_tracker_hits());
+        UDD.grab_auxiliaries().clear();
+      }
+
+      // Fill Event Header based on RED attributes
+      EH.get_id().set_run_number(red_run_id);
+      EH.get_id().set_event_number(red_event_id);
+      EH.set_generation(snemo::datamodel::event_header::GENERATION_REAL);
+
+      // Set the event timestamp
+      EH.set_timestamp(make_event_timestamp(context_, reference_time));
+
+      // Transfer RED properties to EH one
+      EH.set_properties(red_.get_auxiliaries());
+
+      // Note: deltat to the previous event is computed afterwards, in event
+      // order, by fill_deltat_previous_event
+
+      // // Store event time width
+      // if (red_.get_auxiliaries().has_key("time_width"))
+      //   EH.get_properties().store_real("time_width", red_.get_auxiliaries().fetch_real("time_width"));
+
+      // // Store first hit time
+      // if (red_.get_auxiliaries().has_key("first_hit_time"))
+      //   EH.get_properties().store_real("first_hit_time", red_.get_auxiliaries().fetch_real("first_hit_time"));
+
+      // Store trigger info
+      datatools::properties::data::vint trigger_id_vint;
+      datatools::properties::data::vint trigger_decision_vint;
+      datatools::properties::data::vint progenitor_trigger_id_vint;
+
+      for (const auto & red_trigger_hit : red_trigger_hits) {
+        trigger_id_vint.push_back(red_trigger_hit.get_trigger_id());
+        trigger_decision_vint.push_back(red_trigger_hit.get_trigger_decision());
+        if (red_trigger_hit.has_progenitor_trigger_id())
+          progenitor_trigger_id_vint.push_back(red_trigger_hit.get_progenitor_trigger_id());
+        else progenitor_trigger_id_vint.push_back(-1);
+      }
+
+      EH.get_properties().store("trigger_id", trigger_id_vint);
+      EH.get_properties().store("trigger_decision", trigger_decision_vint);
+      EH.get_properties().store("progenitor_trigger_id", progenitor_trigger_id_vint);
+
+      // GO: we can add some additional properties to the Event Header
+      // EH.get_properties().store("simulation.bundle", "falaise");
+      // EH.get_properties().store("simulation.version", "0.1");
+      // EH.get_properties().store("author", std::string(getenv("USER")));
+
+      // Copy RED attributes to UDD attributes
+      UDD.set_run_id(red_run_id);
+      UDD.set_event_id(red_event_id);
+      UDD.set_reference_timestamp(reference_timestamp.get_ticks());
+      UDD.set_origin_trigger_ids(red_trigger_ids);
+      // UDD.set_auxiliaries(red_.get_auxiliaries());
+
+      // Scan and copy RED calo digitized hit into UDD calo digitized hit:
+      for (std::size_t ihit = 0; ihit < red_calo_hits.size(); ihit++)
+        {
+          // std::clog << "DEBUG do_red_to_udd_conversion : Calo hit #" << ihit << std::endl;
+          const snfee::data::calo_digitized_hit & red_calo_hit = red_calo_hits[ihit];
+          snemo::datamodel::calorimeter_digitized_hit & udd_calo_hit = add_calorimeter_hit(UDD, pools_);
+          udd_calo_hit.set_geom_id(red_calo_hit.get_geom_id());
+          udd_calo_hit.set_hit_id(red_calo_hit.get_hit_id());
+          udd_calo_hit.set_timestamp(red_calo_hit.get_reference_time().get_ticks());
+          if (!context_.no_waveform) {
+            if (context_.waveform_roi.is_active()) {
+              // Only the (encoded) window is stored: copy it rather than moving the whole waveform
+              const auto & red_waveform = red_calo_hit.get_waveform();
+              const waveform_window window = compute_waveform_window(red_waveform.size(), red_calo_hit, context_.waveform_roi);
+              udd_calo_hit.set_waveform(encode_waveform(red_waveform, window, context_.waveform_roi.delta,
+                                                        udd_calo_hit.grab_auxiliaries()));
+            }
+            else
+              udd_calo_hit.set_waveform(red_calo_hit.get_waveform());
+          }
+          udd_calo_hit.set_low_threshold_only(red_calo_hit.is_low_threshold_only());
+          udd_calo_hit.set_high_threshold(red_calo_hit.is_high_threshold());
+          udd_calo_hit.set_fcr(red_calo_hit.get_fcr());
+          udd_calo_hit.set_lt_trigger_counter(red_calo_hit.get_lt_trigger_counter());
+          udd_calo_hit.set_lt_time_counter(red_calo_hit.get_lt_time_counter());
+          udd_calo_hit.set_fwmeas_baseline(red_calo_hit.get_fwmeas_baseline());
+          udd_calo_hit.set_fwmeas_peak_amplitude(red_calo_hit.get_fwmeas_peak_amplitude());
+          udd_calo_hit.set_fwmeas_peak_cell(red_calo_hit.get_fwmeas_peak_cell());
+          udd_calo_hit.set_fwmeas_charge(red_calo_hit.get_fwmeas_charge());
+          udd_calo_hit.set_fwmeas_rising_cell(red_calo_hit.get_fwmeas_rising_cell());
+          udd_calo_hit.set_fwmeas_falling_cell(red_calo_hit.get_fwmeas_falling_cell());
+          snemo::datamodel::calorimeter_digitized_hit::rtd_origin the_rtd_origin(red_calo_hit.get_origin().get_hit_number(),
+                                                                                 red_calo_hit.get_origin().get_trigger_id());
+          udd_calo_hit.set_origin(the_rtd_origin);
+
+        } // end of for ihit
+
+      // sort calo hit by om num
+      auto & udd_calo_hits = UDD.grab_calorimeter_hits();
+      sort_by_channel(udd_calo_hits);
+
+      // correct hit id values
+      for (std::size_t ihit = 0; ihit < udd_calo_hits.size(); ihit++)
+        udd_calo_hits[ihit]->set_hit_id(ihit);
+
+
+      // Scan and copy RED tracker digitized hit into UDD calo digitized hit:
+      for (std::size_t ihit = 0; ihit < red_tracker_hits.size(); ihit++)
+        {
+          // std::clog << "DEBUG do_red_to_udd_conversion : Tracker hit #" << ihit << std::endl;
+          const snfee::data::tracker_digitized_hit & red_tracker_hit = red_tracker_hits[ihit];
+          snemo::datamodel::tracker_digitized_hit & udd_tracker_hit = add_tracker_hit(UDD, pools_);
+          udd_tracker_hit.set_geom_id(red_tracker_hit.get_geom_id());
+          udd_tracker_hit.set_hit_id(red_tracker_hit.get_hit_id());
+
+          // Do the loop on RED GG timestamps and convert them into UDD GG timestamps
+          const std::vector<snfee::data::tracker_digitized_hit::gg_times> & gg_timestamps_v = red_tracker_hit.get_times();
+
+          for (std::size_t iggtime = 0; iggtime < gg_timestamps_v.size(); iggtime++)
+            {
+              // std::clog << "DEBUG do_red_to_udd_conversion : Tracker hit #" << ihit << " Geiger Time #" << iggtime <<  std::endl;
+              // Retrieve RED GG timestamps
+              const snfee::data::tracker_digitized_hit::gg_times & a_gg_timestamp = gg_timestamps_v[iggtime];
+
+              // Create empty UDD GG timestamps
+              snemo::datamodel::tracker_digitized_hit::gg_times & udd_gg_timestamp = udd_tracker_hit.add_times();
+
+              // Fill UDD anode and cathode timestamps and RTD origin for backtracing
+              snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r0_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R0).get_hit_number(),
+                                                                                      a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R0).get_trigger_id());
+              udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R0,
+                                                anode_r0_rtd_origin);
+              udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R0,
+                                              a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R0).get_ticks());
+
+              snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r1_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R1).get_hit_number(),
+                                                                                      a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R1).get_trigger_id());
+              udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R1,
+                                                anode_r1_rtd_origin);
+              udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R1,
+                                              a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R1).get_ticks());
+
+              snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r2_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R2).get_hit_number(),
+                                                                                      a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R2).get_trigger_id());
+              udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R2,
+                                                anode_r2_rtd_origin);
+              udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R2,
+                                              a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R2).get_ticks());
+
+              snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r3_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R3).get_hit_number(),
+                                                                                      a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R3).get_trigger_id());
+              udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R3,
+                                                anode_r3_rtd_origin);
+              udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R3,
+                                              a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R3).get_ticks());
+
+              snemo::datamodel::tracker_digitized_hit::rtd_origin anode_r4_rtd_origin(a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R4).get_hit_number(),
+                                                                                      a_gg_timestamp.get_anode_origin(snfee::data::tracker_digitized_hit::ANODE_R4).get_trigger_id());
+              udd_gg_timestamp.set_anode_origin(snemo::datamodel::tracker_digitized_hit::ANODE_R4,
+                                                anode_r4_rtd_origin);
+              udd_gg_timestamp.set_anode_time(snemo::datamodel::tracker_digitized_hit::ANODE_R4,
+                                              a_gg_timestamp.get_anode_time(snfee::data::tracker_digitized_hit::ANODE_R4).get_ticks());
+
+              snemo::datamodel::tracker_digitized_hit::rtd_origin bottom_cathode_rtd_origin(a_gg_timestamp.get_bottom_cathode_origin().get_hit_number(),
+                                                                                            a_gg_timestamp.get_bottom_cathode_origin().get_trigger_id());
+              udd_gg_timestamp.set_bottom_cathode_origin(bottom_cathode_rtd_origin);
+              udd_gg_timestamp.set_bottom_cathode_time(a_gg_timestamp.get_bottom_cathode_time().get_ticks());
+
+
+              snemo::datamodel::tracker_digitized_hit::rtd_origin top_cathode_rtd_origin(a_gg_timestamp.get_top_cathode_origin().get_hit_number(),
+                                                                                         a_gg_timestamp.get_top_cathode_origin().get_trigger_id());
+              udd_gg_timestamp.set_top_cathode_origin(top_cathode_rtd_origin);
+              udd_gg_timestamp.set_top_cathode_time(a_gg_timestamp.get_top_cathode_time().get_ticks());
+
+
+            } // end of iggtime
+
+        } // end for ihit
+
+      // sort tracker hit by cell num
+      auto & udd_tracker_hits = UDD.grab_tracker_hits();
+      sort_by_channel(udd_tracker_hits);
+
+      // correct hit id values
+      for (std::size_t ihit = 0; ihit < udd_tracker_hits.size(); ihit++)
+        udd_tracker_hits[ihit]->set_hit_id(ihit);
+
+      // red_.print_tree(std::clog);
+      // EH.tree_dump(std::clog, "Event header('EH'): ");
+      // UDD.tree_dump(std::clog, "Unified Digitized Data('UDD'): ");
+
+      return true;
+    }
+
+  } // end of anonymous namespace
+
+  double reference_time_in_seconds(const snfee::data::timestamp & reference_timestamp_)
+  {
+    return (reference_timestamp_.get_ticks() * snfee::data::clock_period(reference_timestamp_.get_clock()))/CLHEP::second;
+  }
+
+  snemo::datamodel::timestamp make_event_timestamp(const conversion_context & context_,
+                                                   const double reference_time_)
+  {
+    const double event_time = context_.run_sync_time + reference_time_;
+    const int64_t event_time_sec = std::floor(event_time);
+    const int64_t event_time_psec = std::floor(1E12*(event_time-event_time_sec));
+    snemo::datamodel::timestamp event_timestamp;
+    event_timestamp.set_seconds(event_time_sec);
+    event_timestamp.set_picoseconds(event_time_psec);
+    return event_timestamp;
+  }
+
+  bool do_red_to_udd_conversion(const conversion_context & context_,
+                                const snfee::data::raw_event_data & red_,
+                                datatools::things & event_record_,
+                                conversion_pools * pools_)
+  {
+    return convert_red_event(context_, red_, event_record_, pools_);
+  }
+
+  void fill_deltat_previous_event(conversion_context & context_,
+                                  datatools::things & event_record_)
+  {
+    auto & EH = event_record_.grab<snemo::datamodel::event_header>("EH");
+
+    // Compute and store deltat to the previous event
+    const snemo::datamodel::timestamp & eh_timestamp = EH.get_timestamp();
+    const snemo::datamodel::timestamp & previous_eh_timestamp = context_.previous_eh_timestamp;
+    double deltat_previous_event = 0;
+    if (previous_eh_timestamp.is_valid()) {
+      deltat_previous_event = eh_timestamp.get_seconds() - previous_eh_timestamp.get_seconds();
+      deltat_previous_event += 1E-12 * (eh_timestamp.get_picoseconds() - previous_eh_timestamp.get_picoseconds());
+    }
+
+    if (deltat_previous_event < 0)
+      DT_LOG_WARNING(context_.logging, "negative deltat (" << deltat_previous_event << " sec) for event #" << EH.get_id().get_event_number());
+
+    EH.get_properties().store("deltat_previous_event", deltat_previous_event*CLHEP::second);
+    context_.previous_eh_timestamp = eh_timestamp;
+  }
+
+  void skip_deltat_previous_event(conversion_context & context_,
+                                  const double reference_time_)
+  {
+    context_.previous_eh_timestamp = make_event_timestamp(context_, reference_time_);
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,66 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_to_udd_conversion.h
+///
+/// Conversion of SNFEE Raw Event Data (RED) into a Falaise event record
+/// made of an event header ("EH") and unified digitized data ("UDD") banks.
+
+#ifndef SNREDBRIDGE_RED_TO_UDD_CONVERSION_H
+#define SNREDBRIDGE_RED_TO_UDD_CONVERSION_H
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/things.h>
+
+// - Falaise:
+#include <falaise/snemo/datamodels/timestamp.h>
+
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+#include <snfee/data/timestamp.h>
+
+// This project:
+#include <snredbridge/conversion_context.h>
+#include <snredbridge/hit_pool.h>
+
+namespace snredbridge {
+
+  /// Return the time of a RED reference timestamp in seconds from the run TDC=0
+  double reference_time_in_seconds(const snfee::data::timestamp & reference_timestamp_);
+
+  /// Return the absolute event timestamp for a reference time (s) in the run
+  snemo::datamodel::timestamp make_event_timestamp(const conversion_context & context_,
+                                                   const double reference_time_);
+
+  /// Convert a RED event into the EH and UDD banks of an event record
+  ///
+  /// Return false if the event is after the end of the run time window,
+  /// in which case the event record must be discarded. This function only
+  /// reads the context and can be called concurrently on different events.
+  /// The "deltat_previous_event" EH property is not set here, see
+  /// fill_deltat_previous_event.
+  ///
+  /// If pools_ is set (recycling mode), the EH and UDD banks of a previously
+  /// converted event record are reused and the UDD hits come from the pools,
+  /// which must not be shared between threads.
+  bool do_red_to_udd_conversion(const conversion_context & context_,
+                                const snfee::data::raw_event_data & red_,
+                                datatools::things & event_record_,
+                                conversion_pools * pools_ = nullptr);
+
+  /// Store the time to the previous event in the EH bank of an event record
+  ///
+  /// Must be called once per stored event record, in event order.
+  void fill_deltat_previous_event(conversion_context & context_,
+                                  datatools::things & event_record_);
+
+  /// Advance the "deltat_previous_event" chain past an event which is not stored
+  ///
+  /// Must be called in event order for the RED events rejected by a
+  /// selection, with their reference time (s), so that the time to the
+  /// previous event still counts them.
+  void skip_deltat_previous_event(conversion_context & context_,
+                                  const double reference_time_);
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_TO_UDD_CONVERSION_H
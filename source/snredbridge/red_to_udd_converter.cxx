@@ -0,0 +1,61 @@
+// This project:
+#include <snredbridge/red_to_udd_converter.h>
+
+// Standard library:
+#include <utility>
+
+// This project:
+#include <snredbridge/red_to_udd_conversion.h>
+
+namespace snredbridge {
+
+  red_to_udd_converter::red_to_udd_converter(const conversion_context & context_)
+    : _context_(context_)
+  {
+  }
+
+  const conversion_context & red_to_udd_converter::get_context() const
+  {
+    return _context_;
+  }
+
+  bool red_to_udd_converter::convert(const snfee::data::raw_event_data & red_,
+                                     datatools::things & event_record_,
+                                     conversion_pools * pools_) const
+  {
+    return do_red_to_udd_conversion(_context_, red_, event_record_, pools_);
+  }
+
+  void red_to_udd_converter::chain(datatools::things & event_record_)
+  {
+    std::lock_guard<std::mutex> lock(_chain_mutex_);
+    fill_deltat_previous_event(_context_, event_record_);
+  }
+
+  void red_to_udd_converter::skip(const snfee::data::raw_event_data & red_)
+  {
+    skip(reference_time_in_seconds(red_.get_reference_time()));
+  }
+
+  void red_to_udd_converter::skip(const double reference_time_)
+  {
+    std::lock_guard<std::mutex> lock(_chain_mutex_);
+    skip_deltat_previous_event(_context_, reference_time_);
+  }
+
+  bool red_to_udd_converter::process(const snfee::data::raw_event_data & red_,
+                                     datatools::things & event_record_,
+                                     conversion_pools * pools_)
+  {
+    if (!convert(red_, event_record_, pools_)) return false;
+    chain(event_record_);
+    return true;
+  }
+
+  void red_to_udd_converter::reset_chaining()
+  {
+    std::lock_guard<std::mutex> lock(_chain_mutex_);
+    _context_.previous_eh_timestamp = snemo::datamodel::timestamp();
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,77 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_to_udd_converter.h
+///
+/// Thread-safe RED to UDD converter for use outside of red_bridge.
+
+#ifndef SNREDBRIDGE_RED_TO_UDD_CONVERTER_H
+#define SNREDBRIDGE_RED_TO_UDD_CONVERTER_H
+
+// Standard library:
+#include <mutex>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/things.h>
+
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+// This project:
+#include <snredbridge/conversion_context.h>
+#include <snredbridge/hit_pool.h>
+
+namespace snredbridge {
+
+  /// \brief Convert RED events into event records with EH and UDD banks
+  ///
+  /// The configuration is given at construction and never changes, so
+  /// convert() can be called concurrently from several threads (each with
+  /// its own pools, if any). The "deltat_previous_event" chaining is done
+  /// by chain(), which must be called once per kept event record in event
+  /// order; it is serialized by an internal mutex. process() does both for
+  /// sequential users.
+  class red_to_udd_converter
+  {
+  public:
+
+    /// Constructor
+    explicit red_to_udd_converter(const conversion_context & context_);
+
+    /// Return the conversion context
+    const conversion_context & get_context() const;
+
+    /// Convert a RED event (thread-safe)
+    ///
+    /// Return false if the event is after the end of the run time window.
+    /// See do_red_to_udd_conversion.
+    bool convert(const snfee::data::raw_event_data & red_,
+                 datatools::things & event_record_,
+                 conversion_pools * pools_ = nullptr) const;
+
+    /// Store the time to the previous event in the EH bank of an event record
+    void chain(datatools::things & event_record_);
+
+    /// Chain past a RED event which is not converted (e.g. rejected by a selection)
+    void skip(const snfee::data::raw_event_data & red_);
+
+    /// Chain past a RED event which is not converted, given its reference time (s)
+    void skip(const double reference_time_);
+
+    /// Convert a RED event and chain its event record to the previous one
+    bool process(const snfee::data::raw_event_data & red_,
+                 datatools::things & event_record_,
+                 conversion_pools * pools_ = nullptr);
+
+    /// Forget the previous event (start of a new run)
+    void reset_chaining();
+
+  private:
+
+    conversion_context _context_;  ///< Configuration and chaining state
+    std::mutex _chain_mutex_;      ///< Protection of the chaining state
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_TO_UDD_CONVERTER_H
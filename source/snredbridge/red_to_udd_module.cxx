@@ -0,0 +1,152 @@
+// This project:
+#include <snredbridge/red_to_udd_module.h>
+
+// Standard library:
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/properties.h>
+
+// - SNFEE:
+#include <snfee/snfee.h>
+
+// This project:
+#include <snredbridge/file_utils.h>
+#include <snredbridge/red_to_udd_conversion.h>
+#include <snredbridge/waveform_roi.h>
+
+namespace snredbridge {
+
+  // Registration instantiation macro:
+  DPP_MODULE_REGISTRATION_IMPLEMENT(red_to_udd_module, "snredbridge::red_to_udd_module")
+
+  red_to_udd_module::red_to_udd_module(datatools::logger::priority logging_)
+    : dpp::base_module(logging_)
+  {
+  }
+
+  red_to_udd_module::~red_to_udd_module()
+  {
+    if (is_initialized()) reset();
+  }
+
+  void red_to_udd_module::initialize(const datatools::properties & config_,
+                                     datatools::service_manager & /* services_ */,
+                                     dpp::module_handle_dict_type & /* modules_ */)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Module is already initialized!");
+    _common_initialize(config_);
+
+    DT_THROW_IF(!config_.has_key("input_files"), std::logic_error, "Missing 'input_files' property!");
+    std::vector<std::string> input_files;
+    config_.fetch("input_files", input_files);
+    const std::vector<std::string> red_filenames = expand_filenames(input_files);
+    DT_THROW_IF(red_filenames.empty(), std::logic_error, "No RED input file!");
+
+    conversion_context context;
+    context.logging = get_logging_priority();
+    DT_THROW_IF(!config_.has_key("run_sync_time"), std::logic_error, "Missing 'run_sync_time' property!");
+    context.run_sync_time = config_.fetch_real("run_sync_time");
+    if (config_.has_key("run_start_time")) context.run_start_time = config_.fetch_real("run_start_time");
+    if (config_.has_key("run_end_time")) context.run_end_time = config_.fetch_real("run_end_time");
+    if (config_.has_key("no_waveform")) context.no_waveform = config_.fetch_boolean("no_waveform");
+    if (config_.has_key("waveform_roi")) parse_waveform_roi(config_.fetch_string("waveform_roi"), context.waveform_roi);
+    if (config_.has_key("waveform_delta")) context.waveform_roi.delta = config_.fetch_boolean("waveform_delta");
+
+    _selection_ = event_selection();
+    if (config_.has_key("selection")) {
+      std::vector<std::string> cuts;
+      config_.fetch("selection", cuts);
+      for (const auto & cut : cuts) _selection_.add_cut(cut);
+    }
+
+    std::string index_dir;
+    if (config_.has_key("index_dir")) index_dir = config_.fetch_string("index_dir");
+
+    if (!snfee::is_initialized()) snfee::initialize();
+
+    red_reader::config_type reader_cfg;
+    if (context.run_start_time > 0) {
+      reader_cfg = red_reader::select_records(red_filenames, -1, -1,
+                                              context.run_start_time, context.run_end_time,
+                                              index_dir, get_logging_priority());
+      if (reader_cfg.has_previous_reference_time)
+        context.previous_eh_timestamp = make_event_timestamp(context, reader_cfg.previous_reference_time);
+    } else {
+      reader_cfg.filenames = red_filenames;
+    }
+    reader_cfg.end_time = context.run_end_time;
+    if (config_.has_key("read_ahead")) reader_cfg.read_ahead_bytes = config_.fetch_integer("read_ahead");
+
+    _reader_.reset(new red_reader(reader_cfg));
+    _converter_.reset(new red_to_udd_converter(context));
+    _nread_ = 0;
+    _nconverted_ = 0;
+    _terminated_ = false;
+    _set_initialized(true);
+  }
+
+  void red_to_udd_module::reset()
+  {
+    DT_THROW_IF(!is_initialized(), std::logic_error, "Module is not initialized!");
+    _set_initialized(false);
+    if (_selection_.is_active()) {
+      DT_LOG_NOTICE(get_logging_priority(), "Selection: " << _selection_.get_number_of_accepted() << " accepted, "
+                    << _selection_.get_number_of_rejected() << " rejected RED events");
+    }
+    _reader_.reset();
+    _converter_.reset();
+  }
+
+  dpp::base_module::process_status red_to_udd_module::process(datatools::things & event_record_)
+  {
+    DT_THROW_IF(!is_initialized(), std::logic_error, "Module '" << get_name() << "' is not initialized!");
+    if (_terminated_) return PROCESS_STOP;
+    // Banks left by a previous module or event
+    if (event_record_.has("EH")) event_record_.remove("EH");
+    if (event_record_.has("UDD")) event_record_.remove("UDD");
+    while (true) {
+      if (!_reader_->load_next(_red_)) {
+        _terminated_ = true;
+        return PROCESS_STOP;
+      }
+      _nread_++;
+      if (_reader_->has_skipped_record()) {
+        _converter_->skip(_reader_->get_last_skipped_reference_time());
+      }
+      if (_selection_.is_active()) {
+        const int rejecting_cut = _selection_.find_rejecting_cut(_red_);
+        _selection_.count(rejecting_cut);
+        if (rejecting_cut >= 0) {
+          _converter_->skip(_red_);
+          continue;
+        }
+      }
+      break;
+    }
+    if (!_converter_->convert(_red_, event_record_)) {
+      // After the end of the run time window
+      _terminated_ = true;
+      return PROCESS_STOP;
+    }
+    _converter_->chain(event_record_);
+    _nconverted_++;
+    return PROCESS_OK;
+  }
+
+  std::size_t red_to_udd_module::get_number_of_read_events() const
+  {
+    return _nread_;
+  }
+
+  std::size_t red_to_udd_module::get_number_of_converted_events() const
+  {
+    return _nconverted_;
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,89 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_to_udd_module.h
+///
+/// Data processing module reading RED files and filling the EH and UDD
+/// banks of the event records of a dpp/Falaise pipeline.
+
+#ifndef SNREDBRIDGE_RED_TO_UDD_MODULE_H
+#define SNREDBRIDGE_RED_TO_UDD_MODULE_H
+
+// Standard library:
+#include <memory>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/dpp/base_module.h>
+
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+// This project:
+#include <snredbridge/event_selection.h>
+#include <snredbridge/red_reader.h>
+#include <snredbridge/red_to_udd_converter.h>
+
+namespace snredbridge {
+
+  /// \brief Source module converting RED events into event records
+  ///
+  /// Each call to process() loads the next (selected) RED event and fills
+  /// the "EH" and "UDD" banks of the event record, replacing the ones it
+  /// may already have. The module returns PROCESS_STOP at the end of the
+  /// RED files or of the run time window. It stands for the input module
+  /// and the intermediate UDD file of a red_bridge + flreconstruct chain.
+  ///
+  /// Configuration properties:
+  ///  - "input_files" (string[], mandatory): RED files, read in order
+  ///  - "run_sync_time" (real, mandatory): UNIX time (s) of the run TDC=0
+  ///  - "run_start_time", "run_end_time" (real): time window (s from the sync time)
+  ///  - "no_waveform" (boolean): do not copy the calorimeter waveforms
+  ///  - "waveform_roi" (string, "PRE:POST"), "waveform_delta" (boolean):
+  ///    stored part and encoding of the waveforms (see waveform_roi.h)
+  ///  - "selection" (string[]): event selection cuts (see event_selection.h)
+  ///  - "read_ahead" (integer): size in bytes of the gzip read-ahead ring (0: none)
+  ///  - "index_dir" (string): directory of the RED index files, used with a start time
+  class red_to_udd_module : public dpp::base_module
+  {
+  public:
+
+    /// Constructor
+    red_to_udd_module(datatools::logger::priority logging_ = datatools::logger::PRIO_FATAL);
+
+    /// Destructor
+    virtual ~red_to_udd_module();
+
+    /// Initialization
+    virtual void initialize(const datatools::properties & config_,
+                            datatools::service_manager & services_,
+                            dpp::module_handle_dict_type & modules_);
+
+    /// Reset
+    virtual void reset();
+
+    /// Fill the event record from the next RED event
+    virtual process_status process(datatools::things & event_record_);
+
+    /// Return the number of RED events read
+    std::size_t get_number_of_read_events() const;
+
+    /// Return the number of filled event records
+    std::size_t get_number_of_converted_events() const;
+
+  private:
+
+    std::unique_ptr<red_reader> _reader_;              ///< RED reader
+    std::unique_ptr<red_to_udd_converter> _converter_; ///< Converter
+    event_selection _selection_;                       ///< Pre-conversion selection
+    snfee::data::raw_event_data _red_;                 ///< Working RED event
+    std::size_t _nread_ = 0;                           ///< Number of RED events read
+    std::size_t _nconverted_ = 0;                      ///< Number of filled event records
+    bool _terminated_ = false;                         ///< The input is exhausted
+
+    // Registration macro:
+    DPP_MODULE_REGISTRATION_INTERFACE(red_to_udd_module)
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_TO_UDD_MODULE_H
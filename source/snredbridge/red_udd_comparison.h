@@ -0,0 +1,54 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_udd_comparison.h
+///
+/// Comparison of a SNFEE RED event with the corresponding Falaise event
+/// record (EH and UDD banks).
+
+#ifndef SNREDBRIDGE_RED_UDD_COMPARISON_H
+#define SNREDBRIDGE_RED_UDD_COMPARISON_H
+
+// Standard library:
+#include <cstddef>
+#include <iostream>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/things.h>
+
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+namespace snredbridge {
+
+  /// Check that an event record ("EH" and "UDD" banks) is equivalent to a RED event
+  ///
+  /// If no_wf_ is set, the calorimeter waveforms are not compared.
+  bool compare_red_event_record(const snfee::data::raw_event_data & red_,
+                                const datatools::things & event_record_,
+                                const datatools::logger::priority & logging_,
+                                bool no_wf_);
+
+  /// \brief Counters of a RED/UDD validation
+  struct validation_summary
+  {
+    std::size_t red_counter = 0;             ///< RED events
+    std::size_t er_counter = 0;              ///< Event records matching a RED event
+    std::size_t eh_counter = 0;              ///< Valid event headers
+    std::size_t udd_counter = 0;             ///< Valid UDD banks
+    std::size_t missing_event_counter = 0;   ///< RED events without event record
+    std::size_t non_equal_event_counter = 0; ///< RED events not equivalent to their event record
+
+    /// Count a RED event compared with its event record
+    void add_compared_event(bool equivalent_);
+
+    /// Print the summary
+    void print(std::ostream & out_ = std::cout) const;
+
+    /// Add the counters of another summary
+    validation_summary & operator+=(const validation_summary & other_);
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_UDD_COMPARISON_H
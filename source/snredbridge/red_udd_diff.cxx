@@ -0,0 +1,265 @@
+// This project:
+#include <snredbridge/red_udd_diff.h>
+
+// Standard library:
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+// - Falaise:
+#include <falaise/snemo/datamodels/event_header.h>
+#include <falaise/snemo/datamodels/unified_digitized_data.h>
+
+// This project:
+#include <snredbridge/channel_table.h>
+#include <snredbridge/waveform_roi.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    template <typename T>
+    std::string to_text(const T & value_)
+    {
+      std::ostringstream out;
+      out << value_;
+      return out.str();
+    }
+
+    std::string to_text(const std::set<int32_t> & values_)
+    {
+      std::ostringstream out;
+      out << '{';
+      for (auto it = values_.begin(); it != values_.end(); ++it) {
+        if (it != values_.begin()) out << ',';
+        out << *it;
+      }
+      out << '}';
+      return out.str();
+    }
+
+    std::string hit_key_text(const geomtools::geom_id & geom_id_, const int32_t hit_id_)
+    {
+      std::ostringstream out;
+      out << geom_id_ << '/' << hit_id_;
+      return out.str();
+    }
+
+    const decltype(snemo::datamodel::tracker_digitized_hit::ANODE_R0) anode_indexes[5] = {
+      snemo::datamodel::tracker_digitized_hit::ANODE_R0,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R1,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R2,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R3,
+      snemo::datamodel::tracker_digitized_hit::ANODE_R4
+    };
+
+    /// Append the differences found in one event
+    class difference_collector
+    {
+    public:
+
+      difference_collector(const snfee::data::raw_event_data & red_,
+                           std::vector<field_difference> & differences_)
+        : _red_(red_), _differences_(differences_)
+      {
+      }
+
+      void set_location(const std::string & bank_, const std::string & hit_key_ = "")
+      {
+        _bank_ = bank_;
+        _hit_key_ = hit_key_;
+      }
+
+      template <typename RedValue, typename UddValue>
+      void check(const std::string & field_, const RedValue & red_value_, const UddValue & udd_value_)
+      {
+        if (red_value_ == udd_value_) return;
+        add(field_, to_text(red_value_), to_text(udd_value_));
+      }
+
+      void check_waveform(const std::vector<int16_t> & red_waveform_,
+                          const std::vector<int16_t> & udd_stored_,
+                          const datatools::properties & udd_auxiliaries_)
+      {
+        // The UDD waveform may only hold a (delta-encoded) window of the RED one
+        std::vector<int16_t> udd_samples;
+        std::size_t udd_full_length = 0;
+        const waveform_window window = decode_waveform(udd_stored_, udd_auxiliaries_, udd_samples, udd_full_length);
+        if (udd_full_length != red_waveform_.size()) {
+          add("waveform.size", to_text(red_waveform_.size()), to_text(udd_full_length));
+          return;
+        }
+        if (window.offset + window.length > red_waveform_.size()) {
+          add("waveform.window", to_text(red_waveform_.size()), to_text(window.offset) + "+" + to_text(window.length));
+          return;
+        }
+        // Only report the first differing sample
+        for (std::size_t isample = 0; isample < window.length; isample++) {
+          const std::size_t red_isample = window.offset + isample;
+          if (red_waveform_[red_isample] != udd_samples[isample]) {
+            add("waveform[" + to_text(red_isample) + "]", to_text(red_waveform_[red_isample]), to_text(udd_samples[isample]));
+            return;
+          }
+        }
+      }
+
+      template <typename RedOrigin, typename UddOrigin>
+      void check_origin(const std::string & field_, const RedOrigin & red_origin_, const UddOrigin & udd_origin_)
+      {
+        check(field_ + ".hit_number", red_origin_.get_hit_number(), udd_origin_.get_hit_number());
+        check(field_ + ".trigger_id", red_origin_.get_trigger_id(), udd_origin_.get_trigger_id());
+      }
+
+      void add(const std::string & field_, const std::string & red_value_, const std::string & udd_value_)
+      {
+        field_difference difference;
+        difference.run_id = _red_.get_run_id();
+        difference.event_id = _red_.get_event_id();
+        difference.bank = _bank_;
+        difference.hit_key = _hit_key_;
+        difference.field = field_;
+        difference.red_value = red_value_;
+        difference.udd_value = udd_value_;
+        _differences_.push_back(difference);
+      }
+
+    private:
+
+      const snfee::data::raw_event_data & _red_;
+      std::vector<field_difference> & _differences_;
+      std::string _bank_;
+      std::string _hit_key_;
+
+    };
+
+  } // end of anonymous namespace
+
+  void diff_red_event_record(const snfee::data::raw_event_data & red_,
+                             const datatools::things & event_record_,
+                             bool no_wf_,
+                             std::vector<field_difference> & differences_)
+  {
+    const auto & EH  = event_record_.get<snemo::datamodel::event_header>("EH");
+    const auto & UDD = event_record_.get<snemo::datamodel::unified_digitized_data>("UDD");
+    difference_collector diff(red_, differences_);
+
+    diff.set_location("EH");
+    diff.check("run_number", red_.get_run_id(), EH.get_id().get_run_number());
+    diff.check("event_number", red_.get_event_id(), EH.get_id().get_event_number());
+    diff.check("is_real", true, EH.is_real());
+
+    diff.set_location("UDD");
+    diff.check("run_id", red_.get_run_id(), UDD.get_run_id());
+    diff.check("event_id", red_.get_event_id(), UDD.get_event_id());
+    diff.check("reference_timestamp", red_.get_reference_time().get_ticks(), UDD.get_reference_timestamp());
+    if (red_.get_origin_trigger_ids() != UDD.get_origin_trigger_ids())
+      diff.add("origin_trigger_ids", to_text(red_.get_origin_trigger_ids()), to_text(UDD.get_origin_trigger_ids()));
+
+    // Calorimeter hits
+    const auto & red_calo_hits = red_.get_calo_hits();
+    diff.set_location("UDD.calo");
+    diff.check("size", red_calo_hits.size(), UDD.get_calorimeter_hits().size());
+    const channel_hit_index<snemo::datamodel::calorimeter_digitized_hit> udd_calo_index(UDD.get_calorimeter_hits(),
+                                                                                        channel_table::calorimeter());
+    for (const auto & red_calo_hit : red_calo_hits) {
+      diff.set_location("UDD.calo", hit_key_text(red_calo_hit.get_geom_id(), red_calo_hit.get_hit_id()));
+      const auto found = udd_calo_index.find(red_calo_hit.get_geom_id(), red_calo_hit.get_hit_id());
+      if (found == nullptr) {
+        diff.add("hit", "present", "missing");
+        continue;
+      }
+      const snemo::datamodel::calorimeter_digitized_hit & udd_calo_hit = *found;
+      diff.check("timestamp", red_calo_hit.get_reference_time().get_ticks(), udd_calo_hit.get_timestamp());
+      if (!no_wf_) diff.check_waveform(red_calo_hit.get_waveform(), udd_calo_hit.get_waveform(), udd_calo_hit.get_auxiliaries());
+      diff.check("low_threshold_only", red_calo_hit.is_low_threshold_only(), udd_calo_hit.is_low_threshold_only());
+      diff.check("high_threshold", red_calo_hit.is_high_threshold(), udd_calo_hit.is_high_threshold());
+      diff.check("fcr", red_calo_hit.get_fcr(), udd_calo_hit.get_fcr());
+      diff.check("lt_trigger_counter", red_calo_hit.get_lt_trigger_counter(), udd_calo_hit.get_lt_trigger_counter());
+      diff.check("lt_time_counter", red_calo_hit.get_lt_time_counter(), udd_calo_hit.get_lt_time_counter());
+      diff.check("fwmeas_baseline", red_calo_hit.get_fwmeas_baseline(), udd_calo_hit.get_fwmeas_baseline());
+      diff.check("fwmeas_peak_amplitude", red_calo_hit.get_fwmeas_peak_amplitude(), udd_calo_hit.get_fwmeas_peak_amplitude());
+      diff.check("fwmeas_peak_cell", red_calo_hit.get_fwmeas_peak_cell(), udd_calo_hit.get_fwmeas_peak_cell());
+      diff.check("fwmeas_charge", red_calo_hit.get_fwmeas_charge(), udd_calo_hit.get_fwmeas_charge());
+      diff.check("fwmeas_rising_cell", red_calo_hit.get_fwmeas_rising_cell(), udd_calo_hit.get_fwmeas_rising_cell());
+      diff.check("fwmeas_falling_cell", red_calo_hit.get_fwmeas_falling_cell(), udd_calo_hit.get_fwmeas_falling_cell());
+      diff.check_origin("origin", red_calo_hit.get_origin(), udd_calo_hit.get_origin());
+    }
+
+    // Tracker hits
+    const auto & red_tracker_hits = red_.get_tracker_hits();
+    diff.set_location("UDD.tracker");
+    diff.check("size", red_tracker_hits.size(), UDD.get_tracker_hits().size());
+    const channel_hit_index<snemo::datamodel::tracker_digitized_hit> udd_tracker_index(UDD.get_tracker_hits(),
+                                                                                       channel_table::tracker());
+    for (const auto & red_tracker_hit : red_tracker_hits) {
+      diff.set_location("UDD.tracker", hit_key_text(red_tracker_hit.get_geom_id(), red_tracker_hit.get_hit_id()));
+      const auto found = udd_tracker_index.find(red_tracker_hit.get_geom_id(), red_tracker_hit.get_hit_id());
+      if (found == nullptr) {
+        diff.add("hit", "present", "missing");
+        continue;
+      }
+      const snemo::datamodel::tracker_digitized_hit & udd_tracker_hit = *found;
+      const std::size_t ntimes = red_tracker_hit.get_times().size();
+      diff.check("times.size", ntimes, udd_tracker_hit.get_times().size());
+      if (ntimes != udd_tracker_hit.get_times().size()) continue;
+      for (std::size_t iggtime = 0; iggtime < ntimes; iggtime++) {
+        const auto & red_gg_times = red_tracker_hit.get_times()[iggtime];
+        const auto & udd_gg_times = udd_tracker_hit.get_times()[iggtime];
+        const std::string prefix = "times[" + to_text(iggtime) + "].";
+        for (std::size_t ianode = 0; ianode < 5; ianode++) {
+          const auto anode_index = anode_indexes[ianode];
+          const std::string anode = "[R" + to_text(ianode) + "]";
+          diff.check_origin(prefix + "anode_origin" + anode,
+                            red_gg_times.get_anode_origin(anode_index), udd_gg_times.get_anode_origin(anode_index));
+          diff.check(prefix + "anode_time" + anode,
+                     red_gg_times.get_anode_time(anode_index).get_ticks(), udd_gg_times.get_anode_time(anode_index));
+        }
+        diff.check_origin(prefix + "bottom_cathode_origin",
+                          red_gg_times.get_bottom_cathode_origin(), udd_gg_times.get_bottom_cathode_origin());
+        diff.check(prefix + "bottom_cathode_time",
+                   red_gg_times.get_bottom_cathode_time().get_ticks(), udd_gg_times.get_bottom_cathode_time());
+        diff.check_origin(prefix + "top_cathode_origin",
+                          red_gg_times.get_top_cathode_origin(), udd_gg_times.get_top_cathode_origin());
+        diff.check(prefix + "top_cathode_time",
+                   red_gg_times.get_top_cathode_time().get_ticks(), udd_gg_times.get_top_cathode_time());
+      }
+    }
+    return;
+  }
+
+  // Difference report writer
+
+  diff_report_writer::diff_report_writer(const std::string & filename_)
+    : _filename_(filename_)
+  {
+    _out_.open(_filename_.c_str(), std::ios::trunc);
+    DT_THROW_IF(!_out_, std::runtime_error, "Cannot create difference report '" << _filename_ << "'!");
+    _out_ << "#run\tevent\tbank\thit\tfield\tred\tudd\n";
+  }
+
+  void diff_report_writer::write(const std::vector<field_difference> & differences_)
+  {
+    for (const auto & difference : differences_) {
+      _out_ << difference.run_id << '\t' << difference.event_id << '\t'
+            << difference.bank << '\t' << (difference.hit_key.empty() ? "-" : difference.hit_key) << '\t'
+            << difference.field << '\t' << difference.red_value << '\t' << difference.udd_value << '\n';
+    }
+    _number_of_differences_ += differences_.size();
+  }
+
+  std::size_t diff_report_writer::get_number_of_differences() const
+  {
+    return _number_of_differences_;
+  }
+
+  void diff_report_writer::close()
+  {
+    if (!_out_.is_open()) return;
+    _out_.close();
+    DT_THROW_IF(_out_.fail(), std::runtime_error, "Failed to write difference report '" << _filename_ << "'!");
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,78 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/red_udd_diff.h
+///
+/// Field-level differences between a SNFEE RED event and the
+/// corresponding Falaise event record, and their streaming report file.
+
+#ifndef SNREDBRIDGE_RED_UDD_DIFF_H
+#define SNREDBRIDGE_RED_UDD_DIFF_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/things.h>
+
+// - SNFEE:
+#include <snfee/data/raw_event_data.h>
+
+namespace snredbridge {
+
+  /// \brief A field which differs between a RED event and its event record
+  struct field_difference
+  {
+    int32_t run_id = -1;   ///< Run ID of the RED event
+    int32_t event_id = -1; ///< Event ID of the RED event
+    std::string bank;      ///< Bank: "EH", "UDD", "UDD.calo" or "UDD.tracker"
+    std::string hit_key;   ///< Hit key "geom_id/hit_id" (empty for event level fields)
+    std::string field;     ///< Field name
+    std::string red_value; ///< Value in the RED event
+    std::string udd_value; ///< Value in the event record
+  };
+
+  /// Append the differences between a RED event and its event record
+  ///
+  /// The same fields as compare_red_event_record are checked. If no_wf_ is
+  /// set, the calorimeter waveforms are not compared.
+  void diff_red_event_record(const snfee::data::raw_event_data & red_,
+                             const datatools::things & event_record_,
+                             bool no_wf_,
+                             std::vector<field_difference> & differences_);
+
+  /// \brief Writer of a field-level difference report
+  ///
+  /// The report is a tab-separated text file with one line per difference
+  /// (run, event, bank, hit key, field, RED value, UDD value), written as
+  /// the differences are found.
+  class diff_report_writer
+  {
+  public:
+
+    /// Constructor: create the report file and write its header line
+    explicit diff_report_writer(const std::string & filename_);
+
+    /// Write differences
+    void write(const std::vector<field_difference> & differences_);
+
+    /// Return the number of written differences
+    std::size_t get_number_of_differences() const;
+
+    /// Flush and close the file
+    void close();
+
+  private:
+
+    std::string _filename_;               ///< File name
+    std::ofstream _out_;                  ///< Output stream
+    std::size_t _number_of_differences_ = 0; ///< Number of written differences
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RED_UDD_DIFF_H
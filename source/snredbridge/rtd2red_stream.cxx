@@ -0,0 +1,296 @@
+// This project:
+#include <snredbridge/rtd2red_stream.h>
+
+// Standard library:
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// - POSIX:
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// This project:
+#include <snredbridge/gzip_read_ahead.h>
+#include <snredbridge/parallel_gzip.h>
+
+extern char ** environ;
+
+namespace snredbridge {
+
+  namespace {
+
+    // Rank of the streams created by this process
+    std::atomic<unsigned int> stream_counter{0};
+
+    // Write a whole buffer to a file descriptor. Return false if the
+    // reader is gone
+    bool write_all(const int fd_, const char * data_, const std::size_t size_)
+    {
+      std::size_t offset = 0;
+      while (offset < size_) {
+        const ssize_t n = ::write(fd_, data_ + offset, size_ - offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        offset += static_cast<std::size_t>(n);
+      }
+      return true;
+    }
+
+  } // end of anonymous namespace
+
+  const char * const rtd2red_stream::red_file_token = "@RED_FILE@";
+
+  rtd2red_stream::rtd2red_stream(const config_type & config_)
+    : _config_(config_)
+  {
+    DT_THROW_IF(_config_.config_file.empty(), std::logic_error, "Missing RTD to RED builder configuration file!");
+    std::string builder_config;
+    {
+      std::ifstream input(_config_.config_file);
+      DT_THROW_IF(!input, std::runtime_error, "Cannot open RTD to RED builder configuration file '"
+                  << _config_.config_file << "'!");
+      std::ostringstream content;
+      content << input.rdbuf();
+      builder_config = content.str();
+    }
+
+    std::string pipe_dir = _config_.pipe_dir;
+    if (pipe_dir.empty()) {
+      const char * tmpdir = std::getenv("TMPDIR");
+      pipe_dir = (tmpdir != nullptr && tmpdir[0] != '\0') ? tmpdir : "/tmp";
+    }
+    const std::string stem = pipe_dir + "/snredbridge-" + std::to_string(::getpid())
+      + "-rtd2red-" + std::to_string(stream_counter++);
+    _red_pipe_ = stem + ".data";
+    _builder_pipe_ = _config_.red_copy.empty() ? _red_pipe_ : stem + "-builder.data";
+    _builder_config_ = stem + ".conf";
+
+    // The builder writes its RED output file into the pipe
+    const std::string token(red_file_token);
+    std::size_t ntokens = 0;
+    for (std::size_t pos = builder_config.find(token); pos != std::string::npos;
+         pos = builder_config.find(token, pos + _builder_pipe_.size())) {
+      builder_config.replace(pos, token.size(), _builder_pipe_);
+      ntokens++;
+    }
+    DT_THROW_IF(ntokens == 0, std::logic_error, "No '" << token << "' output file in RTD to RED builder configuration file '"
+                << _config_.config_file << "'!");
+    {
+      std::ofstream output(_builder_config_);
+      output << builder_config;
+      output.close();
+      DT_THROW_IF(!output, std::runtime_error, "Cannot write RTD to RED builder configuration file '" << _builder_config_ << "'!");
+    }
+
+    std::vector<std::string> pipes{_red_pipe_};
+    if (_builder_pipe_ != _red_pipe_) pipes.push_back(_builder_pipe_);
+    for (std::size_t ipipe = 0; ipipe < pipes.size(); ipipe++) {
+      ::unlink(pipes[ipipe].c_str());
+      if (::mkfifo(pipes[ipipe].c_str(), 0600) != 0) {
+        const int error = errno;
+        for (std::size_t jpipe = 0; jpipe < ipipe; jpipe++) ::unlink(pipes[jpipe].c_str());
+        ::unlink(_builder_config_.c_str());
+        DT_THROW(std::runtime_error, "Cannot create named pipe '" << pipes[ipipe] << "': " << std::strerror(error));
+      }
+    }
+
+    std::vector<std::string> args{_config_.program, "-c", _builder_config_};
+    std::vector<char *> argv;
+    for (auto & arg : args) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+    const int error = ::posix_spawnp(&_pid_, _config_.program.c_str(), nullptr, nullptr, argv.data(), environ);
+    if (error != 0) {
+      for (const auto & pipe : pipes) ::unlink(pipe.c_str());
+      ::unlink(_builder_config_.c_str());
+      DT_THROW(std::runtime_error, "Cannot start RTD to RED builder '" << _config_.program << "': " << std::strerror(error));
+    }
+    DT_LOG_DEBUG(_config_.logging, "Started '" << _config_.program << " -c " << _builder_config_
+                 << "' (PID " << _pid_ << ")");
+
+    _wait_thread_ = std::thread(&rtd2red_stream::_wait_loop_, this);
+    if (_builder_pipe_ != _red_pipe_) {
+      _copy_thread_ = std::thread(&rtd2red_stream::_copy_loop_, this);
+    } else {
+      _copy_done_ = true;
+    }
+  }
+
+  rtd2red_stream::~rtd2red_stream()
+  {
+    if (_closed_) return;
+    try {
+      close();
+    }
+    catch (...) {
+      // No exception from a destructor
+    }
+  }
+
+  const std::string & rtd2red_stream::get_filename() const
+  {
+    return _red_pipe_;
+  }
+
+  void rtd2red_stream::check_errors()
+  {
+    std::lock_guard<std::mutex> lock(_error_mutex_);
+    if (_error_) std::rethrow_exception(_error_);
+  }
+
+  void rtd2red_stream::close()
+  {
+    if (_closed_) return;
+    _closed_ = true;
+    // Without a copy thread, a builder still running here writes to a
+    // reader which is gone (or never came): it is stopped by a broken pipe
+    const bool stopped = !_builder_done_ && !_copy_thread_.joinable();
+    // Open and close the reader side of the pipe until the builder (or the
+    // copy thread) is done, so that a writer blocked in open() goes on
+    while (!(_copy_done_ && (_builder_done_ || !stopped))) {
+      const int fd = ::open(_red_pipe_.c_str(), O_RDONLY | O_NONBLOCK);
+      if (fd >= 0) ::close(fd);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (_copy_thread_.joinable()) _copy_thread_.join();
+    _stop_ = true;
+    _wait_thread_.join();
+    ::unlink(_red_pipe_.c_str());
+    if (_builder_pipe_ != _red_pipe_) ::unlink(_builder_pipe_.c_str());
+    ::unlink(_builder_config_.c_str());
+    check_errors();
+    if (WIFEXITED(_status_) && WEXITSTATUS(_status_) == 0) return;
+    std::ostringstream status;
+    if (WIFEXITED(_status_)) {
+      status << "exit status " << WEXITSTATUS(_status_);
+    } else if (WIFSIGNALED(_status_)) {
+      status << "signal " << WTERMSIG(_status_);
+    }
+    if (stopped) {
+      DT_LOG_WARNING(_config_.logging, "RTD to RED builder '" << _config_.program
+                     << "' stopped before the end of its RED stream (" << status.str() << ")");
+      return;
+    }
+    DT_THROW(std::runtime_error, "RTD to RED builder '" << _config_.program << "' failed ("
+             << status.str() << ")!");
+  }
+
+  void rtd2red_stream::_wait_loop_()
+  {
+    int status = 0;
+    pid_t pid = -1;
+    do {
+      pid = ::waitpid(_pid_, &status, 0);
+    } while (pid < 0 && errno == EINTR);
+    _status_ = status;
+    _builder_done_ = true;
+    // A builder failing before it opens its output leaves the reader (or
+    // the copy thread) blocked in open(): open and close the writer side
+    // of the pipe to give it an empty stream
+    while (!_stop_) {
+      const int fd = ::open(_builder_pipe_.c_str(), O_WRONLY | O_NONBLOCK);
+      if (fd >= 0) {
+        ::close(fd);
+        break;
+      }
+      if (errno != ENXIO && errno != EINTR) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  void rtd2red_stream::_copy_loop_()
+  {
+    // A reader closing its pipe early must not kill the process: the
+    // write then fails with EPIPE
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+    int input = -1;
+    int output = -1;
+    try {
+      // Blocks until the builder opens its output
+      do {
+        input = ::open(_builder_pipe_.c_str(), O_RDONLY);
+      } while (input < 0 && errno == EINTR);
+      DT_THROW_IF(input < 0, std::runtime_error, "Cannot open named pipe '" << _builder_pipe_ << "': " << std::strerror(errno));
+      // Blocks until the reader opens the pipe (or close() unblocks it)
+      do {
+        output = ::open(_red_pipe_.c_str(), O_WRONLY);
+      } while (output < 0 && errno == EINTR);
+      // The copy is completed even if the reader is gone
+      bool reader_gone = (output < 0);
+      std::unique_ptr<parallel_gzip_writer> gzip_copy;
+      std::FILE * copy = nullptr;
+      if (gzip_read_ahead::is_gzip_file(_config_.red_copy)) {
+        gzip_copy.reset(new parallel_gzip_writer(_config_.red_copy,
+                                                 _config_.copy_compression_level,
+                                                 _config_.copy_compression_threads));
+      } else {
+        copy = std::fopen(_config_.red_copy.c_str(), "wb");
+        DT_THROW_IF(copy == nullptr, std::runtime_error, "Cannot create RED file '" << _config_.red_copy << "'!");
+      }
+      bool copy_failed = false;
+      std::vector<char> buffer(256 * 1024);
+      while (true) {
+        const ssize_t n = ::read(input, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) continue;
+        DT_THROW_IF(n < 0, std::runtime_error, "Cannot read named pipe '" << _builder_pipe_ << "': " << std::strerror(errno));
+        if (n == 0) break;
+        const std::size_t size = static_cast<std::size_t>(n);
+        if (!reader_gone) reader_gone = !write_all(output, buffer.data(), size);
+        if (copy_failed) continue;
+        // On a copy error, the stream is still drained so that the builder
+        // and the reader can finish
+        try {
+          if (gzip_copy) {
+            gzip_copy->write(buffer.data(), size);
+          } else {
+            DT_THROW_IF(std::fwrite(buffer.data(), 1, size, copy) != size, std::runtime_error,
+                        "Cannot write RED file '" << _config_.red_copy << "'!");
+          }
+        }
+        catch (...) {
+          copy_failed = true;
+          std::lock_guard<std::mutex> lock(_error_mutex_);
+          if (!_error_) _error_ = std::current_exception();
+        }
+      }
+      if (output >= 0) ::close(output);
+      output = -1;
+      if (gzip_copy) {
+        gzip_copy->close();
+      } else {
+        const bool failed = (std::fclose(copy) != 0);
+        DT_THROW_IF(failed && !copy_failed, std::runtime_error, "Cannot write RED file '" << _config_.red_copy << "'!");
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(_error_mutex_);
+      if (!_error_) _error_ = std::current_exception();
+    }
+    if (output >= 0) ::close(output);
+    if (input >= 0) {
+      // Drain the builder output after an error so that it can finish
+      std::vector<char> buffer(64 * 1024);
+      ssize_t n = 0;
+      while ((n = ::read(input, buffer.data(), buffer.size())) != 0) {
+        if (n < 0 && errno != EINTR) break;
+      }
+      ::close(input);
+    }
+    _copy_done_ = true;
+  }
+
+} // end of namespace snredbridge
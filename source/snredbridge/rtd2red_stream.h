@@ -0,0 +1,102 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/rtd2red_stream.h
+///
+/// RED stream produced by a SNFEE RTD to RED event builder running next to
+/// the conversion, without an intermediate RED file.
+
+#ifndef SNREDBRIDGE_RTD2RED_STREAM_H
+#define SNREDBRIDGE_RTD2RED_STREAM_H
+
+// Standard library:
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// - POSIX:
+#include <sys/types.h>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+namespace snredbridge {
+
+  /// \brief Run the SNFEE RTD to RED builder and stream its RED output to the reader
+  ///
+  /// The builder program (snfee-rtd2red) is started with a copy of its
+  /// configuration file where each occurrence of the "@RED_FILE@" token is
+  /// replaced by a named pipe with the ".data" extension (uncompressed
+  /// RED). The RED reader opens the pipe given by get_filename() and the
+  /// events are converted as they are built: the RED data are neither
+  /// compressed, written, read back nor decompressed.
+  ///
+  /// Optionally, a copy thread between the builder and the reader also
+  /// saves the RED stream to a file (gzip-compressed by a
+  /// parallel_gzip_writer if its name ends with ".gz"). The copy is then
+  /// complete even if the reader stops early.
+  ///
+  /// The reader must be closed before this object.
+  class rtd2red_stream
+  {
+  public:
+
+    /// Configuration
+    struct config_type
+    {
+      std::string program = "snfee-rtd2red"; ///< RTD to RED builder program (searched in PATH)
+      std::string config_file;               ///< Builder configuration, with the "@RED_FILE@" token as RED output file
+      std::string red_copy;                  ///< Copy of the RED stream (empty: no copy)
+      int copy_compression_level = 6;        ///< Gzip level of a ".gz" copy
+      std::size_t copy_compression_threads = 1; ///< Number of compression threads of a ".gz" copy
+      std::string pipe_dir;                  ///< Directory of the named pipes (empty: $TMPDIR or /tmp)
+      datatools::logger::priority logging = datatools::logger::PRIO_WARNING; ///< Logging priority
+    };
+
+    /// Token of the builder configuration replaced by the RED output pipe
+    static const char * const red_file_token;
+
+    /// Constructor: create the named pipes and start the builder
+    explicit rtd2red_stream(const config_type & config_);
+
+    /// Destructor: stop the builder if needed and remove the named pipes
+    ~rtd2red_stream();
+
+    /// Return the name of the RED file to read
+    const std::string & get_filename() const;
+
+    /// Rethrow the error of the copy thread, if any
+    void check_errors();
+
+    /// Wait for the builder (stopping it if the reader is gone before the
+    /// end of the stream), remove the named pipes and report failures
+    void close();
+
+  private:
+
+    void _wait_loop_();
+
+    void _copy_loop_();
+
+    config_type _config_;                   ///< Configuration
+    std::string _red_pipe_;                 ///< Pipe read by the RED reader
+    std::string _builder_pipe_;             ///< Pipe written by the builder
+    std::string _builder_config_;           ///< Configuration file given to the builder
+    pid_t _pid_ = -1;                       ///< Process ID of the builder
+    int _status_ = 0;                       ///< Exit status of the builder
+    std::thread _wait_thread_;              ///< Thread waiting for the builder
+    std::thread _copy_thread_;              ///< Thread copying the stream (optional)
+    std::atomic<bool> _builder_done_{false}; ///< The builder has exited
+    std::atomic<bool> _copy_done_{false};   ///< The copy thread is done
+    std::atomic<bool> _stop_{false};        ///< Stop request
+    std::mutex _error_mutex_;               ///< Protection of the error
+    std::exception_ptr _error_;             ///< Error of the copy thread
+    bool _closed_ = false;                  ///< The stream is closed
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RTD2RED_STREAM_H
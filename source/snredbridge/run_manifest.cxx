@@ -0,0 +1,72 @@
+// This project:
+#include <snredbridge/run_manifest.h>
+
+// Standard library:
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/utils.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    double parse_time(const std::string & text_, const std::string & filename_,
+                      const std::size_t line_, const char * column_)
+    {
+      char * end = nullptr;
+      const double value = std::strtod(text_.c_str(), &end);
+      DT_THROW_IF(end == text_.c_str() || *end != '\0', std::logic_error,
+                  "Invalid " << column_ << " '" << text_ << "' at line " << line_
+                  << " of batch manifest '" << filename_ << "'!");
+      return value;
+    }
+
+  } // end of anonymous namespace
+
+  std::vector<run_manifest_entry> load_run_manifest(const std::string & filename_)
+  {
+    std::string filename = filename_;
+    DT_THROW_IF(!datatools::fetch_path_with_env(filename), std::logic_error,
+                "Cannot resolve batch manifest file name '" << filename_ << "'!");
+    std::ifstream manifest(filename);
+    DT_THROW_IF(!manifest, std::runtime_error, "Cannot open batch manifest '" << filename << "'!");
+    std::vector<run_manifest_entry> entries;
+    std::set<std::string> outputs;
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(manifest, line)) {
+      line_number++;
+      const std::size_t first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos || line[first] == '#') continue;
+      std::istringstream columns(line);
+      std::vector<std::string> fields;
+      std::string field;
+      while (columns >> field) fields.push_back(field);
+      DT_THROW_IF(fields.size() < 3 || fields.size() > 4, std::logic_error,
+                  "Expected 'INPUT OUTPUT SYNC_TIME [END_TIME]' at line " << line_number
+                  << " of batch manifest '" << filename << "'!");
+      run_manifest_entry entry;
+      entry.input = fields[0];
+      entry.output = fields[1];
+      entry.sync_time = parse_time(fields[2], filename, line_number, "sync time");
+      if (fields.size() == 4) {
+        entry.has_end_time = true;
+        entry.end_time = parse_time(fields[3], filename, line_number, "end time");
+      }
+      entry.line = line_number;
+      DT_THROW_IF(!outputs.insert(entry.output).second, std::logic_error,
+                  "Output file '" << entry.output << "' at line " << line_number
+                  << " of batch manifest '" << filename << "' is already used!");
+      entries.push_back(entry);
+    }
+    return entries;
+  }
+
+} // end of namespace snredbridge
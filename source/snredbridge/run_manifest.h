@@ -0,0 +1,39 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/run_manifest.h
+///
+/// List of the runs converted by a red_bridge batch.
+
+#ifndef SNREDBRIDGE_RUN_MANIFEST_H
+#define SNREDBRIDGE_RUN_MANIFEST_H
+
+// Standard library:
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace snredbridge {
+
+  /// \brief Run of a batch manifest
+  struct run_manifest_entry
+  {
+    std::string input;        ///< RED input file(s): name, shell wildcards or @LIST_FILE
+    std::string output;       ///< UDD output file
+    double sync_time = 0;     ///< UNIX time (s) of the run TDC=0 reference
+    bool has_end_time = false; ///< The end time is set
+    double end_time = 0;      ///< Crop time (s from the sync time)
+    std::size_t line = 0;     ///< Line number in the manifest
+  };
+
+  /// Load a batch manifest
+  ///
+  /// Each non-empty line which does not start with '#' describes a run
+  /// with whitespace-separated columns:
+  ///
+  ///   INPUT OUTPUT SYNC_TIME [END_TIME]
+  ///
+  /// Throws on malformed lines and if an output file is used twice.
+  std::vector<run_manifest_entry> load_run_manifest(const std::string & filename_);
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RUN_MANIFEST_H
@@ -0,0 +1,165 @@
+// This project:
+#include <snredbridge/run_metrics.h>
+
+// Standard library:
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+// - Falaise:
+#include <falaise/snemo/datamodels/unified_digitized_data.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    // Format a duration in seconds as HH:MM:SS
+    std::string format_hms(const double seconds_)
+    {
+      long total = (seconds_ > 0) ? static_cast<long>(seconds_ + 0.5) : 0;
+      char text[32];
+      std::snprintf(text, sizeof(text), "%02ld:%02ld:%02ld", total / 3600, (total / 60) % 60, total % 60);
+      return std::string(text);
+    }
+
+    void print_json_stage(std::ostream & out_, const std::string & name_,
+                          const stage_timer & timer_, const std::size_t nevents_, const bool last_)
+    {
+      const double seconds = timer_.get_seconds();
+      out_ << "    \"" << name_ << "\": {"
+           << "\"seconds\": " << seconds
+           << ", \"calls\": " << timer_.get_number_of_calls()
+           << ", \"us_per_event\": " << (nevents_ > 0 ? 1.e6 * seconds / nevents_ : 0.0)
+           << "}" << (last_ ? "" : ",") << "\n";
+    }
+
+  } // end of anonymous namespace
+
+  // Stage timer
+
+  void stage_timer::add(const clock_type::duration & duration_, const std::size_t ncalls_)
+  {
+    _nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(duration_).count();
+    _ncalls_ += ncalls_;
+  }
+
+  double stage_timer::get_seconds() const
+  {
+    return 1.e-9 * _nanoseconds_.load();
+  }
+
+  std::size_t stage_timer::get_number_of_calls() const
+  {
+    return _ncalls_.load();
+  }
+
+  // Run metrics
+
+  run_metrics::run_metrics()
+    : start_time(stage_timer::clock_type::now())
+  {
+  }
+
+  void run_metrics::add_event_record(const datatools::things & event_record_)
+  {
+    const auto & UDD = event_record_.get<snemo::datamodel::unified_digitized_data>("UDD");
+    std::size_t nsamples = 0;
+    for (const auto & udd_calo_hdl : UDD.get_calorimeter_hits()) {
+      nsamples += udd_calo_hdl->get_waveform().size();
+    }
+    std::size_t ntimes = 0;
+    for (const auto & udd_tracker_hdl : UDD.get_tracker_hits()) {
+      ntimes += udd_tracker_hdl->get_times().size();
+    }
+    calo_hits += UDD.get_calorimeter_hits().size();
+    tracker_hits += UDD.get_tracker_hits().size();
+    waveform_samples += nsamples;
+    tracker_gg_times += ntimes;
+  }
+
+  double run_metrics::get_elapsed_seconds() const
+  {
+    return std::chrono::duration<double>(stage_timer::clock_type::now() - start_time).count();
+  }
+
+  void run_metrics::print_json(std::ostream & out_) const
+  {
+    const double elapsed = get_elapsed_seconds();
+    const std::size_t nevents_in = events_in.load();
+    const std::size_t nevents_out = events_out.load();
+    out_ << "{\n";
+    out_ << "  \"wall_seconds\": " << elapsed << ",\n";
+    out_ << "  \"threads\": " << nthreads << ",\n";
+    out_ << "  \"events_per_second\": " << (elapsed > 0 ? nevents_out / elapsed : 0.0) << ",\n";
+    out_ << "  \"stages\": {\n";
+    print_json_stage(out_, "read", read, nevents_in, false);
+    print_json_stage(out_, "convert", convert, nevents_in, false);
+    print_json_stage(out_, "validate", validate, nevents_in, false);
+    print_json_stage(out_, "write", write, nevents_out, true);
+    out_ << "  },\n";
+    out_ << "  \"counters\": {\n";
+    out_ << "    \"events_in\": " << nevents_in << ",\n";
+    out_ << "    \"events_out\": " << nevents_out << ",\n";
+    out_ << "    \"events_rejected\": " << events_rejected.load() << ",\n";
+    out_ << "    \"calo_hits\": " << calo_hits.load() << ",\n";
+    out_ << "    \"tracker_hits\": " << tracker_hits.load() << ",\n";
+    out_ << "    \"waveform_samples\": " << waveform_samples.load() << ",\n";
+    out_ << "    \"tracker_gg_times\": " << tracker_gg_times.load() << ",\n";
+    out_ << "    \"bytes_in\": " << bytes_in << ",\n";
+    out_ << "    \"bytes_out\": " << bytes_out << "\n";
+    out_ << "  }\n";
+    out_ << "}\n";
+  }
+
+  void run_metrics::store_json(const std::string & filename_) const
+  {
+    std::ofstream out(filename_.c_str());
+    DT_THROW_IF(!out, std::runtime_error, "Cannot create report file '" << filename_ << "'!");
+    print_json(out);
+    out.close();
+    DT_THROW_IF(out.fail(), std::runtime_error, "Failed to write report file '" << filename_ << "'!");
+  }
+
+  // Progress reporter
+
+  progress_reporter::progress_reporter(const double period_seconds_,
+                                       const std::size_t expected_events_,
+                                       std::ostream & out_)
+    : _period_(std::chrono::duration_cast<stage_timer::clock_type::duration>(
+                 std::chrono::duration<double>(period_seconds_ > 0 ? period_seconds_ : 0.0))),
+      _expected_events_(expected_events_),
+      _out_(out_),
+      _start_(stage_timer::clock_type::now()),
+      _next_report_(_start_ + _period_)
+  {
+  }
+
+  void progress_reporter::set_label(const std::string & label_)
+  {
+    _label_ = label_;
+  }
+
+  void progress_reporter::print(const std::size_t processed_events_,
+                                const std::size_t stored_events_,
+                                const stage_timer::clock_type::time_point & now_)
+  {
+    const double elapsed = std::chrono::duration<double>(now_ - _start_).count();
+    const double rate = (elapsed > 0) ? processed_events_ / elapsed : 0.0;
+    // One write per line, so that the reports of concurrent runs do not mix
+    std::ostringstream line;
+    line << "Progress";
+    if (!_label_.empty()) line << " [" << _label_ << "]";
+    line << " : " << processed_events_;
+    if (_expected_events_ > 0) line << "/" << _expected_events_;
+    line << " events, " << stored_events_ << " stored, " << static_cast<long>(rate) << " events/s, elapsed " << format_hms(elapsed);
+    if (_expected_events_ > processed_events_ && rate > 0)
+      line << ", ETA " << format_hms((_expected_events_ - processed_events_) / rate);
+    line << '\n';
+    _out_ << line.str() << std::flush;
+  }
+
+} // end of namespace snredbridge
@@ -0,0 +1,151 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/run_metrics.h
+///
+/// Per-stage timers, event/hit/byte counters, periodic progress and
+/// final JSON report of a conversion run.
+
+#ifndef SNREDBRIDGE_RUN_METRICS_H
+#define SNREDBRIDGE_RUN_METRICS_H
+
+// Standard library:
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/things.h>
+
+namespace snredbridge {
+
+  /// \brief Cumulated time and number of calls of a processing stage
+  ///
+  /// Thread-safe: the workers of a stage may add their timings concurrently.
+  class stage_timer
+  {
+  public:
+
+    typedef std::chrono::steady_clock clock_type;
+
+    /// Add a timing
+    void add(const clock_type::duration & duration_, const std::size_t ncalls_ = 1);
+
+    /// Return the cumulated time in seconds
+    double get_seconds() const;
+
+    /// Return the number of calls
+    std::size_t get_number_of_calls() const;
+
+  private:
+
+    std::atomic<int64_t> _nanoseconds_{0}; ///< Cumulated time
+    std::atomic<std::size_t> _ncalls_{0};  ///< Number of calls
+
+  };
+
+  /// \brief Time a scope and add it to a stage timer (if any)
+  class scoped_stage_timer
+  {
+  public:
+
+    explicit scoped_stage_timer(stage_timer * timer_)
+      : _timer_(timer_)
+    {
+      if (_timer_ != nullptr) _start_ = stage_timer::clock_type::now();
+    }
+
+    ~scoped_stage_timer()
+    {
+      if (_timer_ != nullptr) _timer_->add(stage_timer::clock_type::now() - _start_);
+    }
+
+  private:
+
+    stage_timer * _timer_;                       ///< Target timer
+    stage_timer::clock_type::time_point _start_; ///< Start time
+
+  };
+
+  /// \brief Metrics of a conversion run
+  struct run_metrics
+  {
+    run_metrics();
+
+    /// Count the hits and waveform samples of a converted event record
+    void add_event_record(const datatools::things & event_record_);
+
+    /// Return the elapsed wall time in seconds since construction
+    double get_elapsed_seconds() const;
+
+    /// Write the JSON report
+    void print_json(std::ostream & out_) const;
+
+    /// Write the JSON report to a file
+    void store_json(const std::string & filename_) const;
+
+    stage_timer read;     ///< RED loading (reading and decompression)
+    stage_timer convert;  ///< RED to UDD conversion
+    stage_timer validate; ///< Comparison of the event records with the RED events
+    stage_timer write;    ///< Event record serialization and compression
+
+    std::atomic<std::size_t> events_in{0};          ///< Loaded RED events
+    std::atomic<std::size_t> events_out{0};         ///< Stored event records
+    std::atomic<std::size_t> events_rejected{0};    ///< RED events rejected by the selection
+    std::atomic<std::size_t> calo_hits{0};          ///< Converted calorimeter hits
+    std::atomic<std::size_t> tracker_hits{0};       ///< Converted tracker hits
+    std::atomic<std::size_t> waveform_samples{0};   ///< Converted waveform samples
+    std::atomic<std::size_t> tracker_gg_times{0};   ///< Converted GG times
+    int64_t bytes_in = 0;                           ///< Size of the read RED files
+    int64_t bytes_out = 0;                          ///< Size of the written UDD files
+    std::size_t nthreads = 1;                       ///< Number of threads
+
+    stage_timer::clock_type::time_point start_time; ///< Start of the run
+  };
+
+  /// \brief Periodic progress printer
+  ///
+  /// Prints the number of processed RED events, the number of stored event
+  /// records, the rate and, if the expected number of RED events is known,
+  /// an estimated time of arrival.
+  class progress_reporter
+  {
+  public:
+
+    /// Constructor. A zero period disables the progress reports
+    progress_reporter(const double period_seconds_, const std::size_t expected_events_,
+                      std::ostream & out_ = std::clog);
+
+    /// Set the label printed in the reports (e.g. the run of a batch)
+    void set_label(const std::string & label_);
+
+    /// Report the numbers of processed RED events and of stored event
+    /// records, printing if the period has elapsed
+    void update(const std::size_t processed_events_, const std::size_t stored_events_)
+    {
+      if (_period_.count() == 0) return;
+      const auto now = stage_timer::clock_type::now();
+      if (now < _next_report_) return;
+      _next_report_ = now + _period_;
+      print(processed_events_, stored_events_, now);
+    }
+
+  private:
+
+    void print(const std::size_t processed_events_, const std::size_t stored_events_,
+               const stage_timer::clock_type::time_point & now_);
+
+    stage_timer::clock_type::duration _period_;           ///< Report period
+    std::size_t _expected_events_;                        ///< Expected number of RED events (0: unknown)
+    std::ostream & _out_;                                 ///< Output stream
+    std::string _label_;                                  ///< Label of the reports
+    stage_timer::clock_type::time_point _start_;          ///< Start time
+    stage_timer::clock_type::time_point _next_report_;    ///< Time of the next report
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_RUN_METRICS_H
@@ -0,0 +1,290 @@
+// This project:
+#include <snredbridge/udd_index.h>
+
+// Standard library:
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/brio/reader.h>
+#include <bayeux/datatools/io_factory.h>
+#include <bayeux/datatools/logger.h>
+#include <bayeux/datatools/properties.h>
+// - Falaise:
+#include <falaise/snemo/datamodels/event_header.h>
+#include <falaise/snemo/datamodels/unified_digitized_data.h>
+
+// This project:
+#include <snredbridge/file_utils.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    const char INDEX_MAGIC[8] = {'S', 'N', 'R', 'B', 'U', 'D', 'D', 'I'};
+    const uint32_t INDEX_VERSION = 1;
+
+    /// Label of the brio store of the event records written by dpp::output_module
+    const char * const BRIO_EVENT_RECORD_STORE = "ER";
+
+    template <typename T>
+    void write_pod(std::ostream & out_, const T & value_)
+    {
+      out_.write(reinterpret_cast<const char *>(&value_), sizeof(T));
+    }
+
+    template <typename T>
+    void read_pod(std::istream & in_, T & value_)
+    {
+      in_.read(reinterpret_cast<char *>(&value_), sizeof(T));
+    }
+
+    /// Return the number of bytes from the current position to the end of a stream
+    uint64_t remaining_bytes(std::istream & in_)
+    {
+      const std::streamoff position = in_.tellg();
+      in_.seekg(0, std::ios::end);
+      const std::streamoff end = in_.tellg();
+      in_.seekg(position);
+      return (in_ && end > position) ? static_cast<uint64_t>(end - position) : 0;
+    }
+
+    bool is_brio_file(const std::string & filename_)
+    {
+      return filename_.size() > 5 && filename_.compare(filename_.size() - 5, 5, ".brio") == 0;
+    }
+
+    bool entry_time_less(const udd_index::entry & e1_, const udd_index::entry & e2_)
+    {
+      return e1_.seconds < e2_.seconds || (e1_.seconds == e2_.seconds && e1_.picoseconds < e2_.picoseconds);
+    }
+
+    bool entry_event_less(const udd_index::entry & e1_, const udd_index::entry & e2_)
+    {
+      return e1_.run_id < e2_.run_id || (e1_.run_id == e2_.run_id && e1_.event_id < e2_.event_id);
+    }
+
+  } // end of anonymous namespace
+
+  double udd_index::entry::get_time() const
+  {
+    return static_cast<double>(seconds) + 1E-12 * static_cast<double>(picoseconds);
+  }
+
+  std::string udd_index::default_filename(const std::string & udd_filename_)
+  {
+    return udd_filename_ + ".idx";
+  }
+
+  udd_index::entry udd_index::make_entry(const datatools::things & event_record_,
+                                         const uint64_t record_rank_)
+  {
+    entry e;
+    e.record_rank = record_rank_;
+    if (event_record_.has("EH")) {
+      const auto & EH = event_record_.get<snemo::datamodel::event_header>("EH");
+      e.seconds = EH.get_timestamp().get_seconds();
+      e.picoseconds = EH.get_timestamp().get_picoseconds();
+    }
+    if (event_record_.has("UDD")) {
+      const auto & UDD = event_record_.get<snemo::datamodel::unified_digitized_data>("UDD");
+      e.run_id = UDD.get_run_id();
+      e.event_id = UDD.get_event_id();
+      e.reference_ticks = UDD.get_reference_timestamp();
+      e.calo_hits = static_cast<uint32_t>(UDD.get_calorimeter_hits().size());
+      e.tracker_hits = static_cast<uint32_t>(UDD.get_tracker_hits().size());
+      for (const auto & udd_calo_hdl : UDD.get_calorimeter_hits()) {
+        if (!udd_calo_hdl.get().get_waveform().empty()) {
+          e.flags |= FLAG_WAVEFORM;
+          break;
+        }
+      }
+    }
+    return e;
+  }
+
+  void udd_index::add(const entry & entry_)
+  {
+    if (!_entries_.empty()) {
+      if (entry_time_less(entry_, _entries_.back())) _time_sorted_ = false;
+      if (entry_event_less(entry_, _entries_.back())) _events_sorted_ = false;
+    }
+    _entries_.push_back(entry_);
+  }
+
+  void udd_index::load(const std::string & index_filename_)
+  {
+    std::ifstream in(index_filename_, std::ios::binary);
+    DT_THROW_IF(!in, std::runtime_error, "Cannot open UDD index file '" << index_filename_ << "'!");
+    char magic[sizeof(INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    uint32_t version = 0;
+    read_pod(in, version);
+    DT_THROW_IF(!in || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 || version != INDEX_VERSION,
+                std::runtime_error, "'" << index_filename_ << "' is not a UDD index file (version " << INDEX_VERSION << ")!");
+    uint64_t nentries = 0;
+    read_pod(in, nentries);
+    DT_THROW_IF(!in || nentries > remaining_bytes(in) / sizeof(entry),
+                std::runtime_error, "Truncated UDD index file '" << index_filename_ << "'!");
+    _entries_.resize(nentries);
+    if (nentries > 0) in.read(reinterpret_cast<char *>(_entries_.data()), nentries * sizeof(entry));
+    DT_THROW_IF(!in, std::runtime_error, "Truncated UDD index file '" << index_filename_ << "'!");
+    _time_sorted_ = std::is_sorted(_entries_.begin(), _entries_.end(), entry_time_less);
+    _events_sorted_ = std::is_sorted(_entries_.begin(), _entries_.end(), entry_event_less);
+  }
+
+  void udd_index::store(const std::string & index_filename_) const
+  {
+    // Private temporary file, replaced atomically (see red_index::store)
+    const std::string tmp_filename = make_temporary_filename(index_filename_);
+    try {
+      {
+        std::ofstream out(tmp_filename, std::ios::binary | std::ios::trunc);
+        DT_THROW_IF(!out, std::runtime_error, "Cannot create UDD index file '" << tmp_filename << "'!");
+        out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        write_pod(out, INDEX_VERSION);
+        write_pod(out, static_cast<uint64_t>(_entries_.size()));
+        if (!_entries_.empty()) out.write(reinterpret_cast<const char *>(_entries_.data()), _entries_.size() * sizeof(entry));
+        out.close();
+        DT_THROW_IF(!out, std::runtime_error, "Cannot write UDD index file '" << tmp_filename << "'!");
+      }
+      DT_THROW_IF(std::rename(tmp_filename.c_str(), index_filename_.c_str()) != 0,
+                  std::runtime_error, "Cannot rename '" << tmp_filename << "' to '" << index_filename_ << "'!");
+    }
+    catch (...) {
+      std::remove(tmp_filename.c_str());
+      throw;
+    }
+  }
+
+  std::size_t udd_index::size() const
+  {
+    return _entries_.size();
+  }
+
+  bool udd_index::empty() const
+  {
+    return _entries_.empty();
+  }
+
+  const udd_index::entry & udd_index::get_entry(const std::size_t ientry_) const
+  {
+    DT_THROW_IF(ientry_ >= _entries_.size(), std::range_error,
+                "Invalid UDD index entry " << ientry_ << " (" << _entries_.size() << " entries)!");
+    return _entries_[ientry_];
+  }
+
+  const std::vector<udd_index::entry> & udd_index::get_entries() const
+  {
+    return _entries_;
+  }
+
+  std::size_t udd_index::find_event(const int32_t run_id_, const int32_t event_id_) const
+  {
+    entry key;
+    key.run_id = run_id_;
+    key.event_id = event_id_;
+    if (_events_sorted_) {
+      const auto found = std::lower_bound(_entries_.begin(), _entries_.end(), key, entry_event_less);
+      if (found != _entries_.end() && found->run_id == run_id_ && found->event_id == event_id_) {
+        return static_cast<std::size_t>(found - _entries_.begin());
+      }
+      return _entries_.size();
+    }
+    const auto found = std::find_if(_entries_.begin(), _entries_.end(),
+                                    [&](const entry & e) { return e.run_id == run_id_ && e.event_id == event_id_; });
+    return static_cast<std::size_t>(found - _entries_.begin());
+  }
+
+  std::size_t udd_index::lower_bound_time(const double time_) const
+  {
+    if (_time_sorted_) {
+      const auto found = std::lower_bound(_entries_.begin(), _entries_.end(), time_,
+                                          [](const entry & e, const double t) { return e.get_time() < t; });
+      return static_cast<std::size_t>(found - _entries_.begin());
+    }
+    const auto found = std::find_if(_entries_.begin(), _entries_.end(),
+                                    [&](const entry & e) { return e.get_time() >= time_; });
+    return static_cast<std::size_t>(found - _entries_.begin());
+  }
+
+  udd_indexed_reader::udd_indexed_reader(const std::string & udd_filename_,
+                                         const std::string & index_filename_)
+    : _filename_(udd_filename_)
+  {
+    _index_.load(index_filename_.empty() ? udd_index::default_filename(udd_filename_) : index_filename_);
+    if (is_brio_file(_filename_)) {
+      _brio_reader_.reset(new brio::reader(_filename_));
+      const int nentries = _brio_reader_->get_number_of_entries(BRIO_EVENT_RECORD_STORE);
+      DT_THROW_IF(nentries < 0 || static_cast<std::size_t>(nentries) != _index_.size(), std::runtime_error,
+                  "UDD file '" << _filename_ << "' has " << nentries << " event records but its index has "
+                  << _index_.size() << " entries!");
+    } else {
+      _rewind_();
+    }
+  }
+
+  udd_indexed_reader::~udd_indexed_reader()
+  {
+  }
+
+  const udd_index & udd_indexed_reader::get_index() const
+  {
+    return _index_;
+  }
+
+  void udd_indexed_reader::_rewind_()
+  {
+    _reader_.reset(new datatools::data_reader(_filename_, datatools::using_multi_archives));
+    _next_rank_ = 0;
+  }
+
+  void udd_indexed_reader::load_entry(const std::size_t ientry_, datatools::things & event_record_)
+  {
+    const uint64_t rank = _index_.get_entry(ientry_).record_rank;
+    event_record_.clear();
+    if (_brio_reader_) {
+      _brio_reader_->load(event_record_, BRIO_EVENT_RECORD_STORE, static_cast<int64_t>(rank));
+      return;
+    }
+    // Serialization streams can only be read forward
+    if (rank < _next_rank_) _rewind_();
+    while (_reader_->has_record_tag()) {
+      if (!_reader_->record_tag_is(datatools::things::SERIAL_TAG)) {
+        // Metadata stored by the output module
+        DT_THROW_IF(!_reader_->record_tag_is(datatools::properties::SERIAL_TAG), std::logic_error,
+                    "Unexpected record tag '" << _reader_->get_record_tag() << "' in '" << _filename_ << "'!");
+        datatools::properties metadata;
+        _reader_->load(metadata);
+        continue;
+      }
+      _reader_->load(event_record_);
+      if (_next_rank_++ == rank) return;
+      event_record_.clear();
+    }
+    DT_THROW(std::runtime_error, "UDD file '" << _filename_ << "' has no event record " << rank
+             << " (out of date index?)!");
+  }
+
+  bool udd_indexed_reader::load_event(const int32_t run_id_, const int32_t event_id_,
+                                      datatools::things & event_record_)
+  {
+    const std::size_t ientry = _index_.find_event(run_id_, event_id_);
+    if (ientry == _index_.size()) return false;
+    load_entry(ientry, event_record_);
+    return true;
+  }
+
+  bool udd_indexed_reader::load_at_time(const double time_, datatools::things & event_record_)
+  {
+    const std::size_t ientry = _index_.lower_bound_time(time_);
+    if (ientry == _index_.size()) return false;
+    load_entry(ientry, event_record_);
+    return true;
+  }
+
+} // end of namespace snredbridge
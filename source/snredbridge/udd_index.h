@@ -0,0 +1,151 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/udd_index.h
+///
+/// Sidecar index of the event records of a UDD file, and reader seeking
+/// event records through it.
+
+#ifndef SNREDBRIDGE_UDD_INDEX_H
+#define SNREDBRIDGE_UDD_INDEX_H
+
+// Standard library:
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/things.h>
+
+namespace brio {
+  class reader;
+}
+
+namespace datatools {
+  class data_reader;
+}
+
+namespace snredbridge {
+
+  /// \brief Index of the event records of a UDD file, in file order
+  ///
+  /// Each entry gives the rank of the event record in the file, its
+  /// run/event ids, its EH timestamp, UDD reference timestamp, numbers of
+  /// hits and whether its calorimeter hits have waveforms. It is written
+  /// by red_bridge (--write-index) next to each UDD output file.
+  ///
+  /// The index file is a binary file in host byte order, made of a header
+  /// (magic, version, number of entries) followed by fixed size entries.
+  class udd_index
+  {
+  public:
+
+    /// Index entry
+    struct entry
+    {
+      uint64_t record_rank = 0;          ///< Rank of the event record in the file
+      int32_t run_id = -1;               ///< Run ID
+      int32_t event_id = -1;             ///< Event ID
+      int64_t seconds = 0;               ///< Seconds of the EH timestamp (UNIX time)
+      int64_t picoseconds = 0;           ///< Picoseconds of the EH timestamp
+      int64_t reference_ticks = 0;       ///< UDD reference timestamp (ticks)
+      uint32_t calo_hits = 0;            ///< Number of calorimeter hits
+      uint32_t tracker_hits = 0;         ///< Number of tracker hits
+      uint32_t flags = 0;                ///< Flags (see FLAG_WAVEFORM)
+      uint32_t reserved = 0;             ///< Padding (unused)
+
+      /// Return the EH time in seconds
+      double get_time() const;
+    };
+
+    /// Entry flags
+    static const uint32_t FLAG_WAVEFORM = 0x1;  ///< Calorimeter waveforms are stored
+
+    /// Return the index file name associated to a UDD file
+    static std::string default_filename(const std::string & udd_filename_);
+
+    /// Build the entry of an event record
+    static entry make_entry(const datatools::things & event_record_,
+                            const uint64_t record_rank_);
+
+    /// Append an entry
+    void add(const entry & entry_);
+
+    /// Load the index from an index file
+    void load(const std::string & index_filename_);
+
+    /// Store the index in an index file
+    void store(const std::string & index_filename_) const;
+
+    /// Return the number of entries
+    std::size_t size() const;
+
+    /// Check if the index is empty
+    bool empty() const;
+
+    /// Return an entry
+    const entry & get_entry(const std::size_t ientry_) const;
+
+    /// Return all the entries
+    const std::vector<entry> & get_entries() const;
+
+    /// Return the rank of the entry of an event, or size() if there is none
+    std::size_t find_event(const int32_t run_id_, const int32_t event_id_) const;
+
+    /// Return the rank of the first entry with an EH time greater or equal
+    /// to time_ (s), or size() if there is none
+    std::size_t lower_bound_time(const double time_) const;
+
+  private:
+
+    std::vector<entry> _entries_;  ///< Entries in file order
+    bool _time_sorted_ = true;     ///< EH timestamps are in increasing order
+    bool _events_sorted_ = true;   ///< (run, event) IDs are in increasing order
+
+  };
+
+  /// \brief Random access to the event records of a UDD file through its index
+  ///
+  /// Brio files are read entry by entry, so an event record is loaded
+  /// directly. The other formats (".data", ".data.gz"...) are single
+  /// serialization streams which can only be read forward: the event
+  /// records before the requested one are skipped (read from the current
+  /// position, or from the start of the file to go back).
+  class udd_indexed_reader
+  {
+  public:
+
+    /// Constructor: load the index (default: next to the UDD file) and open the file
+    explicit udd_indexed_reader(const std::string & udd_filename_,
+                                const std::string & index_filename_ = "");
+
+    /// Destructor
+    ~udd_indexed_reader();
+
+    /// Return the index
+    const udd_index & get_index() const;
+
+    /// Load the event record of an index entry
+    void load_entry(const std::size_t ientry_, datatools::things & event_record_);
+
+    /// Load the event record of an event. Return false if it is not in the file
+    bool load_event(const int32_t run_id_, const int32_t event_id_, datatools::things & event_record_);
+
+    /// Load the first event record at or after a time (s). Return false if there is none
+    bool load_at_time(const double time_, datatools::things & event_record_);
+
+  private:
+
+    void _rewind_();
+
+    std::string _filename_;                              ///< UDD file name
+    udd_index _index_;                                   ///< Index
+    std::unique_ptr<brio::reader> _brio_reader_;         ///< Reader of brio files
+    std::unique_ptr<datatools::data_reader> _reader_;    ///< Reader of the other formats
+    uint64_t _next_rank_ = 0;                            ///< Rank of the next event record of the stream
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_UDD_INDEX_H
@@ -0,0 +1,280 @@
+// This project:
+#include <snredbridge/udd_writer.h>
+
+// Standard library:
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// - POSIX:
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+// This project:
+#include <snredbridge/file_utils.h>
+#include <snredbridge/parallel_gzip.h>
+
+namespace snredbridge {
+
+  namespace {
+
+    /// Number of records between two checks of the output file size
+    const std::size_t SIZE_CHECK_PERIOD = 16;
+
+    /// File descriptor closed at the end of its scope
+    class scoped_fd
+    {
+    public:
+
+      explicit scoped_fd(const int fd_) : _fd_(fd_) {}
+
+      ~scoped_fd()
+      {
+        if (_fd_ >= 0) ::close(_fd_);
+      }
+
+      scoped_fd(const scoped_fd &) = delete;
+
+      scoped_fd & operator=(const scoped_fd &) = delete;
+
+      int get() const
+      {
+        return _fd_;
+      }
+
+    private:
+
+      int _fd_; ///< File descriptor (negative: none)
+
+    };
+
+  } // end of anonymous namespace
+
+  udd_writer::udd_writer()
+  {
+  }
+
+  udd_writer::~udd_writer()
+  {
+    try {
+      if (is_initialized()) terminate();
+    }
+    catch (...) {
+      // No exception from a destructor
+    }
+  }
+
+  void udd_writer::initialize(const config_type & config_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "UDD writer is already initialized!");
+    DT_THROW_IF(config_.filename.empty(), std::logic_error, "Missing UDD output file name!");
+    _config_ = config_;
+    _filenames_.clear();
+    _total_records_ = 0;
+    _open_next_file_();
+  }
+
+  bool udd_writer::is_initialized() const
+  {
+    return _module_ != nullptr;
+  }
+
+  bool udd_writer::is_rolling() const
+  {
+    return _config_.max_events_per_file > 0 || _config_.max_bytes_per_file > 0;
+  }
+
+  void udd_writer::process(datatools::things & event_record_)
+  {
+    DT_THROW_IF(!is_initialized(), std::logic_error, "UDD writer is not initialized!");
+    if (_roll_pending_) {
+      _close_file_();
+      _open_next_file_();
+    }
+    const dpp::base_module::process_status status = _module_->process(event_record_);
+    DT_THROW_IF(status != dpp::base_module::PROCESS_OK, std::runtime_error,
+                "Cannot store event record in '" << _filenames_.back() << "' (status=" << status << ")!");
+    if (!_index_filename_.empty()) _index_.add(udd_index::make_entry(event_record_, _file_records_));
+    _file_records_++;
+    _total_records_++;
+    if (_config_.max_events_per_file > 0 && _file_records_ >= _config_.max_events_per_file) {
+      _roll_pending_ = true;
+    }
+    if (_config_.max_bytes_per_file > 0
+        && _file_records_ % SIZE_CHECK_PERIOD == 0
+        && file_size(_filenames_.back()) >= static_cast<int64_t>(_config_.max_bytes_per_file)) {
+      _roll_pending_ = true;
+    }
+  }
+
+  void udd_writer::terminate()
+  {
+    if (is_initialized()) _close_file_();
+  }
+
+  const std::vector<std::string> & udd_writer::get_filenames() const
+  {
+    return _filenames_;
+  }
+
+  std::size_t udd_writer::get_number_of_records_in_file() const
+  {
+    return _file_records_;
+  }
+
+  std::size_t udd_writer::get_number_of_records() const
+  {
+    return _total_records_;
+  }
+
+  std::string udd_writer::make_rolling_filename(const std::string & filename_,
+                                                const std::size_t file_index_)
+  {
+    std::string stem;
+    std::string extension;
+    split_extension(filename_, stem, extension);
+    char index[16];
+    std::snprintf(index, sizeof(index), "_%04zu", file_index_);
+    return stem + index + extension;
+  }
+
+  std::string udd_writer::make_codec_filename(const std::string & filename_,
+                                              const std::string & codec_)
+  {
+    std::string stem;
+    std::string extension;
+    split_extension(filename_, stem, extension);
+    if (codec_ == "brio") return stem + ".brio";
+    if (codec_ == "none") return stem + ".data";
+    if (codec_ == "gzip") return stem + ".data.gz";
+    if (codec_ == "bzip2") return stem + ".data.bz2";
+    DT_THROW(std::logic_error, "Unsupported output codec '" << codec_ << "' (brio, none, gzip or bzip2)!");
+  }
+
+  bool udd_writer::_use_parallel_gzip_() const
+  {
+    const std::string & filename = _config_.filename;
+    const bool is_gzip = filename.size() > 3 && filename.compare(filename.size() - 3, 3, ".gz") == 0;
+    return is_gzip && (_config_.compression_level >= 0 || _config_.compression_threads > 1);
+  }
+
+  void udd_writer::_pump_loop_()
+  {
+    try {
+      // Blocks until the output module opens the pipe
+      const scoped_fd fd(::open(_fifo_.c_str(), O_RDONLY));
+      DT_THROW_IF(fd.get() < 0, std::runtime_error, "Cannot open named pipe '" << _fifo_ << "': " << std::strerror(errno));
+      std::vector<char> buffer(1024 * 1024);
+      while (true) {
+        const ssize_t n = ::read(fd.get(), buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        // After a compressor error, the pipe is still drained so that the
+        // output module is never blocked: the error is reported at close
+        if (_pump_error_) continue;
+        try {
+          _gzip_->write(buffer.data(), static_cast<std::size_t>(n));
+        }
+        catch (...) {
+          _pump_error_ = std::current_exception();
+        }
+      }
+    }
+    catch (...) {
+      _pump_error_ = std::current_exception();
+    }
+    _pump_done_ = true;
+  }
+
+  void udd_writer::_open_next_file_()
+  {
+    const std::string filename = is_rolling()
+      ? make_rolling_filename(_config_.filename, _filenames_.size())
+      : _config_.filename;
+    std::string module_filename = filename;
+    if (_use_parallel_gzip_()) {
+      // The output module writes the uncompressed stream to a named pipe
+      // (with the extension of the uncompressed format), which is read and
+      // compressed by the pump thread
+      std::string stem;
+      std::string extension;
+      split_extension(filename, stem, extension);
+      _fifo_ = stem + ".fifo-" + std::to_string(::getpid()) + extension.substr(0, extension.size() - 3);
+      ::unlink(_fifo_.c_str());
+      DT_THROW_IF(::mkfifo(_fifo_.c_str(), 0600) != 0, std::runtime_error,
+                  "Cannot create named pipe '" << _fifo_ << "': " << std::strerror(errno));
+      const int level = (_config_.compression_level >= 0) ? _config_.compression_level : 6;
+      _gzip_.reset(new parallel_gzip_writer(filename, level, _config_.compression_threads));
+      _pump_error_ = nullptr;
+      _pump_done_ = false;
+      _pump_thread_ = std::thread(&udd_writer::_pump_loop_, this);
+      module_filename = _fifo_;
+    }
+    _module_.reset(new dpp::output_module);
+    _module_->set_logging_priority(datatools::logger::PRIO_FATAL);
+    _module_->set_name("Writer output module");
+    _module_->set_description("Output module for the datatools::things event_record");
+    _module_->set_preserve_existing_output(false); // Allowed to erase existing output file
+    _module_->set_single_output_file(module_filename);
+    try {
+      _module_->initialize_simple();
+    }
+    catch (...) {
+      // Stop the pump thread before reporting the error
+      try {
+        _close_file_();
+      }
+      catch (...) {
+      }
+      throw;
+    }
+    _filenames_.push_back(filename);
+    _index_ = udd_index();
+    if (_config_.write_index) _index_filename_ = udd_index::default_filename(filename);
+    _file_records_ = 0;
+    _roll_pending_ = false;
+  }
+
+  void udd_writer::_close_file_()
+  {
+    if (_module_) {
+      if (_module_->is_initialized()) _module_->reset();
+      _module_.reset();
+    }
+    if (_pump_thread_.joinable()) {
+      // Make sure the pump thread is not waiting for a writer that never
+      // came: open and close the pipe until it is done. Opening fails
+      // (ENXIO) as long as the pump thread has not opened its side
+      while (!_pump_done_) {
+        const int fd = ::open(_fifo_.c_str(), O_WRONLY | O_NONBLOCK);
+        if (fd >= 0) {
+          ::close(fd);
+          break;
+        }
+        if (errno != ENXIO && errno != EINTR) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      _pump_thread_.join();
+      ::unlink(_fifo_.c_str());
+      _fifo_.clear();
+      std::unique_ptr<parallel_gzip_writer> gzip = std::move(_gzip_);
+      if (_pump_error_) std::rethrow_exception(_pump_error_);
+      gzip->close();
+    }
+    if (!_index_filename_.empty()) {
+      // Written last, so that an index never describes a partial file
+      const std::string index_filename = _index_filename_;
+      _index_filename_.clear();
+      _index_.store(index_filename);
+    }
+  }
+
+} // end of namespace snredbridge
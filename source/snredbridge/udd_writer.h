@@ -0,0 +1,133 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/udd_writer.h
+///
+/// Writer of UDD event records with optional output file rollover and
+/// parallel gzip compression.
+
+#ifndef SNREDBRIDGE_UDD_WRITER_H
+#define SNREDBRIDGE_UDD_WRITER_H
+
+// Standard library:
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/things.h>
+#include <bayeux/dpp/output_module.h>
+
+// This project:
+#include <snredbridge/udd_index.h>
+
+namespace snredbridge {
+
+  class parallel_gzip_writer;
+
+  /// \brief Store event records in one or several (rolling) output files
+  ///
+  /// Without limits, all the event records go to the configured file. With
+  /// a limit on the number of events or on the size per file, the records
+  /// go to "<stem>_0000<ext>", "<stem>_0001<ext>"... where the stem and the
+  /// extension come from the configured file name. The size limit is
+  /// checked against the file size on disk every few records (one stat per
+  /// check), so a file can be slightly larger than the limit because of
+  /// these records and of output buffering.
+  ///
+  /// The format and compression follow the file extension (".brio",
+  /// ".data", ".data.gz", ".data.bz2"...) as for dpp::output_module. For
+  /// gzip outputs with a compression level or several compression threads,
+  /// the output module writes the uncompressed stream to a named pipe and
+  /// the data are compressed by a parallel_gzip_writer.
+  ///
+  /// Optionally, an index of the event records (see udd_index) is written
+  /// next to each output file ("<file>.idx") when it is closed.
+  class udd_writer
+  {
+  public:
+
+    /// Configuration
+    struct config_type
+    {
+      std::string filename;                 ///< Output file name
+      std::size_t max_events_per_file = 0;  ///< Max number of event records per file (0: no limit)
+      uint64_t max_bytes_per_file = 0;      ///< Approximate max size per file in bytes (0: no limit)
+      int compression_level = -1;           ///< Gzip level (0-9) of ".gz" outputs (-1: output module default)
+      std::size_t compression_threads = 1;  ///< Number of gzip compression threads of ".gz" outputs
+      bool write_index = false;             ///< Write the index of each output file
+    };
+
+    /// Default constructor
+    udd_writer();
+
+    /// Destructor
+    ~udd_writer();
+
+    /// Initialize and open the first output file
+    void initialize(const config_type & config_);
+
+    /// Check if the writer is initialized
+    bool is_initialized() const;
+
+    /// Check if the output is split into several files
+    bool is_rolling() const;
+
+    /// Store an event record
+    void process(datatools::things & event_record_);
+
+    /// Close the current output file
+    void terminate();
+
+    /// Return the names of the output files opened so far
+    const std::vector<std::string> & get_filenames() const;
+
+    /// Return the number of event records stored in the current output file
+    std::size_t get_number_of_records_in_file() const;
+
+    /// Return the total number of stored event records
+    std::size_t get_number_of_records() const;
+
+    /// Build the name of the output file with a given rank in a rolling output
+    static std::string make_rolling_filename(const std::string & filename_,
+                                             const std::size_t file_index_);
+
+    /// Replace the extension of an output file name according to a codec
+    ///
+    /// Supported codecs: "brio" (uncompressed brio), "none" (uncompressed
+    /// ".data"), "gzip" (".data.gz") and "bzip2" (".data.bz2").
+    static std::string make_codec_filename(const std::string & filename_,
+                                           const std::string & codec_);
+
+  private:
+
+    void _open_next_file_();
+
+    void _close_file_();
+
+    bool _use_parallel_gzip_() const;
+
+    void _pump_loop_();
+
+    config_type _config_;                         ///< Configuration
+    std::unique_ptr<dpp::output_module> _module_; ///< Output module for the current file
+    std::vector<std::string> _filenames_;         ///< Names of the output files
+    std::size_t _file_records_ = 0;               ///< Number of records in the current file
+    std::size_t _total_records_ = 0;             ///< Total number of stored records
+    bool _roll_pending_ = false;                  ///< The current file is full
+    std::string _fifo_;                           ///< Named pipe between the output module and the compressor
+    std::unique_ptr<parallel_gzip_writer> _gzip_; ///< Parallel gzip compressor of the current file
+    std::thread _pump_thread_;                    ///< Thread feeding the compressor from the named pipe
+    std::exception_ptr _pump_error_;              ///< Error of the pump thread
+    std::atomic<bool> _pump_done_{false};         ///< The pump thread is done
+    udd_index _index_;                            ///< Index of the current file
+    std::string _index_filename_;                 ///< Index file name of the current file (empty: no index)
+
+  };
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_UDD_WRITER_H
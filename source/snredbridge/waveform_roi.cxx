@@ -0,0 +1,114 @@
+// This project:
+#include <snredbridge/waveform_roi.h>
+
+// Standard library:
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/logger.h>
+
+namespace snredbridge {
+
+  const char * const waveform_offset_key = "waveform.offset";
+  const char * const waveform_full_length_key = "waveform.full_length";
+  const char * const waveform_delta_key = "waveform.delta";
+
+  void parse_waveform_roi(const std::string & text_, waveform_roi_config & config_)
+  {
+    int pre_samples = 0;
+    int post_samples = 0;
+    char trailing = 0;
+    DT_THROW_IF(std::sscanf(text_.c_str(), "%d:%d%c", &pre_samples, &post_samples, &trailing) != 2
+                || pre_samples < 0 || post_samples < 0,
+                std::logic_error, "Invalid waveform ROI '" << text_ << "' (expected PRE:POST numbers of samples)!");
+    config_.roi = true;
+    config_.pre_samples = pre_samples;
+    config_.post_samples = post_samples;
+  }
+
+  waveform_window compute_waveform_window(const std::size_t nsamples_,
+                                          const int32_t peak_cell_,
+                                          const int32_t rising_cell_,
+                                          const int32_t falling_cell_,
+                                          const waveform_roi_config & config_)
+  {
+    waveform_window window;
+    window.length = nsamples_;
+    if (!config_.roi || nsamples_ == 0) return window;
+    const int64_t nsamples = static_cast<int64_t>(nsamples_);
+    const int64_t fraction = std::max<int32_t>(config_.cell_fraction, 1);
+    // Pulse cells, in samples, ignoring the ones out of the waveform
+    int64_t first = nsamples;
+    int64_t last = -1;
+    for (const int64_t cell : {static_cast<int64_t>(peak_cell_),
+                               static_cast<int64_t>(rising_cell_) / fraction,
+                               static_cast<int64_t>(falling_cell_) / fraction}) {
+      if (cell < 0 || cell >= nsamples) continue;
+      first = std::min(first, cell);
+      last = std::max(last, cell);
+    }
+    if (last < 0) return window;
+    const int64_t begin = std::max<int64_t>(first - std::max<int32_t>(config_.pre_samples, 0), 0);
+    const int64_t end = std::min<int64_t>(last + std::max<int32_t>(config_.post_samples, 0) + 1, nsamples);
+    window.offset = static_cast<std::size_t>(begin);
+    window.length = static_cast<std::size_t>(end - begin);
+    return window;
+  }
+
+  std::vector<int16_t> encode_waveform(const std::vector<int16_t> & waveform_,
+                                       const waveform_window & window_,
+                                       const bool delta_,
+                                       datatools::properties & auxiliaries_)
+  {
+    const auto first = waveform_.begin() + static_cast<std::ptrdiff_t>(window_.offset);
+    std::vector<int16_t> stored(first, first + static_cast<std::ptrdiff_t>(window_.length));
+    if (delta_) {
+      // From the end, so that each difference uses the original previous sample
+      for (std::size_t isample = stored.size(); isample-- > 1;) {
+        stored[isample] = static_cast<int16_t>(stored[isample] - stored[isample - 1]);
+      }
+    }
+    auxiliaries_.store_integer(waveform_offset_key, static_cast<int>(window_.offset));
+    auxiliaries_.store_integer(waveform_full_length_key, static_cast<int>(waveform_.size()));
+    if (delta_) auxiliaries_.store_flag(waveform_delta_key);
+    return stored;
+  }
+
+  waveform_window decode_waveform(const std::vector<int16_t> & stored_,
+                                  const datatools::properties & auxiliaries_,
+                                  std::vector<int16_t> & samples_,
+                                  std::size_t & full_length_)
+  {
+    waveform_window window;
+    window.length = stored_.size();
+    samples_ = stored_;
+    full_length_ = stored_.size();
+    if (!auxiliaries_.has_key(waveform_offset_key)) return window;
+    window.offset = static_cast<std::size_t>(auxiliaries_.fetch_integer(waveform_offset_key));
+    full_length_ = static_cast<std::size_t>(auxiliaries_.fetch_integer(waveform_full_length_key));
+    if (auxiliaries_.has_flag(waveform_delta_key)) {
+      for (std::size_t isample = 1; isample < samples_.size(); isample++) {
+        samples_[isample] = static_cast<int16_t>(samples_[isample] + samples_[isample - 1]);
+      }
+    }
+    return window;
+  }
+
+  bool is_stored_waveform_of(const std::vector<int16_t> & stored_,
+                             const datatools::properties & auxiliaries_,
+                             const std::vector<int16_t> & red_waveform_)
+  {
+    if (!auxiliaries_.has_key(waveform_offset_key)) return stored_ == red_waveform_;
+    std::vector<int16_t> samples;
+    std::size_t full_length = 0;
+    const waveform_window window = decode_waveform(stored_, auxiliaries_, samples, full_length);
+    if (full_length != red_waveform_.size()) return false;
+    if (window.offset + window.length > red_waveform_.size()) return false;
+    return std::equal(samples.begin(), samples.end(),
+                      red_waveform_.begin() + static_cast<std::ptrdiff_t>(window.offset));
+  }
+
+} // end of namespace snredbridge
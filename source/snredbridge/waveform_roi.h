@@ -0,0 +1,104 @@
+// -*- mode: c++ ; -*-
+/// \file snredbridge/waveform_roi.h
+///
+/// Storage of the calorimeter waveforms restricted to a region of interest
+/// around the firmware pulse measurements, with optional delta encoding.
+
+#ifndef SNREDBRIDGE_WAVEFORM_ROI_H
+#define SNREDBRIDGE_WAVEFORM_ROI_H
+
+// Standard library:
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Third party:
+// - Bayeux:
+#include <bayeux/datatools/properties.h>
+
+namespace snredbridge {
+
+  /// \brief Configuration of the stored part of the calorimeter waveforms
+  ///
+  /// In ROI mode, only the samples from pre_samples before the rising cell
+  /// (or the peak cell) to post_samples after the falling cell (or the peak
+  /// cell) are kept. The firmware rising and falling cells are fixed-point
+  /// positions in 1/cell_fraction of a sample. With delta encoding, each
+  /// stored sample but the first is replaced by its difference with the
+  /// previous one, which compresses better.
+  struct waveform_roi_config
+  {
+    bool roi = false;              ///< Only keep a window around the pulse
+    int32_t pre_samples = 32;      ///< Number of samples kept before the rising cell
+    int32_t post_samples = 96;     ///< Number of samples kept after the falling cell
+    int32_t cell_fraction = 256;   ///< Fixed-point scale of the rising/falling cells
+    bool delta = false;            ///< Delta-encode the stored samples
+
+    /// Check if the stored waveforms differ from the RED ones
+    bool is_active() const { return roi || delta; }
+  };
+
+  /// \brief Stored window [offset, offset + length) of a waveform
+  struct waveform_window
+  {
+    std::size_t offset = 0;  ///< Index of the first stored sample
+    std::size_t length = 0;  ///< Number of stored samples
+  };
+
+  // Auxiliary properties of the calorimeter hits with a waveform stored in
+  // ROI or delta mode:
+  extern const char * const waveform_offset_key;      ///< Index of the first stored sample (integer)
+  extern const char * const waveform_full_length_key; ///< Number of samples of the RED waveform (integer)
+  extern const char * const waveform_delta_key;       ///< Delta-encoded samples (flag)
+
+  /// Enable the ROI mode with the window given as "PRE:POST" numbers of samples
+  void parse_waveform_roi(const std::string & text_, waveform_roi_config & config_);
+
+  /// Return the window of a waveform of nsamples_ samples to store
+  ///
+  /// The cells out of the waveform are ignored. If no cell is usable or
+  /// the ROI mode is off, the whole waveform is stored.
+  waveform_window compute_waveform_window(const std::size_t nsamples_,
+                                          const int32_t peak_cell_,
+                                          const int32_t rising_cell_,
+                                          const int32_t falling_cell_,
+                                          const waveform_roi_config & config_);
+
+  /// Return the window of the waveform of a (RED or UDD) calorimeter hit to store
+  template <typename CaloHit>
+  waveform_window compute_waveform_window(const std::size_t nsamples_,
+                                          const CaloHit & hit_,
+                                          const waveform_roi_config & config_)
+  {
+    return compute_waveform_window(nsamples_,
+                                   hit_.get_fwmeas_peak_cell(),
+                                   hit_.get_fwmeas_rising_cell(),
+                                   hit_.get_fwmeas_falling_cell(),
+                                   config_);
+  }
+
+  /// Build the stored samples of a window of a RED waveform, and describe them in auxiliaries_
+  std::vector<int16_t> encode_waveform(const std::vector<int16_t> & waveform_,
+                                       const waveform_window & window_,
+                                       const bool delta_,
+                                       datatools::properties & auxiliaries_);
+
+  /// Decode the stored samples of a waveform, as described by the auxiliaries
+  ///
+  /// Return the window of the RED waveform they cover and set full_length_
+  /// to the number of samples of the RED waveform. Waveforms stored without
+  /// ROI nor delta encoding are returned unchanged.
+  waveform_window decode_waveform(const std::vector<int16_t> & stored_,
+                                  const datatools::properties & auxiliaries_,
+                                  std::vector<int16_t> & samples_,
+                                  std::size_t & full_length_);
+
+  /// Check if a stored waveform holds the samples of a RED waveform in its window
+  bool is_stored_waveform_of(const std::vector<int16_t> & stored_,
+                             const datatools::properties & auxiliaries_,
+                             const std::vector<int16_t> & red_waveform_);
+
+} // end of namespace snredbridge
+
+#endif // SNREDBRIDGE_WAVEFORM_ROI_H